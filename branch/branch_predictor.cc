@@ -30,3 +30,9 @@ void O3_CPU::last_branch_result(uint64_t ip, uint8_t taken)
     else if ((taken == 0) && (bimodal_table[cpu][hash] > 0))
         bimodal_table[cpu][hash]--;
 }
+
+void O3_CPU::checkpoint_branch_predictor(CHECKPOINT_FILE &checkpoint)
+{
+    checkpoint.section("bimodal");
+    checkpoint.value(bimodal_table[cpu]);
+}
@@ -1,6 +1,7 @@
 #ifndef BAKSHALIPOUR_FRAMEWORK
 #define BAKSHALIPOUR_FRAMEWORK
 
+#include <assert.h>
 #include <vector>
 #include <string>
 #include <iomanip>
@@ -115,6 +116,11 @@ private:
    vector<vector<string>> cells;
 };
 
+/**
+* A set-associative table stored flat: the entries of a set are adjacent, and every set keeps its
+* tags in a compact array next to a bit mask of its valid ways, so a lookup compares a few words
+* instead of touching every entry or a hash map. Supports up to 64 ways.
+*/
 template <class T> class SetAssociativeCache {
 public:
    class Entry {
@@ -127,12 +133,12 @@ public:
    };
 
    SetAssociativeCache(int size, int num_ways, int debug_level = 0)
-   : size(size), num_ways(num_ways), num_sets(size / num_ways), entries(num_sets, vector<Entry>(num_ways)),
-   cams(num_sets), debug_level(debug_level) {
+   : size(size), num_ways(num_ways), num_sets(size / num_ways), entries(num_sets * num_ways),
+   tags(num_sets * num_ways, 0), valid_ways(num_sets, 0), debug_level(debug_level) {
       // assert(size % num_ways == 0);
-      for (int i = 0; i < num_sets; i += 1)
-      for (int j = 0; j < num_ways; j += 1)
-      entries[i][j].valid = false;
+      assert(num_ways <= 64);
+      for (int i = 0; i < num_sets * num_ways; i += 1)
+      entries[i].valid = false;
       /* calculate `index_len` (number of bits required to store the index) */
       for (int max_index = num_sets - 1; max_index > 0; max_index >>= 1)
       this->index_len += 1;
@@ -143,14 +149,13 @@ public:
    * @return A pointer to the invalidated entry
    */
    Entry *erase(uint64_t key) {
-      Entry *entry = this->find(key);
+      int way = this->find_way(key);
+      if (way == -1)
+      return nullptr;
       uint64_t index = key % this->num_sets;
-      uint64_t tag = key / this->num_sets;
-      auto &cam = cams[index];
-      int num_erased = cam.erase(tag);
-      if (entry)
+      Entry *entry = &this->get_set(index)[way];
       entry->valid = false;
-      // assert(entry ? num_erased == 1 : num_erased == 0);
+      this->valid_ways[index] &= ~(1ULL << way);
       return entry;
    }
 
@@ -166,38 +171,27 @@ public:
       }
       uint64_t index = key % this->num_sets;
       uint64_t tag = key / this->num_sets;
-      vector<Entry> &set = this->entries[index];
-      int victim_way = -1;
-      for (int i = 0; i < this->num_ways; i += 1)
-      if (!set[i].valid) {
-         victim_way = i;
-         break;
-      }
-      if (victim_way == -1) {
-         victim_way = this->select_victim(index);
-      }
-      Entry &victim = set[victim_way];
+      uint64_t invalid_ways = ~this->valid_ways[index];
+      if (this->num_ways < 64)
+      invalid_ways &= (1ULL << this->num_ways) - 1;
+      int victim_way;
+      if (invalid_ways)
+      victim_way = __builtin_ctzll(invalid_ways);
+      else
+      victim_way = this->select_victim(index);
+      Entry &victim = this->get_set(index)[victim_way];
       Entry old_entry = victim;
       victim = {key, index, tag, true, data};
-      auto &cam = cams[index];
-      if (old_entry.valid) {
-         int num_erased = cam.erase(old_entry.tag);
-         // assert(num_erased == 1);
-      }
-      cam[tag] = victim_way;
+      this->tags[index * this->num_ways + victim_way] = tag;
+      this->valid_ways[index] |= 1ULL << victim_way;
       return old_entry;
    }
 
    Entry *find(uint64_t key) {
-      uint64_t index = key % this->num_sets;
-      uint64_t tag = key / this->num_sets;
-      auto &cam = cams[index];
-      if (cam.find(tag) == cam.end())
+      int way = this->find_way(key);
+      if (way == -1)
       return nullptr;
-      int way = cam[tag];
-      Entry &entry = this->entries[index][way];
-      // assert(entry.tag == tag && entry.valid);
-      return &entry;
+      return &this->get_set(key % this->num_sets)[way];
    }
 
    /**
@@ -231,12 +225,31 @@ protected:
       return rand() % this->num_ways;
    }
 
+   /**
+   * @return The way holding the given key or -1 if it is not in the cache
+   */
+   int find_way(uint64_t key) {
+      uint64_t index = key % this->num_sets;
+      uint64_t tag = key / this->num_sets;
+      const uint64_t *set_tags = &this->tags[index * this->num_ways];
+      for (uint64_t ways = this->valid_ways[index]; ways; ways &= ways - 1) {
+         int way = __builtin_ctzll(ways);
+         if (set_tags[way] == tag)
+         return way;
+      }
+      return -1;
+   }
+
+   /**
+   * @return The first of the `num_ways` entries of a set
+   */
+   Entry *get_set(uint64_t index) { return &this->entries[index * this->num_ways]; }
+
    vector<Entry> get_valid_entries() {
       vector<Entry> valid_entries;
-      for (int i = 0; i < num_sets; i += 1)
-      for (int j = 0; j < num_ways; j += 1)
-      if (entries[i][j].valid)
-      valid_entries.push_back(entries[i][j]);
+      for (int i = 0; i < num_sets * num_ways; i += 1)
+      if (entries[i].valid)
+      valid_entries.push_back(entries[i]);
       return valid_entries;
    }
 
@@ -244,8 +257,9 @@ protected:
    int num_ways;
    int num_sets;
    int index_len = 0; /* in bits */
-   vector<vector<Entry>> entries;
-   vector<unordered_map<uint64_t, int>> cams;
+   vector<Entry> entries;
+   vector<uint64_t> tags;       /* tags of all entries, in the same order as `entries` */
+   vector<uint64_t> valid_ways; /* one bit per way of every set */
    int debug_level = 0;
 };
 
@@ -254,7 +268,7 @@ template <class T> class LRUSetAssociativeCache : public SetAssociativeCache<T>
 
 public:
    LRUSetAssociativeCache(int size, int num_ways, int debug_level = 0)
-   : Super(size, num_ways, debug_level), lru(this->num_sets, vector<uint64_t>(num_ways)) {}
+   : Super(size, num_ways, debug_level), lru(this->num_sets * num_ways) {}
 
    void set_mru(uint64_t key) { *this->get_lru(key) = this->t++; }
 
@@ -263,19 +277,18 @@ public:
 protected:
    /* @override */
    int select_victim(uint64_t index) {
-      vector<uint64_t> &lru_set = this->lru[index];
-      return min_element(lru_set.begin(), lru_set.end()) - lru_set.begin();
+      uint64_t *lru_set = &this->lru[index * this->num_ways];
+      return min_element(lru_set, lru_set + this->num_ways) - lru_set;
    }
 
    uint64_t *get_lru(uint64_t key) {
       uint64_t index = key % this->num_sets;
-      uint64_t tag = key / this->num_sets;
-      // assert(this->cams[index].count(tag) == 1);
-      int way = this->cams[index][tag];
-      return &this->lru[index][way];
+      int way = this->find_way(key);
+      // assert(way != -1);
+      return &this->lru[index * this->num_ways + way];
    }
 
-   vector<vector<uint64_t>> lru;
+   vector<uint64_t> lru;
    uint64_t t = 1;
 };
 
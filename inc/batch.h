@@ -0,0 +1,30 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "trace_reader.h"
+
+// BATCH MODE
+// --batch_jobs=FILE runs many simulations from a single invocation. Every line of the file is a
+// job, "<output file> <knobs> -traces <traces>", and lines starting with # are comments.
+// Every job runs in a process of its own forked from the batch, so the jobs share nothing but the
+// trace cache: before forking, the beginning of every trace is decompressed once into memory that
+// the jobs read copy-on-write. The knobs given to the batch itself are the defaults of every job.
+#define BATCH_CACHE_SLACK (2*TRACE_RING_SIZE*TRACE_BATCH_SIZE) // instructions decoded ahead of the core
+
+class BATCH_JOB {
+  public:
+    std::string output;
+    std::vector<std::string> args;
+};
+
+std::vector<BATCH_JOB> read_batch_jobs(const char *job_file);
+
+// runs the jobs of --batch_jobs, --batch_threads at a time. Returns only in the job processes,
+// with argc/argv replaced by the arguments of the job and the output going to its file.
+// The batch process itself exits once every job finished.
+void run_batch(int &argc, char **&argv);
+
+#endif
@@ -5,6 +5,7 @@
 /* Bingo [https://mshakerinava.github.io/papers/bingo-hpca19.pdf] */
 
 #include <vector>
+#include <bitset>
 #include <unordered_map>
 #include <sstream>
 #include <algorithm>
@@ -14,6 +15,13 @@
 
 using namespace std;
 
+/**
+* Footprints of spatial regions are bit vectors of up to 64 blocks, i.e. regions of up to 4KB.
+* Bits at and above `pattern_len` are always zero.
+*/
+#define BINGO_MAX_PATTERN_LEN 64
+typedef bitset<BINGO_MAX_PATTERN_LEN> BingoPattern;
+
 class FilterTableData {
 public:
    uint64_t pc;
@@ -95,11 +103,25 @@ template <class T> string pattern_to_string(const vector<T> &pattern) {
    return oss.str();
 }
 
+template <class T> string pattern_to_string(const T *pattern, int len) {
+   ostringstream oss;
+   for (int i = 0; i < len; i += 1)
+   oss << int(pattern[i]);
+   return oss.str();
+}
+
+inline string pattern_to_string(const BingoPattern &pattern, int len) {
+   ostringstream oss;
+   for (int i = 0; i < len; i += 1)
+   oss << int(pattern[i]);
+   return oss.str();
+}
+
 class AccumulationTableData {
 public:
    uint64_t pc;
    int offset;
-   vector<bool> pattern;
+   BingoPattern pattern;
 };
 
 class AccumulationTable : public LRUSetAssociativeCache<AccumulationTableData> {
@@ -143,7 +165,7 @@ public:
       << ", offset=" << dec << offset << dec << endl;
       uint64_t key = this->build_key(region_number);
       // assert(!Super::find(key));
-      vector<bool> pattern(this->pattern_len, false);
+      BingoPattern pattern;
       pattern[offset] = true;
       Entry old_entry = Super::insert(key, {pc, offset, pattern});
       Super::set_mru(key);
@@ -167,7 +189,7 @@ private:
       table.set_cell(row, 0, key);
       table.set_cell(row, 1, entry.data.pc);
       table.set_cell(row, 2, entry.data.offset);
-      table.set_cell(row, 3, pattern_to_string(entry.data.pattern));
+      table.set_cell(row, 3, pattern_to_string(entry.data.pattern, this->pattern_len));
    }
 
    uint64_t build_key(uint64_t region_number) {
@@ -191,18 +213,20 @@ private:
 */
 enum Event { PC_ADDRESS = 0, PC_OFFSET = 1, MISS = 2 };
 
-template <class T> vector<T> my_rotate(const vector<T> &x, int n) {
-   vector<T> y;
-   int len = x.size();
-   n = n % len;
-   for (int i = 0; i < len; i += 1)
-   y.push_back(x[(i - n + len) % len]);
-   return y;
+/**
+* Rotates the first `len` bits of a pattern by `n` positions, so that bit `i` moves to bit `i + n` (mod `len`).
+*/
+inline BingoPattern rotate_pattern(const BingoPattern &x, int n, int len) {
+   n = (n % len + len) % len;
+   BingoPattern mask;
+   mask.set();
+   mask >>= BINGO_MAX_PATTERN_LEN - len;
+   return ((x << n) | (x >> (len - n))) & mask;
 }
 
 class PatternHistoryTableData {
 public:
-   vector<bool> pattern;
+   BingoPattern pattern;
 };
 
 class PatternHistoryTable : public LRUSetAssociativeCache<PatternHistoryTableData> {
@@ -225,39 +249,37 @@ public:
    }
 
    /* NOTE: In BINGO, address is actually block number. */
-   void insert(uint64_t pc, uint64_t address, vector<bool> pattern) {
+   void insert(uint64_t pc, uint64_t address, const BingoPattern &pattern) {
       if (this->debug_level >= 2)
       cerr << "PatternHistoryTable::insert(pc=0x" << hex << pc << ", address=0x" << address
-      << ", pattern=" << pattern_to_string(pattern) << ")" << dec << endl;
-      // assert((int)pattern.size() == this->pattern_len);
+      << ", pattern=" << pattern_to_string(pattern, this->pattern_len) << ")" << dec << endl;
       int offset = address % this->pattern_len;
-      pattern = my_rotate(pattern, -offset);
       uint64_t key = this->build_key(pc, address);
-      Super::insert(key, {pattern});
+      Super::insert(key, {rotate_pattern(pattern, -offset, this->pattern_len)});
       Super::set_mru(key);
    }
 
    /**
    * First searches for a PC+Address match. If no match is found, returns all PC+Offset matches.
-   * @return All un-rotated patterns if matches were found, returns an empty vector otherwise
+   * @param matches Set to all un-rotated patterns if matches were found, emptied otherwise
    */
-   vector<vector<bool>> find(uint64_t pc, uint64_t address) {
+   void find(uint64_t pc, uint64_t address, vector<BingoPattern> &matches) {
       if (this->debug_level >= 2)
       cerr << "PatternHistoryTable::find(pc=0x" << hex << pc << ", address=0x" << address << ")" << dec << endl;
       uint64_t key = this->build_key(pc, address);
       uint64_t index = key % this->num_sets;
       uint64_t tag = key / this->num_sets;
-      auto &set = this->entries[index];
+      Entry *set = this->get_set(index);
       uint64_t min_tag_mask = (1 << (this->pc_width + this->min_addr_width - this->index_len)) - 1;
       uint64_t max_tag_mask = (1 << (this->pc_width + this->max_addr_width - this->index_len)) - 1;
-      vector<vector<bool>> matches;
+      matches.clear();
       this->last_event = MISS;
       for (int i = 0; i < this->num_ways; i += 1) {
          if (!set[i].valid)
          continue;
          bool min_match = ((set[i].tag & min_tag_mask) == (tag & min_tag_mask));
          bool max_match = ((set[i].tag & max_tag_mask) == (tag & max_tag_mask));
-         vector<bool> &cur_pattern = set[i].data.pattern;
+         const BingoPattern &cur_pattern = set[i].data.pattern;
          if (max_match) {
             this->last_event = PC_ADDRESS;
             Super::set_mru(set[i].key);
@@ -272,8 +294,7 @@ public:
       }
       int offset = address % this->pattern_len;
       for (int i = 0; i < (int)matches.size(); i += 1)
-      matches[i] = my_rotate(matches[i], +offset);
-      return matches;
+      matches[i] = rotate_pattern(matches[i], +offset, this->pattern_len);
    }
 
    Event get_last_event() { return this->last_event; }
@@ -301,7 +322,7 @@ private:
       table.set_cell(row, 0, pc);
       table.set_cell(row, 1, offset);
       table.set_cell(row, 2, address);
-      table.set_cell(row, 3, pattern_to_string(entry.data.pattern));
+      table.set_cell(row, 3, pattern_to_string(entry.data.pattern, this->pattern_len));
    }
 
    uint64_t build_key(uint64_t pc, uint64_t address) {
@@ -331,7 +352,7 @@ private:
 class PrefetchStreamerData {
 public:
    /* contains the prefetch fill level for each block of spatial region */
-   vector<int> pattern;
+   int pattern[BINGO_MAX_PATTERN_LEN];
 };
 
 class PrefetchStreamer : public LRUSetAssociativeCache<PrefetchStreamerData> {
@@ -345,12 +366,14 @@ public:
       << ", debug_level=" << debug_level << ", num_ways=" << num_ways << ")" << dec << endl;
    }
 
-   void insert(uint64_t region_number, vector<int> pattern) {
+   void insert(uint64_t region_number, const vector<int> &pattern) {
       if (this->debug_level >= 2)
       cerr << "PrefetchStreamer::insert(region_number=0x" << hex << region_number
       << ", pattern=" << pattern_to_string(pattern) << ")" << dec << endl;
       uint64_t key = this->build_key(region_number);
-      Super::insert(key, {pattern});
+      PrefetchStreamerData data = {};
+      copy(pattern.begin(), pattern.end(), data.pattern);
+      Super::insert(key, data);
       Super::set_mru(key);
    }
 
@@ -375,7 +398,7 @@ public:
       }
       Super::set_mru(key);
       int pf_issued = 0;
-      vector<int> &pattern = entry->data.pattern;
+      int *pattern = entry->data.pattern;
       pattern[region_offset] = 0; /* accessed block will be automatically fetched if necessary (miss) */
       int pf_offset;
       /* prefetch blocks that are close to the recent access first (locality!) */
@@ -411,7 +434,7 @@ private:
    void write_data(Entry &entry, Table &table, int row) {
       uint64_t key = hash_index(entry.key, this->index_len);
       table.set_cell(row, 0, key);
-      table.set_cell(row, 1, pattern_to_string(entry.data.pattern));
+      table.set_cell(row, 1, pattern_to_string(entry.data.pattern, this->pattern_len));
    }
 
    uint64_t build_key(uint64_t region_number) { return hash_index(region_number, this->index_len); }
@@ -471,7 +494,7 @@ private:
    * @return  The appropriate prefetch level for all blocks based on BINGO's voting thresholds or
    *          an empty vector if no blocks should be prefetched
    */
-   vector<int> vote(const vector<vector<bool>> &x);
+   vector<int> vote(const vector<BingoPattern> &x);
 
    void init_knobs();
    void init_stats();
@@ -483,6 +506,7 @@ private:
    AccumulationTable accumulation_table;
    PatternHistoryTable pht;
    PrefetchStreamer pf_streamer;
+   vector<BingoPattern> pht_matches; /* reused by every PHT lookup */
    int debug_level = 0;
    uint32_t pc_address_fill_level;
 
@@ -60,16 +60,24 @@ class DRAM_ARRAY {
     };
 };
 
-// message packet
+#define NO_DEPENDENTS UINT32_MAX
+
+// message packet. The fields every queue and MSHR looks at come first and share a cache line.
+// The ROB, LQ and SQ entries merged into a packet are not part of it: they are kept in
+// packet_dependents, and depend_id is their entry there (NO_DEPENDENTS if nothing merged).
 class PACKET {
   public:
-    uint8_t instruction, 
-            tlb_access,
-            scheduled,
-            translated,
-            fetched,
-            prefetched,
-            drc_tag_read;
+    uint64_t address, 
+             full_addr, 
+             event_cycle,
+             instr_id,
+             ip, 
+             data,
+             instruction_pa,
+             data_pa,
+             cycle_enqueued;
+
+    uint32_t cpu, data_index, lq_index, sq_index, depend_id;
 
     int fill_level, 
         pf_origin_level,
@@ -83,49 +91,45 @@ class PACKET {
 
     uint32_t pf_metadata;
 
-    uint8_t  is_producer, 
-             //rob_index_depend_on_me[ROB_SIZE], 
-             //lq_index_depend_on_me[ROB_SIZE], 
-             //sq_index_depend_on_me[ROB_SIZE], 
-             instr_merged,
-             load_merged, 
-             store_merged,
-             returned,
-             asid[2],
-             type;
-
-    fastset
-             rob_index_depend_on_me, 
-             lq_index_depend_on_me, 
-             sq_index_depend_on_me;
-
-    uint32_t cpu, data_index, lq_index, sq_index;
-
-    uint64_t address, 
-             full_addr, 
-             instruction_pa,
-             data_pa,
-             data,
-             instr_id,
-             ip, 
-             event_cycle,
-             cycle_enqueued;
+    uint8_t type,
+            returned,
+            instruction, 
+            tlb_access,
+            scheduled,
+            translated,
+            fetched,
+            prefetched,
+            drc_tag_read,
+            is_producer, 
+            instr_merged,
+            load_merged, 
+            store_merged,
+            asid[2];
 
     PACKET() {
-        instruction = 0;
-        tlb_access = 0;
-        scheduled = 0;
-        translated = 0;
-        fetched = 0;
-        prefetched = 0;
-        drc_tag_read = 0;
+        reset();
+    };
 
-        returned = 0;
-        asid[0] = UINT8_MAX;
-        asid[1] = UINT8_MAX;
-        type = 0;
+    // empties the packet in place, e.g. when its queue slot is freed
+    void reset() {
+        address = 0;
+        full_addr = 0;
+        event_cycle = UINT64_MAX;
+        instr_id = 0;
+        ip = 0;
+        data = 0;
+        instruction_pa = 0;
+        data_pa = 0;
+        cycle_enqueued = 0;
+
+        cpu = NUM_CPUS;
+        data_index = 0;
+        lq_index = 0;
+        sq_index = 0;
+        depend_id = NO_DEPENDENTS;
 
         fill_level = -1; 
+        pf_origin_level = 0;
         rob_signal = -1;
         rob_index = -1;
         producer = -1;
@@ -134,32 +138,95 @@ class PACKET {
         signature = 0;
         confidence = 0;
 
-#if 0
-        for (uint32_t i=0; i<ROB_SIZE; i++) {
-            rob_index_depend_on_me[i] = 0;
-            lq_index_depend_on_me[i] = 0;
-            sq_index_depend_on_me[i] = 0;
-        }
-#endif
+        pf_metadata = 0;
+
+        type = 0;
+        returned = 0;
+        instruction = 0;
+        tlb_access = 0;
+        scheduled = 0;
+        translated = 0;
+        fetched = 0;
+        prefetched = 0;
+        drc_tag_read = 0;
         is_producer = 0;
         instr_merged = 0;
         load_merged = 0;
         store_merged = 0;
+        asid[0] = UINT8_MAX;
+        asid[1] = UINT8_MAX;
+    };
+};
 
-        cpu = NUM_CPUS;
-        data_index = 0;
-        lq_index = 0;
-        sq_index = 0;
+// ROB, LQ and SQ entries that merged into an in-flight packet and complete together with it
+class DEPENDENTS {
+  public:
+    fastset rob_index_depend_on_me, 
+            lq_index_depend_on_me, 
+            sq_index_depend_on_me;
+};
 
-        address = 0;
-        full_addr = 0;
-        instruction_pa = 0;
-        data = 0;
-        instr_id = 0;
-        ip = 0;
-        event_cycle = UINT64_MAX;
-	cycle_enqueued = 0;
+// dependents of the packets of one core. Only the caches next to the core (ITLB, DTLB, L1I
+// and L1D) record merges, so only their queues and MSHRs hold packets with a depend_id, and
+// the entries are used by that core alone. An entry is taken at the first merge into a packet,
+// moves with the packet when add_queue or add_mshr copy it into another queue, and is
+// released when the queue slot still holding it is freed.
+class DEPENDENCY_TABLE {
+    deque<DEPENDENTS> entries; // grows at the end only, so references to entries stay valid
+    vector<uint32_t> free_ids;
+
+  public:
+    // dependents of the packet, taking an entry for it if it has none
+    DEPENDENTS &get(PACKET *packet);
+    // dependents of the packet, NULL if none merged into it
+    DEPENDENTS *find(PACKET *packet) { return (packet->depend_id == NO_DEPENDENTS) ? NULL : &entries[packet->depend_id]; };
+    void release(PACKET *packet);
+};
+
+extern DEPENDENCY_TABLE packet_dependents[NUM_CPUS];
+
+// what check_queue compares, chosen when the queue is created
+#define QUEUE_MATCH_NONE      0 // never searched, e.g. the PROCESSED queues
+#define QUEUE_MATCH_ADDRESS   1 // block address
+#define QUEUE_MATCH_FULL_ADDR 2 // byte address, the L1D write queue
+
+// hash from the match key of the queued packets to their index, so looking up a queue or an MSHR
+// does not scan it. Open addressing with linear probing, a slot with no packets is empty.
+// Packets with the same key share a slot, which points at the one a scan from the head finds first.
+class QUEUE_INDEX {
+    struct SLOT {
+        uint64_t key;
+        uint32_t index, count;
     };
+
+    SLOT *slots;
+    uint32_t mask;
+
+    uint32_t home(uint64_t key) const { return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask; };
+
+  public:
+    QUEUE_INDEX() : slots(NULL), mask(0) {};
+    ~QUEUE_INDEX() { delete[] slots; };
+
+    void resize(uint32_t queue_size);
+
+    // index of the packet with this key, -1 if none
+    int find(uint64_t key) const {
+        if (slots == NULL)
+            return -1;
+        for (uint32_t i = home(key); slots[i].count; i = (i + 1) & mask) {
+            if (slots[i].key == key)
+                return slots[i].index;
+        }
+        return -1;
+    };
+
+    void insert(uint64_t key, uint32_t index);
+
+    // returns 1 if the slot pointed at the removed packet while others with the key remain,
+    // the caller then points it at the next one with repoint()
+    uint8_t erase(uint64_t key, uint32_t index);
+    void repoint(uint64_t key, uint32_t index);
 };
 
 // packet queue
@@ -167,6 +234,8 @@ class PACKET_QUEUE {
   public:
     string NAME;
     uint32_t SIZE;
+    uint8_t  match;
+    QUEUE_INDEX index;
 
     uint8_t  is_RQ, 
              is_WQ,
@@ -195,7 +264,7 @@ class PACKET_QUEUE {
     PACKET *entry, processed_packet[2*MAX_READ_PER_CYCLE];
 
     // constructor
-    PACKET_QUEUE(string v1, uint32_t v2) : NAME(v1), SIZE(v2) {
+    PACKET_QUEUE(string v1, uint32_t v2, uint8_t v3 = QUEUE_MATCH_ADDRESS) : NAME(v1), SIZE(v2), match(v3) {
         is_RQ = 0;
         is_WQ = 0;
         write_mode = 0;
@@ -222,9 +291,12 @@ class PACKET_QUEUE {
         FULL = 0;
 
         entry = new PACKET[SIZE]; 
+        if (match != QUEUE_MATCH_NONE)
+            index.resize(SIZE);
     };
 
     PACKET_QUEUE() {
+        match = QUEUE_MATCH_NONE;
         is_RQ = 0;
         is_WQ = 0;
 
@@ -257,6 +329,26 @@ class PACKET_QUEUE {
         delete[] entry;
     };
 
+    // reallocates the queue with a new size, only before it is used
+    void resize(uint32_t size) {
+        delete[] entry;
+        SIZE = size;
+        entry = new PACKET[SIZE];
+        if (match != QUEUE_MATCH_NONE)
+            index.resize(SIZE);
+    };
+
+    uint64_t match_key(PACKET *packet) { return (match == QUEUE_MATCH_FULL_ADDR) ? packet->full_addr : packet->address; };
+
+    // entries written in place instead of through add_queue are indexed with this
+    void track(uint32_t entry_index) {
+        if (match != QUEUE_MATCH_NONE)
+            index.insert(match_key(&entry[entry_index]), entry_index);
+    };
+
+    // first entry from the head with this key, other than skip
+    int scan_queue(uint64_t key, int skip);
+
     // functions
     int check_queue(PACKET* packet);
     void add_queue(PACKET* packet),
@@ -267,7 +359,7 @@ class PACKET_QUEUE {
 class CORE_BUFFER {
   public:
     const string NAME;
-    const uint32_t SIZE;
+    uint32_t SIZE;
     uint32_t cpu, 
              head, 
              tail,
@@ -315,6 +407,15 @@ class CORE_BUFFER {
     ~CORE_BUFFER() {
         delete[] entry;
     };
+
+    // reallocates the entries, only before the simulation starts
+    void resize(uint32_t size) {
+        delete[] entry;
+        SIZE = size;
+        last_read = SIZE-1;
+        last_fetch = SIZE-1;
+        entry = new ooo_model_instr[SIZE];
+    };
 };
 
 // load/store queue 
@@ -364,7 +465,7 @@ class LSQ_ENTRY {
 class LOAD_STORE_QUEUE {
   public:
     const string NAME;
-    const uint32_t SIZE;
+    uint32_t SIZE;
     uint32_t occupancy, head, tail;
 
     LSQ_ENTRY *entry;
@@ -382,5 +483,12 @@ class LOAD_STORE_QUEUE {
     ~LOAD_STORE_QUEUE() {
         delete[] entry;
     };
+
+    // reallocates the entries, only before the simulation starts
+    void resize(uint32_t size) {
+        delete[] entry;
+        SIZE = size;
+        entry = new LSQ_ENTRY[SIZE];
+    };
 };
 #endif
@@ -3,6 +3,8 @@
 
 #include "memory_class.h"
 #include "prefetcher.h"
+#include "checkpoint.h"
+#include "tag_store.h"
 
 // PAGE
 extern uint32_t PAGE_TABLE_LATENCY, SWAP_LATENCY;
@@ -16,6 +18,9 @@ extern uint32_t PAGE_TABLE_LATENCY, SWAP_LATENCY;
 #define IS_L2C  5
 #define IS_LLC  6
 
+// default geometry of the caches and TLBs, every value can be changed at run time with the
+// knob of the same name in lower case (e.g. --l2c_set=1024)
+
 // INSTRUCTION TLB
 #define ITLB_SET 16
 #define ITLB_WAY 8
@@ -88,9 +93,11 @@ class CACHE : public MEMORY {
   public:
     uint32_t cpu;
     const string NAME;
-    const uint32_t NUM_SET, NUM_WAY, NUM_LINE, WQ_SIZE, RQ_SIZE, PQ_SIZE, MSHR_SIZE;
+    uint32_t NUM_SET, NUM_WAY, NUM_LINE, WQ_SIZE, RQ_SIZE, PQ_SIZE, MSHR_SIZE;
+    uint32_t set_mask;
     uint32_t LATENCY;
     BLOCK **block;
+    TAG_STORE tag_store; // valid tags of the blocks, for the lookups
     int fill_level;
     uint32_t MAX_READ, MAX_FILL;
     uint32_t reads_available_this_cycle;
@@ -109,11 +116,11 @@ class CACHE : public MEMORY {
     uint32_t bw_compute_epoch;
 
     // queues
-    PACKET_QUEUE WQ{NAME + "_WQ", WQ_SIZE}, // write queue
+    PACKET_QUEUE WQ{NAME + "_WQ", WQ_SIZE, (uint8_t)((NAME == "L1D") ? QUEUE_MATCH_FULL_ADDR : QUEUE_MATCH_ADDRESS)}, // write queue
                  RQ{NAME + "_RQ", RQ_SIZE}, // read queue
                  PQ{NAME + "_PQ", PQ_SIZE}, // prefetch queue
                  MSHR{NAME + "_MSHR", MSHR_SIZE}, // MSHR
-                 PROCESSED{NAME + "_PROCESSED", ROB_SIZE}; // processed queue
+                 PROCESSED{NAME + "_PROCESSED", ROB_SIZE, QUEUE_MATCH_NONE}; // processed queue
 
     uint64_t sim_access[NUM_CPUS][NUM_TYPES],
              sim_hit[NUM_CPUS][NUM_TYPES],
@@ -144,14 +151,8 @@ class CACHE : public MEMORY {
         LATENCY = 0;
 
         // cache block
-        block = new BLOCK* [NUM_SET];
-        for (uint32_t i=0; i<NUM_SET; i++) {
-            block[i] = new BLOCK[NUM_WAY];
-
-            for (uint32_t j=0; j<NUM_WAY; j++) {
-                block[i][j].lru = j;
-            }
-        }
+        block = NULL;
+        set_geometry(NUM_SET, NUM_WAY, WQ_SIZE, RQ_SIZE, PQ_SIZE, MSHR_SIZE);
 
         for (uint32_t i=0; i<NUM_CPUS; i++) {
             upper_level_icache[i] = NULL;
@@ -198,6 +199,9 @@ class CACHE : public MEMORY {
         delete[] block;
     };
 
+    // reallocates the blocks and queues, only before the simulation starts
+    void set_geometry(uint32_t num_set, uint32_t num_way, uint32_t wq_size, uint32_t rq_size, uint32_t pq_size, uint32_t mshr_size);
+
     // functions
     int  add_rq(PACKET *packet),
          add_wq(PACKET *packet),
@@ -210,6 +214,9 @@ class CACHE : public MEMORY {
     uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
              get_size(uint8_t queue_type, uint64_t address);
 
+    // number of cycles until operate() can do anything, 1 if it may act in the next cycle
+    uint64_t cycles_to_next_event();
+
     int  check_hit(PACKET *packet),
          invalidate_entry(uint64_t inval_addr),
          check_mshr(PACKET *packet),
@@ -219,7 +226,13 @@ class CACHE : public MEMORY {
     void handle_fill(),
          handle_writeback(),
          handle_read(),
-         handle_prefetch();
+         handle_prefetch(),
+         functional_access(PACKET *packet),
+         checkpoint(CHECKPOINT_FILE &checkpoint),
+         llc_checkpoint_replacement(CHECKPOINT_FILE &checkpoint);
+
+    // only the caches next to the core keep the ROB, LQ and SQ entries merged into a packet
+    uint8_t tracks_dependents() { return (cache_type == IS_ITLB) || (cache_type == IS_DTLB) || (cache_type == IS_L1I) || (cache_type == IS_L1D); };
 
     void add_mshr(PACKET *packet),
          update_fill_cycle(),
@@ -19,6 +19,8 @@
 #include <string>
 #include <iomanip>
 
+#include "page_table.h"
+
 // USEFUL MACROS
 //#define DEBUG_PRINT
 #define SANITY_CHECK
@@ -88,9 +90,9 @@ extern uint64_t current_core_cycle[NUM_CPUS],
                 last_drc_write_mode,
                 drc_blocks;
 
-extern queue <uint64_t> page_queue;
-extern map <uint64_t, uint64_t> page_table, inverse_table, recent_page, unique_cl[NUM_CPUS];
-extern uint64_t previous_ppage, num_adjacent_page, num_cl[NUM_CPUS], allocated_pages, num_page[NUM_CPUS], minor_fault[NUM_CPUS], major_fault[NUM_CPUS];
+extern PAGE_TABLE page_table;
+extern FOOTPRINT unique_cl[NUM_CPUS];
+extern uint64_t previous_ppage, num_adjacent_page, allocated_pages, num_page[NUM_CPUS], minor_fault[NUM_CPUS], major_fault[NUM_CPUS];
 
 void print_stats();
 uint64_t rotl64 (uint64_t n, unsigned int c),
@@ -103,6 +105,9 @@ int lg2(int n);
 // get CPU cycle
 inline uint64_t get_cpu_cycle(uint32_t cpu) {return current_core_cycle[cpu];}
 
+// cycles from now until a clock reaches event_cycle, an event that is already due happens in the next cycle
+inline uint64_t cycles_until(uint64_t event_cycle, uint64_t now) {return (event_cycle > now) ? (event_cycle - now) : 1;}
+
 // smart random number generator
 class RANDOM {
   public:
@@ -118,5 +123,6 @@ class RANDOM {
         return dist(engine);
     };
 };
+extern RANDOM champsim_rand;
 extern uint64_t champsim_seed;
 #endif
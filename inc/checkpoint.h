@@ -0,0 +1,42 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <string>
+#include <map>
+
+// CHECKPOINT
+// the warmed microarchitectural state (cache and TLB contents with their replacement state,
+// branch predictors, page tables, DRAM open rows and trace positions) is written at the end of
+// the warmup and can be restored at start-up, so sweeps over other knobs can skip the warmup.
+// in-flight requests and prefetcher state are not part of the checkpoint.
+#define CHECKPOINT_MAGIC "CSCKPT"
+#define CHECKPOINT_VERSION 2
+
+// every component describes its state once through the same calls, which write it
+// when a checkpoint is saved and read it back when it is restored
+class CHECKPOINT_FILE {
+    FILE *file;
+    std::string name;
+
+  public:
+    const uint8_t restore;
+
+    CHECKPOINT_FILE(const char *checkpoint_name, uint8_t restore);
+    ~CHECKPOINT_FILE();
+
+    void transfer(void *data, size_t size),
+         transfer(std::map<uint64_t, uint64_t> &table);
+
+    // tag that has to match when restoring, catches checkpoints of a different configuration
+    void section(const std::string &tag);
+
+    template <class T> void value(T &data) { transfer(&data, sizeof(T)); };
+};
+
+// saves (restore = 0) or restores the state of the whole simulator
+void checkpoint_simulator(const char *checkpoint_name, uint8_t restore);
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef COMPACT_TRACE_H
+#define COMPACT_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "trace_reader.h"
+
+// COMPACT TRACE FORMAT
+//
+// header  | block 0 | block 1 | ... | index | trailer
+//
+// Each block holds up to block_size instructions and is compressed on its own,
+// so decoding can start at any block. Within a block every record is
+//   presence bitmask (varint): is_branch, branch_taken, then one bit per
+//                              destination/source register and memory operand
+//   ip delta (zigzag varint) from the previous ip
+//   present registers (1 byte each)
+//   present memory operands (zigzag varint), delta from the previous
+//                              destination/source address
+//   asid (2 bytes, cloudsuite traces only)
+// and the delta state starts from zero at every block.
+// The index maps the first instruction of every block to its file offset.
+#define COMPACT_TRACE_MAGIC "CSTRACE"
+#define COMPACT_TRACE_VERSION 1
+#define COMPACT_TRACE_BLOCK_SIZE 65536
+
+#define COMPACT_TRACE_CODEC_NONE 0
+#define COMPACT_TRACE_CODEC_ZLIB 1
+#define COMPACT_TRACE_CODEC_ZSTD 2
+
+struct compact_trace_header {
+    char     magic[8];
+    uint32_t version;
+    uint8_t  codec,
+             num_destinations,
+             num_sources,
+             cloudsuite;
+    uint32_t block_size;
+};
+
+struct compact_trace_block_header {
+    uint32_t compressed_size,
+             raw_size,
+             num_instrs;
+};
+
+struct compact_trace_index_entry {
+    uint64_t first_instr,
+             offset;
+};
+
+struct compact_trace_trailer {
+    uint64_t index_offset,
+             num_blocks,
+             num_instrs;
+    char     magic[8];
+};
+
+// returns 1 if the file starts with the compact trace magic
+bool is_compact_trace(const char *trace_name);
+
+class COMPACT_TRACE_WRITER {
+    FILE *file;
+    compact_trace_header header;
+    std::vector<compact_trace_index_entry> index;
+    std::vector<uint8_t> raw, compressed;
+    uint64_t num_instrs;
+    uint32_t block_instrs;
+    uint64_t last_ip, last_destination_memory, last_source_memory;
+
+    void flush_block();
+
+  public:
+    COMPACT_TRACE_WRITER(const char *trace_name, uint8_t cloudsuite, uint8_t codec, uint32_t block_size);
+    ~COMPACT_TRACE_WRITER();
+
+    // the cloudsuite layout is a superset of input_instr, so both are written through it
+    void write_instr(const cloudsuite_instr &instr);
+    void close();
+};
+
+class COMPACT_TRACE_DECODER : public TRACE_DECODER {
+    uint32_t cpu;
+    FILE *file;
+    compact_trace_header header;
+    std::vector<compact_trace_index_entry> index;
+    std::vector<uint8_t> raw, compressed;
+    uint64_t num_instrs, next_block;
+    uint32_t block_instrs, position;
+    uint64_t last_ip, last_destination_memory, last_source_memory;
+
+    bool load_block(uint64_t block);
+
+  public:
+    COMPACT_TRACE_DECODER(uint32_t cpu, const char *trace_name, uint8_t cloudsuite);
+    ~COMPACT_TRACE_DECODER();
+
+    bool decode_instr(ooo_model_instr *arch_instr);
+    void rewind();
+    uint64_t skip(uint64_t count);
+
+    // index of the next instruction to be decoded
+    uint64_t tell();
+
+    // positions the decoder at instruction instr_count without decoding the preceding blocks
+    void seek(uint64_t instr_count);
+    uint64_t size() { return num_instrs; };
+};
+
+#endif
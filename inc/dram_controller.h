@@ -2,6 +2,7 @@
 #define DRAM_H
 
 #include "memory_class.h"
+#include "checkpoint.h"
 
 // DRAM configuration
 #define DRAM_CHANNEL_WIDTH 8 // 8B
@@ -107,7 +108,8 @@ class MEMORY_CONTROLLER : public MEMORY {
     void schedule(PACKET_QUEUE *queue), process(PACKET_QUEUE *queue),
          update_schedule_cycle(PACKET_QUEUE *queue),
          update_process_cycle(PACKET_QUEUE *queue),
-         reset_remain_requests(PACKET_QUEUE *queue, uint32_t channel);
+         reset_remain_requests(PACKET_QUEUE *queue, uint32_t channel),
+         checkpoint(CHECKPOINT_FILE &checkpoint);
 
     uint32_t dram_get_channel(uint64_t address),
              dram_get_rank   (uint64_t address),
@@ -118,6 +120,9 @@ class MEMORY_CONTROLLER : public MEMORY {
 
     uint64_t get_bank_earliest_cycle();
 
+    // number of cycles until operate() can do anything, 1 if it may act in the next cycle
+    uint64_t cycles_to_next_event();
+
     int check_dram_queue(PACKET_QUEUE *queue, PACKET *packet);
 };
 
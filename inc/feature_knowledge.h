@@ -3,7 +3,12 @@
 
 #include <string>
 #include "scooby_helper.h"
+#include "qtable.h"
+
+class CHECKPOINT_FILE;
 #define FK_MAX_TILINGS 32
+/* Q-values of a tile are one Q-table row over all actions */
+#define FK_MAX_ROW_SIZE 64
 
 typedef enum
 {
@@ -43,7 +48,7 @@ private:
 	uint32_t m_hash_type;
 
 	uint32_t m_num_tilings, m_num_tiles;
-	float ***m_qtable;
+	QTable *m_qtable; /* [tiling][tile][action], a row per tile */
 	bool m_enable_tiling_offset;
 
 	float min_weight, max_weight;
@@ -55,9 +60,8 @@ private:
 	FILE *trace;
 
 private:
-	float getQ(uint32_t tiling, uint32_t tile_index, uint32_t action);
-	void setQ(uint32_t tiling, uint32_t tile_index, uint32_t action, float value);
 	uint32_t get_tile_index(uint32_t tiling, State *state);
+	void get_tile_rows(State *state, uint32_t *rows); /* Q-table row of the state in each tiling */
 	string get_feature_string(State *state);
 
 	/* feature index generators */
@@ -89,10 +93,12 @@ private:
 public:
 	FeatureKnowledge(FeatureType feature_type, float alpha, float gamma, uint32_t actions, float weight, float weight_gradient, uint32_t num_tilings, uint32_t num_tiles, bool zero_init, uint32_t hash_type, int32_t enable_tiling_offset);
 	~FeatureKnowledge();
-	float retrieveQ(State *state, uint32_t action_index);
+	void retrieveQ(State *state, float *q_values); /* all actions at once, q_values holds FK_MAX_ROW_SIZE floats */
 	void updateQ(State *state1, uint32_t action1, int32_t reward, State *state2, uint32_t action2);
 	static string getFeatureString(FeatureType type);
 	uint32_t getMaxAction(State *state); /* Called by featurewise engine only to get a consensus from all the features */
+	uint32_t getMaxAction(const float *q_values); /* same, from the Q-values of all actions */
+	void checkpoint(CHECKPOINT_FILE &checkpoint); /* Q-values, weight, alpha and gamma */
 
 	/* weight manipulation */
 	inline void increase_weight() {m_weight = m_weight + m_weight_gradient * m_weight; if(m_weight < min_weight) min_weight = m_weight;}
@@ -0,0 +1,55 @@
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+
+#include <stdint.h>
+#include <vector>
+#include <assert.h>
+
+/* Space-Saving top-K tracker: counts the most frequent of an unbounded set of
+ * keys in a fixed amount of memory. A key that is not tracked takes over the
+ * slot of the least frequent key together with its count, so the count of a
+ * slot overestimates the true count of its key by at most its error.
+ * Every slot also keeps a small histogram (e.g. per action), counted from the
+ * moment its key got the slot. */
+class HeavyHitters
+{
+private:
+	uint32_t m_capacity, m_columns;
+	uint32_t m_size;
+	std::vector<uint64_t> m_keys;
+	std::vector<uint64_t> m_counts, m_errors;
+	std::vector<uint64_t> m_histograms; /* m_capacity x m_columns */
+	std::vector<uint32_t> m_heap; /* min-heap of slots by count */
+	std::vector<uint32_t> m_heap_pos; /* slot -> position in m_heap */
+	std::vector<uint32_t> m_index; /* open addressing, key -> slot */
+	uint32_t m_index_mask;
+	uint64_t m_updates, m_replacements;
+
+	inline uint32_t hash(uint64_t key) const {return (uint32_t)((key * 0x9e3779b97f4a7c15ull) >> 32) & m_index_mask;}
+	uint32_t find(uint64_t key) const;
+	void index_insert(uint64_t key, uint32_t slot);
+	void index_erase(uint64_t key);
+	void sift_down(uint32_t pos);
+	void heap_swap(uint32_t pos1, uint32_t pos2);
+
+public:
+	HeavyHitters(uint32_t capacity, uint32_t columns);
+	~HeavyHitters() {}
+
+	void update(uint64_t key, uint32_t column);
+	void clear();
+
+	/* tracked slots, most frequent first, ties ordered by key */
+	std::vector<uint32_t> sorted() const;
+	inline uint64_t get_key(uint32_t slot) const {return m_keys[slot];}
+	inline uint64_t get_count(uint32_t slot) const {return m_counts[slot];}
+	inline uint64_t get_error(uint32_t slot) const {return m_errors[slot];}
+	inline uint64_t get_histogram(uint32_t slot, uint32_t column) const {assert(column < m_columns); return m_histograms[(uint64_t)slot * m_columns + column];}
+
+	inline uint32_t get_size() const {return m_size;}
+	inline uint32_t get_capacity() const {return m_capacity;}
+	inline uint64_t get_updates() const {return m_updates;}
+	inline uint64_t get_replacements() const {return m_replacements;}
+};
+
+#endif /* HEAVY_HITTERS_H */
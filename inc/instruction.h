@@ -3,15 +3,15 @@
 
 
 // instruction format
-#define ROB_SIZE 256
-#define LQ_SIZE 72
-#define SQ_SIZE 56
 #define NUM_INSTR_DESTINATIONS_SPARC 4
 #define NUM_INSTR_DESTINATIONS 2
 #define NUM_INSTR_SOURCES 4
 
 #include "set.h"
 
+// sizes of the core buffers, set at run time with the knobs rob_size, lq_size and sq_size
+extern uint32_t ROB_SIZE, LQ_SIZE, SQ_SIZE;
+
 class input_instr {
   public:
 
@@ -108,8 +108,7 @@ class ooo_model_instr {
             reg_RAW_producer,
             reg_ready,
             mem_ready,
-            asid[2],
-            reg_RAW_checked[NUM_INSTR_SOURCES];
+            asid[2];
 
     uint32_t fetched, scheduled;
     int num_reg_ops, num_mem_ops, num_reg_dependent;
@@ -193,7 +192,6 @@ class ooo_model_instr {
             source_virtual_address[i] = 0;
             source_added[i] = 0;
             lq_index[i] = UINT32_MAX;
-            reg_RAW_checked[i] = 0;
         }
 
         for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS_SPARC; i++) {
@@ -5,6 +5,8 @@
 
 #define MAX_ACTIONS 64
 
+class CHECKPOINT_FILE;
+
 enum Policy
 {
 	InvalidPolicy = 0,
@@ -41,6 +43,7 @@ protected:
 protected:
 	LearningType parseLearningType(std::string str);
 	Policy parsePolicy(std::string str);
+	void checkpoint_hyperparameters(CHECKPOINT_FILE &checkpoint); /* alpha, gamma and epsilon */
 
 public:
 	LearningEngineBase(Prefetcher *p, float alpha, float gamma, float epsilon, uint32_t actions, uint32_t states, uint64_t seed, std::string policy, std::string type);
@@ -5,6 +5,7 @@
 #include <string.h>
 #include "prefetcher.h"
 #include "learning_engine_base.h"
+#include "qtable.h"
 
 #define MAX_ACTIONS 64
 
@@ -32,7 +33,7 @@ private:
     std::bernoulli_distribution *explore;
     std::uniform_int_distribution<int> *actiongen;
 
-	float **qtable;
+	QTable *qtable;
 
 	/* tracing related knobs */
 	uint32_t trace_interval;
@@ -76,6 +77,7 @@ public:
 	uint32_t chooseAction(uint32_t state);
 	void learn(uint32_t state1, uint32_t action1, int32_t reward, uint32_t state2, uint32_t action2);
 	void dump_stats();
+	void checkpoint(CHECKPOINT_FILE &checkpoint); /* saves or restores the trained engine */
 };
 
 #endif /* LEARNING_ENGINE */
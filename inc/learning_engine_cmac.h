@@ -4,6 +4,7 @@
 #include <random>
 #include "learning_engine_base.h"
 #include "scooby_helper.h"
+#include "qtable.h"
 
 #define MAX_CMAC_PLANES 128
 
@@ -45,7 +46,7 @@ private:
     std::bernoulli_distribution *m_explore;
     std::uniform_int_distribution<int> *m_actiongen;
 
-	float **m_qtables;
+	QTable *m_qtables; /* [plane][entry] */
 	uint64_t m_action_counter;
 	uint64_t m_early_exploration_window;
 
@@ -69,7 +70,6 @@ private:
 private:
 	uint32_t getMaxAction(State *state);
 	float consultPlane(uint32_t plane, State *state, uint32_t action);
-	void updatePlane(uint32_t plane, State *state, uint32_t action, float value);
 	uint32_t generatePlaneIndex(uint32_t plane, State *state, uint32_t action);
 	uint32_t getHash(uint32_t key);
 
@@ -22,7 +22,7 @@ private:
     std::bernoulli_distribution *m_explore;
     std::uniform_int_distribution<int> *m_actiongen;
 
-	float ***m_qtables;
+	QTable *m_qtables; /* [plane][entry][action], a row per entry of a plane */
 
 	/* tracing related knobs */
 	uint32_t trace_interval;
@@ -56,10 +56,9 @@ private:
 
 private:
 	uint32_t getMaxAction(State *state, float &max_q, float &max_to_avg_q_ratio);
-	float consultQ(State *state, uint32_t action);
-	float consultPlane(uint32_t plane, State *state, uint32_t action);
-	void updatePlane(uint32_t plane, State *state, uint32_t action, float value);
+	void consultQ(State *state, float *q_values); /* all actions at once */
 	uint32_t generatePlaneIndex(uint32_t plane, State *state, uint32_t action);
+	void getPlaneRows(State *state, uint32_t *rows); /* Q-table row of the state in each plane */
 	uint32_t getHash(uint32_t key);
 	void dump_state_trace(State *state);
 	void plot_scores();
@@ -86,6 +85,7 @@ public:
 	uint32_t chooseAction(State *state, float &max_to_avg_q_ratio);
 	void learn(State *state1, uint32_t action1, int32_t reward, State *state2, uint32_t action2);
 	void dump_stats();
+	void checkpoint(CHECKPOINT_FILE &checkpoint); /* saves or restores the trained engine */
 };
 
 #endif /* LEARNING_ENGINE_CMAC_H */
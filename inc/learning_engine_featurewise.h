@@ -11,6 +11,9 @@ private:
 	FeatureKnowledge* m_feature_knowledges[NumFeatureTypes];
 	float m_max_q_value;
 
+	/* Q-values of every action per feature, from the last consultQ */
+	float m_feature_q_values[NumFeatureTypes][FK_MAX_ROW_SIZE];
+
 	std::default_random_engine m_generator;
 	std::bernoulli_distribution *m_explore;
 	std::uniform_int_distribution<int> *m_actiongen;
@@ -56,9 +59,9 @@ private:
 	void init_knobs();
 	void init_stats();
 	uint32_t getMaxAction(State *state, float &max_q, float &max_to_avg_q_ratio, vector<bool> &consensus_vec);
-	float consultQ(State *state, uint32_t action);
+	void consultQ(State *state, float *q_values);
 	void gather_stats(float max_q, float max_to_avg_q_ratio);
-	void action_selection_consensus(State *state, uint32_t selected_action, vector<bool> &consensus_vec);
+	void action_selection_consensus(uint32_t selected_action, vector<bool> &consensus_vec);
 	void adjust_feature_weights(vector<bool> consensus_vec, RewardType reward_type);
 	bool do_fallback(State *state);
 	void plot_scores();
@@ -69,6 +72,7 @@ public:
 	uint32_t chooseAction(State *state, float &max_to_avg_q_ratio, vector<bool> &consensus_vec);
 	void learn(State *state1, uint32_t action1, int32_t reward, State *state2, uint32_t action2, vector<bool> consensus_vec, RewardType reward_type);
 	void dump_stats();
+	void checkpoint(CHECKPOINT_FILE &checkpoint); /* saves or restores the trained engine */
 };
 
 #endif /* LEARNING_ENGINE_FEATUREWISE_H */
@@ -25,7 +25,7 @@ class MEMORY {
     MEMORY *upper_level_icache[NUM_CPUS], *upper_level_dcache[NUM_CPUS], *lower_level, *extra_interface;
 
     // empty queues
-    PACKET_QUEUE WQ{"EMPTY", 1}, RQ{"EMPTY", 1}, PQ{"EMPTY", 1}, MSHR{"EMPTY", 1};
+    PACKET_QUEUE WQ{"EMPTY", 1, QUEUE_MATCH_NONE}, RQ{"EMPTY", 1, QUEUE_MATCH_NONE}, PQ{"EMPTY", 1, QUEUE_MATCH_NONE}, MSHR{"EMPTY", 1, QUEUE_MATCH_NONE};
 
     // functions
     virtual int  add_rq(PACKET *packet) = 0;
@@ -22,16 +22,22 @@
  */
 enum MLOP_State { INIT = 0, ACCESS = 1, PREFTCH = 2 };
 char getStateChar(MLOP_State state);
-string map_to_string(const vector<MLOP_State> &access_map, const vector<int> &prefetch_map);
+string map_to_string(const MLOP_State *access_map, const int *prefetch_map, unsigned blocks_in_zone);
+
+/* the access maps of a zone and its history queue are kept inline in the table entry */
+#define MLOP_MAX_BLOCKS_IN_ZONE 64
+#define MLOP_MAX_PF_DEGREE 64
 
 class AccessMapData {
   public:
     /* block states are represented with a `MLOP_State` and an `int` in this software implementation but
      * in a hardware implementation, they'd be represented with only 2 bits. */
-    vector<MLOP_State> access_map;
-    vector<int> prefetch_map;
+    MLOP_State access_map[MLOP_MAX_BLOCKS_IN_ZONE];
+    int prefetch_map[MLOP_MAX_BLOCKS_IN_ZONE];
 
-    deque<int> hist_queue;
+    /* zone offsets of the most recent accesses, latest first */
+    uint8_t hist_queue[MLOP_MAX_PF_DEGREE];
+    unsigned hist_len;
 };
 
 class AccessMapTable : public LRUSetAssociativeCache<AccessMapData> {
@@ -70,29 +76,34 @@ class AccessMapTable : public LRUSetAssociativeCache<AccessMapData> {
             // assert(new_state != MLOP_State::PREFTCH);
             if (new_state == MLOP_State::INIT)
                 return;
-            Super::insert(key, {vector<MLOP_State>(blocks_in_zone, MLOP_State::INIT), vector<int>(blocks_in_zone, 0)});
+            AccessMapData data = {}; /* all blocks in state INIT */
+            Super::insert(key, data);
             entry = Super::find(key);
-            // assert(entry->data.hist_queue.empty());
+            // assert(entry->data.hist_len == 0);
         }
 
-        auto &access_map = entry->data.access_map;
-        auto &prefetch_map = entry->data.prefetch_map;
-        auto &hist_queue = entry->data.hist_queue;
+        MLOP_State *access_map = entry->data.access_map;
+        int *prefetch_map = entry->data.prefetch_map;
 
         if (new_state == MLOP_State::ACCESS) {
             Super::set_mru(key);
 
             /* insert access into queue */
-            hist_queue.push_front(zone_offset);
-            if (hist_queue.size() > this->queue_size)
-                hist_queue.pop_back();
+            uint8_t *hist_queue = entry->data.hist_queue;
+            unsigned &hist_len = entry->data.hist_len;
+            if (hist_len < this->queue_size)
+                hist_len += 1;
+            for (unsigned i = hist_len; i > 1; i -= 1)
+                hist_queue[i - 1] = hist_queue[i - 2];
+            hist_queue[0] = zone_offset;
         }
 
         MLOP_State old_state = access_map[zone_offset];
         int old_fill_level = prefetch_map[zone_offset];
 
-        vector<MLOP_State> old_access_map = access_map;
-        vector<int> old_prefetch_map = prefetch_map;
+        string old_map;
+        if (this->debug_level >= 2)
+            old_map = map_to_string(access_map, prefetch_map, this->blocks_in_zone);
 
         access_map[zone_offset] = new_state;
         prefetch_map[zone_offset] = new_fill_level;
@@ -114,10 +125,9 @@ class AccessMapTable : public LRUSetAssociativeCache<AccessMapData> {
                  << ", zone_offset=" << setw(2) << zone_offset << ": state transition from " << getStateChar(old_state)
                  << " to " << getStateChar(new_state) << endl;
             if (old_state != new_state || old_fill_level != new_fill_level) {
-                cout << "[AccessMapTable::set_state] old_access_map=" << map_to_string(old_access_map, old_prefetch_map)
-                     << endl;
-                cout << "[AccessMapTable::set_state] new_access_map=" << map_to_string(access_map, prefetch_map)
-                     << endl;
+                cout << "[AccessMapTable::set_state] old_access_map=" << old_map << endl;
+                cout << "[AccessMapTable::set_state] new_access_map="
+                     << map_to_string(access_map, prefetch_map, this->blocks_in_zone) << endl;
             }
         }
     }
@@ -139,7 +149,7 @@ class AccessMapTable : public LRUSetAssociativeCache<AccessMapData> {
     void write_data(Entry &entry, Table &table, int row) {
         uint64_t zone_number = hash_index(entry.key, this->index_len);
         table.set_cell(row, 0, zone_number);
-        table.set_cell(row, 1, map_to_string(entry.data.access_map, entry.data.prefetch_map));
+        table.set_cell(row, 1, map_to_string(entry.data.access_map, entry.data.prefetch_map, this->blocks_in_zone));
     }
 
     uint64_t build_key(uint64_t zone_number) {
@@ -3,6 +3,7 @@
 
 #include "cache.h"
 #include "instruction.h"
+#include "trace_reader.h"
 
 #ifdef CRC2_COMPILE
 #define STAT_PRINTING_PERIOD 1000000
@@ -14,36 +15,60 @@
 using namespace std;
 
 // CORE PROCESSOR
-#define FETCH_WIDTH 6
-#define DECODE_WIDTH 6
-#define EXEC_WIDTH 4
-#define LQ_WIDTH 2
-#define SQ_WIDTH 2
-#define RETIRE_WIDTH 4
-#define SCHEDULER_SIZE 128
-#define BRANCH_MISPREDICT_PENALTY 20
-//#define SCHEDULING_LATENCY 6
-//#define EXEC_LATENCY 1
+// widths, sizes and latencies are set at run time with the knob of the same name in lower case
+// (e.g. --rob_size=224 --exec_width=8), see knobs.cc for the defaults
+extern uint32_t FETCH_WIDTH, DECODE_WIDTH, EXEC_WIDTH, LQ_WIDTH, SQ_WIDTH, RETIRE_WIDTH,
+                SCHEDULER_SIZE, BRANCH_MISPREDICT_PENALTY;
+extern uint32_t SCHEDULING_LATENCY, EXEC_LATENCY;
 
 #define STA_SIZE (ROB_SIZE*NUM_INSTR_DESTINATIONS_SPARC)
-
-extern uint32_t SCHEDULING_LATENCY, EXEC_LATENCY;
+#define NUM_ARCH_REGISTERS 256 // register ids in the trace are 8 bits
 
 void print_core_config();
 
+// one bit per ROB entry, so a pipeline stage only visits the entries that have something to do,
+// in program order when walked from the ROB head
+class ROB_MASK {
+    uint64_t bits[MAX_SIZE/64];
+
+  public:
+    ROB_MASK() { memset(bits, 0, sizeof(bits)); };
+
+    void set(uint32_t index) { bits[index >> 6] |= 1ull << (index & 63); };
+    void reset(uint32_t index) { bits[index >> 6] &= ~(1ull << (index & 63)); };
+
+    bool empty() const {
+        for (uint32_t i=0; i<(ROB_SIZE+63)/64; i++) {
+            if (bits[i])
+                return false;
+        }
+        return true;
+    };
+
+    // first set entry at or after index, without wrapping around, ROB_SIZE if none
+    uint32_t next(uint32_t index) const {
+        for (uint32_t i = index >> 6; i < (ROB_SIZE+63)/64; i++) {
+            uint64_t word = bits[i];
+            if (i == (index >> 6))
+                word &= ~0ull << (index & 63);
+            if (word)
+                return (i << 6) + __builtin_ctzll(word);
+        }
+        return ROB_SIZE;
+    };
+};
+
 // cpu
 class O3_CPU {
   public:
     uint32_t cpu;
 
     // trace
-    FILE *trace_file;
+    TRACE_READER *trace_reader;
     char trace_string[1024];
-    char gunzip_command[1024];
+    uint64_t trace_offset; // trace instructions skipped before the timing model started
 
     // instruction
-    input_instr current_instr;
-    cloudsuite_instr current_cloudsuite_instr;
     uint64_t instr_unique_id, completed_executions, 
              begin_sim_cycle, begin_sim_instr, 
              last_sim_cycle, last_sim_instr,
@@ -59,20 +84,36 @@ class O3_CPU {
     CORE_BUFFER ROB{"ROB", ROB_SIZE};
     LOAD_STORE_QUEUE LQ{"LQ", LQ_SIZE}, SQ{"SQ", SQ_SIZE};
     
+    // the arrays below are sized with the ROB, LQ and SQ by allocate_buffers()
+
     // store array, this structure is required to properly handle store instructions
-    uint64_t STA[STA_SIZE], STA_head, STA_tail; 
+    uint64_t *STA, STA_head, STA_tail; 
 
     // Ready-To-Execute
-    uint32_t RTE0[ROB_SIZE], RTE0_head, RTE0_tail, 
-             RTE1[ROB_SIZE], RTE1_head, RTE1_tail;  
+    uint32_t *RTE0, RTE0_head, RTE0_tail, 
+             *RTE1, RTE1_head, RTE1_tail;  
 
     // Ready-To-Load
-    uint32_t RTL0[LQ_SIZE], RTL0_head, RTL0_tail, 
-             RTL1[LQ_SIZE], RTL1_head, RTL1_tail;  
+    uint32_t *RTL0, RTL0_head, RTL0_tail, 
+             *RTL1, RTL1_head, RTL1_tail;  
 
     // Ready-To-Store
-    uint32_t RTS0[SQ_SIZE], RTS0_head, RTS0_tail,
-             RTS1[SQ_SIZE], RTS1_head, RTS1_tail;
+    uint32_t *RTS0, RTS0_head, RTS0_tail,
+             *RTS1, RTS1_head, RTS1_tail;
+
+    // register renaming: the youngest in-flight writer of every architectural register, i.e. the
+    // one a new consumer depends on, and for every destination of a ROB entry the next older and
+    // younger in-flight writers of that register. Writers leave their list when they complete.
+    uint32_t reg_writer[NUM_ARCH_REGISTERS],
+             (*older_writer)[NUM_INSTR_DESTINATIONS_SPARC],
+             (*younger_writer)[NUM_INSTR_DESTINATIONS_SPARC];
+
+    // memory instructions whose registers are ready and which wait to be added to the LSQ,
+    // and executed instructions that complete once their event_cycle is reached
+    ROB_MASK lsq_wait, completing;
+
+    // latest event_cycle given to a scheduled instruction, see schedule_instruction()
+    uint64_t scheduled_event_cycle;
 
     // branch
     int branch_mispredict_stall_fetch; // flag that says that we should stall because a branch prediction was wrong
@@ -95,7 +136,8 @@ class O3_CPU {
         cpu = 0;
 
         // trace
-        trace_file = NULL;
+        trace_reader = NULL;
+        trace_offset = 0;
 
         // instruction
         instr_unique_id = 0;
@@ -124,6 +166,8 @@ class O3_CPU {
 
         next_ITLB_fetch = 0;
 
+        scheduled_event_cycle = 0;
+
         // branch
         branch_mispredict_stall_fetch = 0;
         mispredicted_branch_iw_index = 0;
@@ -132,39 +176,20 @@ class O3_CPU {
         num_branch = 0;
         branch_mispredictions = 0;
 
-        for (uint32_t i=0; i<STA_SIZE; i++)
-            STA[i] = UINT64_MAX;
-        STA_head = 0;
-        STA_tail = 0;
-
-        for (uint32_t i=0; i<ROB_SIZE; i++) {
-            RTE0[i] = ROB_SIZE;
-            RTE1[i] = ROB_SIZE;
-        }
-        RTE0_head = 0;
-        RTE1_head = 0;
-        RTE0_tail = 0;
-        RTE1_tail = 0;
-
-        for (uint32_t i=0; i<LQ_SIZE; i++) {
-            RTL0[i] = LQ_SIZE;
-            RTL1[i] = LQ_SIZE;
-        }
-        RTL0_head = 0;
-        RTL1_head = 0;
-        RTL0_tail = 0;
-        RTL1_tail = 0;
-
-        for (uint32_t i=0; i<SQ_SIZE; i++) {
-            RTS0[i] = SQ_SIZE;
-            RTS1[i] = SQ_SIZE;
-        }
-        RTS0_head = 0;
-        RTS1_head = 0;
-        RTS0_tail = 0;
-        RTS1_tail = 0;
+        STA = NULL;
+        RTE0 = NULL;
+        RTE1 = NULL;
+        RTL0 = NULL;
+        RTL1 = NULL;
+        RTS0 = NULL;
+        RTS1 = NULL;
+        older_writer = NULL;
+        younger_writer = NULL;
     }
 
+    // sizes the ROB, the LQ, the SQ and the arrays that go with them once the knobs are parsed
+    void allocate_buffers();
+
     // functions
     void handle_branch(),
          fetch_instruction(),
@@ -178,7 +203,10 @@ class O3_CPU {
          do_memory_scheduling(uint32_t rob_index),
          operate_lsq(),
          complete_execution(uint32_t rob_index),
+         check_completion(uint32_t rob_index),
          reg_RAW_dependency(uint32_t prior, uint32_t current, uint32_t source_index),
+         add_reg_writer(uint32_t rob_index),
+         remove_reg_writer(uint32_t rob_index),
          reg_RAW_release(uint32_t rob_index),
          mem_RAW_dependency(uint32_t prior, uint32_t current, uint32_t data_index, uint32_t lq_index),
          handle_o3_fetch(PACKET *current_packet, uint32_t cache_type),
@@ -189,6 +217,8 @@ class O3_CPU {
          complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb);
 
     void initialize_core();
+    void warm_instruction(),
+         warm_access(uint64_t ip, uint64_t va, uint32_t asid, uint8_t instruction, uint8_t type);
     void add_load_queue(uint32_t rob_index, uint32_t data_index),
          add_store_queue(uint32_t rob_index, uint32_t data_index),
          execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_index);
@@ -199,15 +229,22 @@ class O3_CPU {
     void update_rob();
     void retire_rob();
 
+    // next-event simulation: number of cycles until this core or its private caches can do anything,
+    // and the clock update for idle cycles that are skipped over
+    uint64_t cycles_to_next_event();
+    void skip_cycles(uint64_t cycles);
+
     uint32_t  add_to_rob(ooo_model_instr *arch_instr),
               check_rob(uint64_t instr_id);
 
-    uint32_t check_and_add_lsq(uint32_t rob_index);
+    uint32_t check_and_add_lsq(uint32_t rob_index),
+             writer_slot(uint32_t rob_index, uint8_t reg);
 
     // branch predictor
     uint8_t predict_branch(uint64_t ip);
     void    initialize_branch_predictor(),
-            last_branch_result(uint64_t ip, uint8_t taken); 
+            last_branch_result(uint64_t ip, uint8_t taken),
+            checkpoint_branch_predictor(CHECKPOINT_FILE &checkpoint);
 };
 
 extern O3_CPU ooo_cpu[NUM_CPUS];
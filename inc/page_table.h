@@ -0,0 +1,87 @@
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+class CHECKPOINT_FILE;
+
+#define NO_SLOT UINT32_MAX
+
+// SLOT INDEX
+// open-addressed hash index over keys kept in an array elsewhere: a bucket only holds the
+// slot of its key in that array, so the index costs a few bytes per key. Buckets are kept
+// at most half full and removals shift the following entries back instead of leaving tombstones.
+class SLOT_INDEX {
+    const std::vector<uint64_t> &keys;
+    std::vector<uint32_t> buckets;
+    uint32_t shift, size;
+
+    uint64_t bucket(uint64_t key) const { return (key * 0x9e3779b97f4a7c15ull) >> shift; };
+    void resize(uint64_t num_buckets),
+         place(uint32_t slot);
+
+  public:
+    SLOT_INDEX(const std::vector<uint64_t> &keys) : keys(keys), shift(64), size(0) { resize(16); };
+
+    // slot of the key, NO_SLOT if it is not indexed
+    uint32_t find(uint64_t key) const;
+    void insert(uint32_t slot), // indexes keys[slot], which must not be indexed yet
+         erase(uint64_t key),
+         rebuild(); // indexes every key of the array
+};
+
+// PAGE TABLE
+// VA => PA translations of all cores. Every allocated physical page has a slot holding its
+// virtual and physical page number, and both are indexed by hash, so translations, the check
+// for a free physical page and swaps take constant time and no memory per lookup.
+// When memory is full, the page to swap out is chosen by a clock over the slots (NRU): a
+// translation sets the referenced bit of its page, and the hand takes the first page whose bit
+// is clear, clearing the bits it passes on the way.
+class PAGE_TABLE {
+    std::vector<uint64_t> vpages, ppages;
+    std::vector<uint8_t> referenced;
+    SLOT_INDEX vpage_index, ppage_index;
+    uint32_t hand;
+
+  public:
+    PAGE_TABLE() : vpage_index(vpages), ppage_index(ppages), hand(0) {};
+
+    // slot of the virtual page, NO_SLOT if it is not mapped
+    uint32_t find(uint64_t vpage) const { return vpage_index.find(vpage); };
+    bool ppage_mapped(uint64_t ppage) const { return ppage_index.find(ppage) != NO_SLOT; };
+
+    uint64_t vpage(uint32_t slot) const { return vpages[slot]; };
+    uint64_t ppage(uint32_t slot) const { return ppages[slot]; };
+    void touch(uint32_t slot) { referenced[slot] = 1; };
+
+    uint32_t map(uint64_t vpage, uint64_t ppage), // maps a free physical page, returns its slot
+             nru_victim();
+    void remap(uint32_t slot, uint64_t vpage); // hands the physical page of the slot to another virtual page
+
+    void checkpoint(CHECKPOINT_FILE &checkpoint);
+};
+
+// FOOTPRINT
+// number of distinct cache lines a core touched. Counted exactly by default; with
+// approximate_footprint a HyperLogLog sketch of 2^FOOTPRINT_HLL_BITS registers estimates it
+// in fixed memory, within about 1% for any footprint.
+#define FOOTPRINT_HLL_BITS 14
+
+class FOOTPRINT {
+    bool approximate;
+    std::vector<uint64_t> lines;
+    SLOT_INDEX line_index;
+    std::vector<uint8_t> registers;
+
+  public:
+    FOOTPRINT() : approximate(false), line_index(lines) {};
+
+    void initialize(bool approximate);
+    void add(uint64_t line);
+    uint64_t count() const;
+
+    void checkpoint(CHECKPOINT_FILE &checkpoint);
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef PARALLEL_SIM_H
+#define PARALLEL_SIM_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "memory_class.h"
+
+// PARALLEL SIMULATION
+// every core runs with its private caches and TLBs on its own thread, the LLC and DRAM stay on
+// the main thread. The cores and the uncore take turns every quantum: the cores simulate
+// parallel_quantum cycles, then the uncore catches up over the same cycles. A quantum is cut
+// short when a core could otherwise run past its heartbeat, end of warmup or end of simulation.
+// With a quantum of one cycle the outcome does not depend on thread timing. Longer quanta
+// synchronize less often, so LLC requests are seen up to a quantum late.
+
+// stands in for the LLC as the lower level of an L2C while the cores run in parallel.
+// Requests are buffered and handed to the LLC in the uncore's turn, in the cycle they were
+// issued. Each core gets a deterministic share of the free LLC queue entries per quantum,
+// so the buffered requests always fit.
+class UNCORE_PORT : public MEMORY {
+    struct PORT_REQUEST {
+        uint8_t  queue_type;
+        uint64_t cycle;
+        PACKET   packet;
+    };
+
+    std::vector<PORT_REQUEST> requests;
+    uint32_t next_request, wq_full;
+
+    // granted and used entries of RQ (1), WQ (2) and PQ (3)
+    uint32_t granted[4], used[4];
+
+    int buffer_request(uint8_t queue_type, PACKET *packet);
+
+  public:
+    uint32_t cpu;
+    MEMORY *llc;
+
+    UNCORE_PORT();
+
+    int  add_rq(PACKET *packet) { return buffer_request(1, packet); };
+    int  add_wq(PACKET *packet) { return buffer_request(2, packet); };
+    int  add_pq(PACKET *packet) { return buffer_request(3, packet); };
+    void return_data(PACKET *packet);
+    void operate() {};
+    void increment_WQ_FULL(uint64_t address) { wq_full++; };
+
+    uint32_t get_occupancy(uint8_t queue_type, uint64_t address),
+             get_size(uint8_t queue_type, uint64_t address);
+
+    // splits the free LLC queue entries among num_ports ports for the next quantum
+    void grant(uint32_t rank, uint32_t num_ports);
+
+    // hands the requests issued up to this core cycle to the LLC
+    void drain(uint64_t cycle);
+};
+
+// runs a quantum of every core, cores 1 and up on worker threads and core 0 on the calling thread
+class CORE_THREADS {
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> generation;
+    std::atomic<uint32_t> finished;
+    std::atomic<bool> stopping;
+    uint64_t quantum_cycles;
+    void (*run_core)(uint32_t cpu, uint64_t cycles);
+
+    void worker_loop(uint32_t cpu);
+
+  public:
+    CORE_THREADS() : generation(0), finished(0), stopping(false), quantum_cycles(0), run_core(NULL) {};
+    ~CORE_THREADS() { stop(); };
+
+    void start(void (*core_function)(uint32_t cpu, uint64_t cycles)),
+         run(uint64_t cycles),
+         stop();
+};
+
+// guards state shared by all cores, like the page table. In a deterministic quantum a core only
+// touches it once every core ahead of it in this cycle's traversal order has finished the cycle,
+// otherwise the accesses are just serialized by the lock.
+class SHARED_ACCESS {
+    uint32_t cpu;
+    std::mutex &lock;
+
+  public:
+    SHARED_ACCESS(uint32_t cpu, std::mutex &lock);
+    ~SHARED_ACCESS();
+};
+
+extern std::mutex page_table_mutex;
+
+// set by the main loop for the parallel mode
+extern bool parallel_running, parallel_deterministic;
+extern uint32_t parallel_position[NUM_CPUS];
+extern std::atomic<uint64_t> parallel_finished_cycle[NUM_CPUS];
+
+#endif
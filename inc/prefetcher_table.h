@@ -0,0 +1,98 @@
+#ifndef PREFETCHER_TABLE_H
+#define PREFETCHER_TABLE_H
+
+#include <vector>
+#include "tag_store.h"
+
+/*
+ * A fixed-capacity set-associative table for prefetcher metadata.
+ * All entries are allocated once, and looked up through a TAG_STORE,
+ * so a lookup compares one packed row of tags and inserting or evicting
+ * an entry never touches the heap.
+ * Touching a way stamps it with a counter of the table, so the LRU way
+ * of a set is the valid way with the oldest stamp and a touch costs
+ * O(1) instead of aging every other entry.
+ * A table with a single set is fully associative.
+ */
+template <class T>
+class PrefetcherTable
+{
+private:
+	TAG_STORE tags;
+	std::vector<T> entries;
+	std::vector<uint64_t> stamps;
+	std::vector<uint8_t> valid;
+	std::vector<uint32_t> occupancy;
+	uint32_t sets, ways;
+	uint64_t clock;
+
+	size_t slot(uint32_t set, uint32_t way) {return (size_t)set * ways + way;}
+
+public:
+	PrefetcherTable() : sets(0), ways(0), clock(0) {}
+	~PrefetcherTable() {}
+
+	void init(uint32_t sets, uint32_t ways)
+	{
+		this->sets = sets;
+		this->ways = ways;
+		clock = 0;
+		tags.resize(sets, ways);
+		entries.assign((size_t)sets * ways, T());
+		stamps.assign((size_t)sets * ways, 0);
+		valid.assign((size_t)sets * ways, 0);
+		occupancy.assign(sets, 0);
+	}
+
+	uint32_t num_ways() {return ways;}
+	T& entry(uint32_t set, uint32_t way) {return entries[slot(set, way)];}
+	bool is_valid(uint32_t set, uint32_t way) {return valid[slot(set, way)];}
+	bool full(uint32_t set) {return occupancy[set] == ways;}
+	uint64_t stamp(uint32_t set, uint32_t way) {return stamps[slot(set, way)];}
+
+	/* way holding the tag, num_ways() if none does */
+	uint32_t find(uint32_t set, uint64_t tag) {return tags.find(set, tag);}
+
+	/* lowest invalid way, num_ways() if the set is full */
+	uint32_t find_invalid(uint32_t set) {return tags.find_invalid(set);}
+
+	/* valid way touched least recently, num_ways() if the set is empty */
+	uint32_t find_lru(uint32_t set)
+	{
+		uint32_t victim = ways;
+		for(uint32_t way = 0; way < ways; ++way)
+		{
+			if(valid[slot(set, way)] && (victim == ways || stamps[slot(set, way)] < stamps[slot(set, victim)]))
+			{
+				victim = way;
+			}
+		}
+		return victim;
+	}
+
+	/* makes the way valid with the given tag and touches it */
+	void insert(uint32_t set, uint32_t way, uint64_t tag)
+	{
+		if(!valid[slot(set, way)])
+		{
+			valid[slot(set, way)] = 1;
+			occupancy[set]++;
+		}
+		tags.set(set, way, tag);
+		touch(set, way);
+	}
+
+	void erase(uint32_t set, uint32_t way)
+	{
+		if(valid[slot(set, way)])
+		{
+			valid[slot(set, way)] = 0;
+			occupancy[set]--;
+		}
+		tags.invalidate(set, way);
+	}
+
+	void touch(uint32_t set, uint32_t way) {stamps[slot(set, way)] = ++clock;}
+};
+
+#endif /* PREFETCHER_TABLE_H */
@@ -0,0 +1,93 @@
+#ifndef QTABLE_H
+#define QTABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <assert.h>
+
+class CHECKPOINT_FILE;
+
+/* a row holds the Q-values of one state (or tile) for all columns (usually actions).
+ * Rows are padded to a multiple of this many entries, so they are summed with whole vectors */
+#define QTABLE_ROW_ALIGN 8
+
+/* formats a Q-value can be stored in:
+ * float   - single precision, the default
+ * fp16    - IEEE half precision
+ * int16   - signed fixed point with le_qtable_frac_bits fractional bits, saturating */
+typedef enum
+{
+	QTableFloat = 0,
+	QTableFP16,
+	QTableFixed16,
+
+	NumQTableStorages
+} QTableStorage;
+
+const char* MapQTableStorageString(QTableStorage storage);
+QTableStorage parseQTableStorage(std::string str);
+
+uint16_t float_to_half(float value);
+float half_to_float(uint16_t value);
+
+/* one contiguous, 64B aligned Q-table shared by all learning engines */
+class QTable
+{
+private:
+	uint32_t m_rows, m_columns;
+	uint32_t m_row_size; /* padded */
+	QTableStorage m_storage;
+	uint32_t m_frac_bits;
+	float m_scale, m_inv_scale; /* int16 only */
+	float m_init_value; /* as read back from the table */
+	void *m_table;
+
+	inline size_t position(uint32_t row, uint32_t column) const {return (size_t)row * m_row_size + column;}
+	int16_t to_fixed(float value) const;
+
+public:
+	QTable(uint32_t rows, uint32_t columns, float init_value, QTableStorage storage = QTableFloat, uint32_t frac_bits = 0);
+	~QTable();
+
+	inline float get(uint32_t row, uint32_t column) const
+	{
+		assert(row < m_rows && column < m_columns);
+		switch(m_storage)
+		{
+			case QTableFloat:	return ((const float*)m_table)[position(row, column)];
+			case QTableFP16:	return half_to_float(((const uint16_t*)m_table)[position(row, column)]);
+			default:			return (float)((const int16_t*)m_table)[position(row, column)] * m_inv_scale;
+		}
+	}
+	inline void set(uint32_t row, uint32_t column, float value)
+	{
+		assert(row < m_rows && column < m_columns);
+		switch(m_storage)
+		{
+			case QTableFloat:	((float*)m_table)[position(row, column)] = value; break;
+			case QTableFP16:	((uint16_t*)m_table)[position(row, column)] = float_to_half(value); break;
+			default:			((int16_t*)m_table)[position(row, column)] = to_fixed(value); break;
+		}
+	}
+
+	/* sums[column] = scale * sum of the column over the given rows, added up in the order of the rows.
+	 * Fills all get_row_size() entries of sums, the padding sums up to zero */
+	void sum_rows(const uint32_t *rows, uint32_t num_rows, float *sums, float scale = 1.0) const;
+	inline void get_row(uint32_t row, float *values) const {sum_rows(&row, 1, values);}
+
+	inline uint32_t get_rows() const {return m_rows;}
+	inline uint32_t get_columns() const {return m_columns;}
+	inline uint32_t get_row_size() const {return m_row_size;}
+	inline QTableStorage get_storage() const {return m_storage;}
+	inline float get_init_value() const {return m_init_value;}
+
+	/* the raw table */
+	inline void* data() {return m_table;}
+	size_t bytes() const;
+
+	/* saves or restores the Q-values, the geometry and the storage format have to match */
+	void checkpoint(CHECKPOINT_FILE &checkpoint);
+};
+
+#endif /* QTABLE_H */
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 #include "champsim.h"
 #include "cache.h"
 #include "prefetcher.h"
@@ -12,6 +13,7 @@
 #include "learning_engine_cmac2.h"
 #include "learning_engine_featurewise.h"
 #include "shaggy.h"
+#include "heavy_hitters.h"
 
 using namespace std;
 
@@ -26,12 +28,29 @@ class LearningEngine;
 class Scooby : public Prefetcher
 {
 private:
-	deque<Scooby_STEntry*> signature_table;
+	/* signature table: a pool of scooby_st_size entries on an LRU list, indexed by page */
+	vector<Scooby_STEntry*> st_entries;
+	vector<uint32_t> st_prev, st_next;
+	uint32_t st_count;
+	QUEUE_INDEX st_index;
 	LearningEngineBasic *brain;
 	LearningEngineCMAC *brain_cmac;
 	LearningEngineCMAC2 *brain_cmac2;
 	LearningEngineFeaturewise *brain_featurewise;
-	deque<Scooby_PTEntry*> prefetch_tracker;
+	static uint32_t num_instances;
+	uint32_t instance_id; /* one per core */
+	uint32_t cpu;
+	/* with scooby_share_brain, the first instance creates the learning engine and the others use it */
+	static Scooby *brain_owner;
+	static std::mutex shared_brain_lock;
+	inline bool owns_brain() {return brain_owner == NULL || brain_owner == this;}
+	/* prefetch tracker: a FIFO of scooby_pt_size slots over a pool that also holds the last evicted entry.
+	 * Entries with the same address are on a circular list, oldest first, and the index points at the oldest */
+	vector<Scooby_PTEntry> pt_pool;
+	vector<uint32_t> pt_fifo, pt_free;
+	vector<uint32_t> pt_prev, pt_next;
+	uint32_t pt_head, pt_count;
+	QUEUE_INDEX pt_index;
 	Scooby_PTEntry *last_evicted_tracker;
 	Shaggy *shaggy;
 	uint8_t bw_level;
@@ -42,9 +61,6 @@ private:
 	 * has nothing to do with prefetching */
 	ScoobyRecorder *recorder;
 
-	/* Data structures for debugging */
-	unordered_map<string, uint64_t> target_action_state;
-
 	/* to manipulate dynamic degree */
 	DegreeDetector *deg_detector;
 	unordered_map<int32_t, uint32_t> global_action_tracker;
@@ -163,9 +179,10 @@ private:
 		} cache_acc;
 	} stats;
 
-	unordered_map<uint32_t, vector<uint64_t> > state_action_dist;
-	unordered_map<std::string, vector<uint64_t> > state_action_dist2;
-	unordered_map<int32_t, vector<uint64_t> > action_deg_dist;
+	/* bounded state-action stats, NULL unless scooby_enable_state_action_stats */
+	HeavyHitters *state_action_stats;
+	uint64_t state_action_stats_calls;
+	vector<uint64_t> action_deg_dist; /* scooby_max_actions x MAX_SCOOBY_DEGREE */
 
 private:
 	void init_knobs();
@@ -173,6 +190,9 @@ private:
 
 	void update_global_state(uint64_t pc, uint64_t page, uint32_t offset, uint64_t address);
 	Scooby_STEntry* update_local_state(uint64_t pc, uint64_t page, uint32_t offset, uint64_t address);
+	Scooby_STEntry* search_st(uint64_t page);
+	void st_unlink(uint32_t index);
+	void st_push_mru(uint32_t index);
 	uint32_t predict(uint64_t address, uint64_t page, uint32_t offset, State *state, vector<uint64_t> &pref_addr);
 	bool track(uint64_t address, State *state, uint32_t action_index, Scooby_PTEntry **tracker);
 	void reward(uint64_t address);
@@ -183,6 +203,7 @@ private:
 	vector<Scooby_PTEntry*> search_pt(uint64_t address, bool search_all = false);
 	void update_stats(uint32_t state, uint32_t action_index, uint32_t pref_degree = 1);
 	void update_stats(State *state, uint32_t action_index, uint32_t degree = 1);
+	bool sample_state_action_stats();
 	void track_in_st(uint64_t page, uint32_t pred_offset, int32_t pref_offset);
 	void gen_multi_degree_pref(uint64_t page, uint32_t offset, int32_t action, uint32_t pref_degree, vector<uint64_t> &pref_addr);
 	uint32_t get_dyn_pref_degree(float max_to_avg_q_ratio, uint64_t page = 0xdeadbeef, int32_t action = 0); /* only implemented for CMAC engine 2.0 */
@@ -190,9 +211,10 @@ private:
 	void print_global_action_tracker();
 	void lookup_global_action_tracker(Scooby_STEntry *stentry);
 	bool is_high_bw();
+	void checkpoint_brain(string file_name, uint8_t restore); /* saves or loads the trained learning engine */
 
 public:
-	Scooby(string type);
+	Scooby(string type, uint32_t cpu = 0);
 	~Scooby();
 	void invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cache_hit, uint8_t type, vector<uint64_t> &pref_addr);
 	void register_fill(uint64_t address);
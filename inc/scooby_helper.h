@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
+#include <bitset>
 #include "bitmap.h"
 #include "bf/all.hpp"
 
@@ -86,6 +87,9 @@ public:
 	uint32_t value(); /* apply as many state types as you want */
 	uint32_t get_hash(uint64_t value); /* play wild with hashes */
 	std::string to_string();
+	/* pc, offset and delta packed into one number, printed like to_string() */
+	uint64_t stats_key();
+	static std::string stats_key_to_string(uint64_t key);
 };
 
 class ActionTracker
@@ -93,59 +97,107 @@ class ActionTracker
 public:
 	int32_t action;
 	uint32_t conf;
+	ActionTracker() : action(0), conf(0) {}
 	ActionTracker(int32_t act, uint32_t c) : action(act), conf(c) {}
 	~ActionTracker() {}
 };
 
+/* history of a page is kept inline, so the knobs that size it are bounded by these */
+#define SCOOBY_ST_MAX_PCS 8
+#define SCOOBY_ST_MAX_OFFSETS 32
+#define SCOOBY_ST_MAX_DELTAS 32
+#define SCOOBY_ST_MAX_UNIQUE_PCS 8
+#define SCOOBY_ST_MAX_ACTION_TRACKER 8
+
+/* last few values seen on a page, oldest first. N is a power of two */
+template <class T, uint32_t N>
+class HistoryRing
+{
+private:
+	T items[N];
+	uint32_t head, count;
+
+public:
+	HistoryRing() : head(0), count(0) {}
+	void clear() { head = 0; count = 0; }
+	uint32_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T front() const { return items[head]; }
+	T back() const { return items[(head + count - 1) & (N - 1)]; }
+	T operator[](uint32_t index) const { return items[(head + index) & (N - 1)]; }
+	/* drops the oldest value once max_size values are held */
+	void push_back(T value, uint32_t max_size)
+	{
+		if(count >= max_size)
+		{
+			head = (head + 1) & (N - 1);
+			count--;
+		}
+		items[(head + count) & (N - 1)] = value;
+		count++;
+	}
+};
+
+/* set of deltas within a page, which also covers the prefetch actions */
+class DeltaSet
+{
+private:
+	bitset<128> bits;
+
+public:
+	void clear() { bits.reset(); }
+	void insert(int32_t delta) { bits[delta + 64] = 1; }
+	bool contains(int32_t delta) const { return (delta > -64 && delta < 64) && bits[delta + 64]; }
+	uint32_t size() const { return bits.count(); }
+	bool empty() const { return bits.none(); }
+};
+
 class Scooby_STEntry
 {
 public:
 	uint64_t page;
-	deque<uint64_t> pcs;
-	deque<uint32_t> offsets;
-	deque<int32_t> deltas;
+	HistoryRing<uint64_t, SCOOBY_ST_MAX_PCS> pcs;
+	HistoryRing<uint8_t, SCOOBY_ST_MAX_OFFSETS> offsets;
+	HistoryRing<int8_t, SCOOBY_ST_MAX_DELTAS> deltas;
 	Bitmap bmp_real;
 	Bitmap bmp_pred;
-	unordered_set <uint64_t> unique_pcs;
-	unordered_set <int32_t> unique_deltas;
+	/* only filled for scooby_access_debug, saturates at SCOOBY_ST_MAX_UNIQUE_PCS */
+	uint64_t unique_pcs[SCOOBY_ST_MAX_UNIQUE_PCS];
+	uint32_t num_unique_pcs;
+	DeltaSet unique_deltas;
 	uint64_t trigger_pc;
 	uint32_t trigger_offset;
 	bool streaming;
 	// int32_t last_pref_offset;
 	// uint32_t last_pref_offset_conf;
 
-	/* tracks last n actions on a page to determine degree */
-	deque<ActionTracker*> action_tracker;
-	unordered_set<int32_t> action_with_max_degree;
-	unordered_set<int32_t> afterburning_actions;
+	/* signatures of the last four deltas, PCs and offsets, updated on every access */
+	uint32_t delta_sig, delta_sig2, pc_sig, offset_sig;
+
+	/* tracks last n actions on a page to determine degree, least recently used first */
+	ActionTracker action_tracker[SCOOBY_ST_MAX_ACTION_TRACKER];
+	uint32_t num_action_trackers;
+	DeltaSet action_with_max_degree;
+	DeltaSet afterburning_actions;
 
 	uint32_t total_prefetches;
 
+private:
+	void record_unique_pc(uint64_t pc);
+
 public:
-	Scooby_STEntry(uint64_t p, uint64_t pc, uint32_t offset) : page(p)
+	Scooby_STEntry(uint64_t p, uint64_t pc, uint32_t offset)
 	{
-		pcs.clear();
-		offsets.clear();
-		deltas.clear();
-		bmp_real.reset();
-		unique_pcs.clear();
-		unique_deltas.clear();
-		trigger_pc = pc;
-		trigger_offset = offset;
-		streaming = false;
-		// last_pref_offset = 0;
-		// last_pref_offset_conf = 0;
-
-		pcs.push_back(pc);
-		offsets.push_back(offset);
-		unique_pcs.insert(pc);
-		bmp_real[offset] = 1;
+		reset(p, pc, offset);
 	}
 	~Scooby_STEntry(){}
+	/* entries of the signature table are reused for new pages */
+	void reset(uint64_t page, uint64_t pc, uint32_t offset);
 	uint32_t get_delta_sig();
 	uint32_t get_delta_sig2();
 	uint32_t get_pc_sig();
 	uint32_t get_offset_sig();
+	bool has_unique_pc(uint64_t pc);
 	void update(uint64_t page, uint64_t pc, uint32_t offset, uint64_t address);
 	void track_prefetch(uint32_t offset, int32_t pref_offset);
 	void insert_action_tracker(int32_t pref_offset);
@@ -156,7 +208,7 @@ class Scooby_PTEntry
 {
 public:
 	uint64_t address;
-	State *state;
+	State state; /* a snapshot, kept inline so that training reads it directly */
 	uint32_t action_index;
 	/* set when prefetched line is filled into cache 
 	 * check during reward to measure timeliness */
@@ -169,13 +221,20 @@ public:
 	bool has_reward;
 	vector<bool> consensus_vec; // only used in featurewise engine
 	
-	Scooby_PTEntry(uint64_t ad, State *st, uint32_t ac) : address(ad), state(st), action_index(ac)
+	Scooby_PTEntry() : Scooby_PTEntry(0, State(), 0) {}
+	Scooby_PTEntry(uint64_t ad, const State &st, uint32_t ac) {reset(ad, st, ac);}
+	/* reuses the entry for a new prefetch */
+	void reset(uint64_t ad, const State &st, uint32_t ac)
 	{
+		address = ad;
+		state = st;
+		action_index = ac;
 		is_filled = false;
 		pf_cache_hit = false;
 		reward = 0;
 		reward_type = RewardType::none;
 		has_reward = false;
+		consensus_vec.clear();
 	}
 	~Scooby_PTEntry(){}
 };
@@ -137,6 +137,10 @@ public:
 
 	~fastset (void) { }
 
+	// empty the set so it can be reused
+
+	void clear (void) { card = 0; }
+
 	// insert a value into the set
 
 	void insert (TYPE x) {
@@ -207,9 +211,9 @@ public:
 			assert (other.card >= SMALL_SIZE);
 		}
 
-		// lim is the next multiple of 64
+		// lim is the number of 64 bit words holding values below n
 
-		int lim = ((n | 63) + 1) / 64;
+		int lim = (n + 63) / 64;
 
 		// bitwise OR the other bits into this set
 		for (int i=0; i<lim; i++) data.bits[i] |= other.data.bits[i];
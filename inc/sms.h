@@ -5,6 +5,7 @@
 #include <deque>
 #include "bitmap.h"
 #include "prefetcher.h"
+#include "prefetcher_table.h"
 
 using namespace std;
 
@@ -33,7 +34,6 @@ public:
 	uint64_t pc;
 	uint32_t trigger_offset;
 	Bitmap pattern;
-	uint32_t age;
 
 public:
 	void reset()
@@ -41,7 +41,6 @@ public:
 		page = pc = 0xdeadbeef;
 		trigger_offset = 0;
 		pattern.reset();
-		age = 0;
 	}
 	ATEntry(){reset();}
 	~ATEntry(){}
@@ -52,14 +51,14 @@ class PHTEntry
 public:
 	uint64_t signature;
 	Bitmap pattern;
-	uint32_t age;
+	uint64_t inserted; /* insertion order within the PHT */
 
 public:
 	void reset()
 	{
 		signature = 0xdeadbeef;
 		pattern.reset();
-		age = 0;
+		inserted = 0;
 	}
 	PHTEntry(){reset();}
 	~PHTEntry(){}
@@ -68,9 +67,11 @@ public:
 class SMSPrefetcher : public Prefetcher
 {
 private:
-	deque<FTEntry*> filter_table;
-	deque<ATEntry*> acc_table;
-	vector<deque<PHTEntry*> > pht;
+	PrefetcherTable<FTEntry> filter_table;
+	PrefetcherTable<ATEntry> acc_table;
+	PrefetcherTable<PHTEntry> pht;
+	vector<uint64_t> pht_reset; /* stamp of the latest insertion into every PHT set */
+	uint64_t pht_inserted;
 	uint32_t pht_sets;
 	deque<uint64_t> pref_buffer;
 
@@ -116,21 +117,21 @@ private:
 	void init_knobs();
 	void init_stats();
 
-	deque<FTEntry*>::iterator search_filter_table(uint64_t page);
-	deque<FTEntry*>::iterator search_victim_filter_table();
-	void evict_filter_table(deque<FTEntry*>::iterator victim);
+	uint32_t search_filter_table(uint64_t page);
+	uint32_t search_victim_filter_table();
+	void evict_filter_table(uint32_t victim);
 	void insert_filter_table(uint64_t pc, uint64_t page, uint32_t offset);
 
-	deque<ATEntry*>::iterator search_acc_table(uint64_t page);
-	deque<ATEntry*>::iterator search_victim_acc_table();
-	void evict_acc_table(deque<ATEntry*>::iterator victim);
-	void update_age_acc_table(deque<ATEntry*>::iterator current);
+	uint32_t search_acc_table(uint64_t page);
+	uint32_t search_victim_acc_table();
+	void evict_acc_table(uint32_t victim);
+	void update_age_acc_table(uint32_t current);
 	void insert_acc_table(FTEntry *ftentry, uint32_t offset);
 	
-	deque<PHTEntry*>::iterator search_pht(uint64_t signature, int32_t *set);
-	deque<PHTEntry*>::iterator search_victim_pht(int32_t set);
-	void evcit_pht(int32_t set, deque<PHTEntry*>::iterator victim);
-	void update_age_pht(int32_t set, deque<PHTEntry*>::iterator current);
+	uint32_t search_pht(uint64_t signature, int32_t *set);
+	uint32_t search_victim_pht(int32_t set);
+	void evcit_pht(int32_t set, uint32_t victim);
+	void update_age_pht(int32_t set, uint32_t current);
 	void insert_pht_table(ATEntry *atentry);
 
 	uint64_t create_signature(uint64_t pc, uint32_t offset);
@@ -4,6 +4,9 @@
 #include <deque>
 #include <vector>
 #include "prefetcher.h"
+#include "prefetcher_table.h"
+
+#define SPP_MAX_OUTCOMES 16
 
 using namespace std;
 
@@ -13,7 +16,6 @@ public:
 	uint64_t page;
 	uint32_t last_offset;
 	uint64_t signature;
-	uint32_t age;
 
 public:
 	void reset()
@@ -21,7 +23,6 @@ public:
 		page = 0xdeadbeef;
 		last_offset = 0;
 		signature = 0xdeadbeef;
-		age = 0;
 	}
 	STEntry(){reset();}
 	~STEntry(){}
@@ -49,8 +50,9 @@ class PTEntry
 public:
 	uint64_t signature;
 	uint64_t occurence;
-	deque<Outcome*> outcomes;
-	uint32_t age;
+	Outcome outcomes[SPP_MAX_OUTCOMES]; /* sorted by decreasing occurence */
+	uint32_t num_outcomes;
+	uint64_t inserted; /* insertion order within the pattern table */
 	string to_string();
 
 public:
@@ -58,8 +60,8 @@ public:
 	{
 		signature = 0xdeadbeef;
 		occurence = 0;
-		outcomes.clear();
-		age = 0;
+		num_outcomes = 0;
+		inserted = 0;
 	}
 	PTEntry(){reset();}
 	~PTEntry(){}
@@ -108,11 +110,16 @@ public:
 class SPP : public Prefetcher
 {
 private:
-	deque<STEntry*> signature_table;
-	deque<PTEntry*> pattern_table; /* TODO: make it set associative */
-	deque<PFEntry*> prefetch_filter;
+	/* all tables are fully associative */
+	PrefetcherTable<STEntry> signature_table;
+	PrefetcherTable<PTEntry> pattern_table;
+	uint32_t pt_oldest; /* way of the oldest pattern table entry */
+	uint64_t pt_inserted;
+	PrefetcherTable<PFEntry> prefetch_filter;
+	uint32_t pf_next; /* way after the latest insertion, the oldest once the filter is full */
 	deque<uint64_t> pref_buffer;
-	deque<GHREntry*> ghr;
+	vector<GHREntry> ghr; /* ring of the latest spp_ghr_size entries */
+	uint32_t ghr_head, ghr_count;
 
 	double alpha;
 	uint64_t total_pref, used_pref, demand_counter;
@@ -183,23 +190,23 @@ private:
 	void init_knobs();
 	void init_stats();
 
-	deque<STEntry*>::iterator search_signature_table(uint64_t page);
-	void update_age_signature_table(deque<STEntry*>::iterator st_index);
+	uint32_t search_signature_table(uint64_t page);
+	void update_age_signature_table(uint32_t st_index);
 	void insert_signature_table(uint64_t page, uint32_t offset, uint64_t signature);
-	deque<STEntry*>::iterator search_victim_signature_table();
-	void evict_signature_table(deque<STEntry*>::iterator victim);
+	uint32_t search_victim_signature_table();
+	void evict_signature_table(uint32_t victim);
 
 	void update_pattern_table(uint64_t signature, int32_t delta);
 	void insert_pattern_table(uint64_t signature, int32_t delta);
-	deque<PTEntry*>::iterator search_pattern_table(uint64_t signature);
-	deque<PTEntry*>::iterator search_victim_pattern_table();
-	void evict_pattern_table(deque<PTEntry*>::iterator victim);
-	void update_age_pattern_table(deque<PTEntry*>::iterator pt_index);
+	uint32_t search_pattern_table(uint64_t signature);
+	uint32_t search_victim_pattern_table();
+	void evict_pattern_table(uint32_t victim);
+	void update_age_pattern_table(uint32_t pt_index);
 
-	deque<PFEntry*>::iterator search_prefetch_filter(uint64_t address);
+	uint32_t search_prefetch_filter(uint64_t address);
 	void insert_prefetch_filter(uint64_t address, bool from_ghr);
-	deque<PFEntry*>::iterator search_victim_prefetch_filter();
-	void evict_prefetch_filter(deque<PFEntry*>::iterator victim);
+	uint32_t search_victim_prefetch_filter();
+	void evict_prefetch_filter(uint32_t victim);
 	void register_demand_hit(uint64_t address);
 
 	void generate_prefetch(uint64_t page, uint32_t offset, uint64_t signature, double confidence, vector<uint64_t> &pref_addr, bool from_ghr);
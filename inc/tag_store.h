@@ -0,0 +1,77 @@
+#ifndef TAG_STORE_H
+#define TAG_STORE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <iostream>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// TAG STORE
+// the tags of a cache packed set by set, so a lookup compares one contiguous row of 64-bit words
+// instead of walking the BLOCKs, which keep the rest of the metadata. An invalid way holds
+// INVALID_TAG, so the valid bit and the tag are checked with a single compare.
+// The compare uses AVX2 when the simulator is built for it (e.g. -march=native) and SSE2 otherwise.
+#define INVALID_TAG UINT64_MAX
+
+class TAG_STORE {
+    uint64_t *tags;
+    uint32_t num_way;
+
+  public:
+    TAG_STORE() : tags(NULL), num_way(0) {};
+    ~TAG_STORE() { free(tags); };
+
+    // every way starts out invalid
+    void resize(uint32_t num_set, uint32_t num_way) {
+        free(tags);
+        this->num_way = num_way;
+        if (posix_memalign((void **)&tags, 64, (size_t)num_set * num_way * sizeof(uint64_t)) != 0) {
+            std::cerr << "[TAG_STORE] cannot allocate " << num_set << " sets of " << num_way << " ways ***" << std::endl;
+            assert(0);
+        }
+        for (size_t i=0; i<(size_t)num_set*num_way; i++)
+            tags[i] = INVALID_TAG;
+    };
+
+    void set(uint32_t set, uint32_t way, uint64_t tag) { tags[(size_t)set*num_way + way] = tag; };
+    void invalidate(uint32_t set, uint32_t way) { tags[(size_t)set*num_way + way] = INVALID_TAG; };
+
+    // lowest way that holds the tag, num_way if none does
+    uint32_t find(uint32_t set, uint64_t tag) const {
+        const uint64_t *row = tags + (size_t)set*num_way;
+        uint32_t way = 0;
+#if defined(__AVX2__)
+        __m256i key = _mm256_set1_epi64x(tag);
+        for (; way+4 <= num_way; way+=4) {
+            __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(row + way)), key);
+            int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+            if (mask)
+                return way + __builtin_ctz(mask);
+        }
+#elif defined(__SSE2__)
+        // SSE2 only compares 32-bit words, a 64-bit tag matches if both of its halves do
+        __m128i key = _mm_set1_epi64x(tag);
+        for (; way+2 <= num_way; way+=2) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(row + way)), key);
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+            int mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+            if (mask)
+                return way + __builtin_ctz(mask);
+        }
+#endif
+        for (; way<num_way; way++) {
+            if (row[way] == tag)
+                return way;
+        }
+        return num_way;
+    };
+
+    // lowest invalid way, num_way if the set is full
+    uint32_t find_invalid(uint32_t set) const { return find(set, INVALID_TAG); };
+};
+
+#endif
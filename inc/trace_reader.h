@@ -0,0 +1,132 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "instruction.h"
+
+// TRACE READER
+// instructions are decoded on a background thread into batches,
+// and the core consumes them from a small ring of batches
+#define TRACE_BATCH_SIZE 1024
+#define TRACE_RING_SIZE 8
+#define TRACE_STREAM_BUFFER_SIZE (1 << 20)
+
+// byte stream of a (possibly compressed) trace file
+class TRACE_STREAM {
+  public:
+    virtual ~TRACE_STREAM() {};
+
+    // read up to len bytes, returns the number of bytes read (0 at end of trace)
+    virtual size_t read(void *buf, size_t len) = 0;
+
+    // go back to the beginning of the trace
+    virtual void rewind() = 0;
+
+    // read exactly len bytes, returns 0 if the trace ends before that
+    bool read_all(void *buf, size_t len);
+};
+
+// picks the decompressor from the magic bytes of the file, or reads from the cache if the trace is cached
+TRACE_STREAM *open_trace_stream(const char *trace_name);
+
+// decompresses up to max_bytes of the trace into memory that later streams of the same trace read
+// from, including those of forked processes. Returns the number of bytes cached.
+// Different traces can be cached from several threads, but before any stream is opened.
+uint64_t cache_trace(const char *trace_name, uint64_t max_bytes);
+
+// decodes trace records into the performance model's instruction format
+class TRACE_DECODER {
+  public:
+    virtual ~TRACE_DECODER() {};
+
+    // decodes the next instruction, returns 0 at the end of the trace
+    virtual bool decode_instr(ooo_model_instr *arch_instr) = 0;
+
+    // go back to the beginning of the trace
+    virtual void rewind() = 0;
+
+    // skips up to num_instrs instructions without decoding them into the performance model,
+    // returns the number skipped before the end of the trace
+    virtual uint64_t skip(uint64_t num_instrs);
+};
+
+// the original format, a stream of input_instr (or cloudsuite_instr) records
+class LEGACY_TRACE_DECODER : public TRACE_DECODER {
+    uint32_t cpu;
+    uint8_t cloudsuite;
+    TRACE_STREAM *stream;
+
+  public:
+    LEGACY_TRACE_DECODER(uint32_t cpu, const char *trace_name, uint8_t cloudsuite);
+    ~LEGACY_TRACE_DECODER();
+
+    bool decode_instr(ooo_model_instr *arch_instr);
+    void rewind();
+    uint64_t skip(uint64_t num_instrs);
+};
+
+// fills in the virtual addresses and operand counts once the registers and memory operands are decoded
+void finish_instr_decode(ooo_model_instr *arch_instr);
+
+class TRACE_BATCH {
+  public:
+    ooo_model_instr instr[TRACE_BATCH_SIZE];
+    uint32_t size;
+    uint8_t  repeat; // the trace was restarted right before this batch
+};
+
+class TRACE_READER {
+  public:
+    uint32_t cpu;
+    std::string trace_string;
+
+    TRACE_READER(uint32_t cpu, const char *trace_name, TRACE_DECODER *decoder);
+    ~TRACE_READER();
+
+    // returns the next decoded instruction, valid until the next call
+    ooo_model_instr *next_instr() {
+        if ((current == NULL) || (read_index == current->size))
+            next_batch();
+
+        return &current->instr[read_index++];
+    }
+
+    // fast-forwards past num_instrs instructions (repeating the trace if needed), must be called before start()
+    void skip(uint64_t num_instrs);
+
+    // starts the decode thread
+    void start();
+
+    // set while the core runs on a thread of its own, the trace repeats are then counted
+    // instead of printed, and report_repeats() prints them from the main thread
+    uint8_t defer_repeats;
+    void report_repeats();
+
+  private:
+    TRACE_DECODER *decoder;
+    TRACE_BATCH *ring, *current;
+    uint32_t read_index, read_slot, write_slot, filled;
+    uint8_t stop;
+    uint32_t unreported_repeats;
+
+    std::mutex lock;
+    std::condition_variable not_empty, not_full;
+    std::thread worker;
+
+    void next_batch(),
+         fill_batch(TRACE_BATCH *batch, uint8_t &repeat),
+         decode_loop(),
+         print_repeat();
+};
+
+// opens the trace with the decoder that matches its format, the caller starts the decode thread
+TRACE_READER *open_trace_reader(uint32_t cpu, const char *trace_name, uint8_t cloudsuite);
+
+#endif
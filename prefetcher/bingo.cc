@@ -24,6 +24,7 @@ namespace knob
 
 void Bingo::init_knobs() {
    assert((knob::bingo_region_size >> LOG2_BLOCK_SIZE) == knob::bingo_pattern_len);
+   assert(knob::bingo_pattern_len <= BINGO_MAX_PATTERN_LEN);
 }
 
 void Bingo::init_stats() {
@@ -238,7 +239,8 @@ vector<int> Bingo::find_in_pht(uint64_t pc, uint64_t address) {
    if (this->debug_level >= 2) {
       cerr << "[Bingo] find_in_pht(pc=0x" << hex << pc << ", address=0x" << address << ")" << dec << endl;
    }
-   vector<vector<bool>> matches = this->pht.find(pc, address);
+   vector<BingoPattern> &matches = this->pht_matches;
+   this->pht.find(pc, address, matches);
    this->pht_access_cnt += 1;
    Event pht_last_event = this->pht.get_last_event();
    uint64_t region_number = address / this->pattern_len;
@@ -248,7 +250,6 @@ vector<int> Bingo::find_in_pht(uint64_t pc, uint64_t address) {
    if (pht_last_event == PC_ADDRESS) {
       this->pht_pc_address_cnt += 1;
       // assert(matches.size() == 1); /* there can only be 1 PC+Address match */
-      // assert(matches[0].size() == (unsigned)this->pattern_len);
       pattern.resize(this->pattern_len, 0);
       for (int i = 0; i < this->pattern_len; i += 1)
       if (matches[0][i])
@@ -281,7 +282,7 @@ void Bingo::insert_in_pht(const AccumulationTable::Entry &entry) {
    if (this->debug_level >= 2) {
       cerr << "[Bingo] insert_in_pht(pc=0x" << hex << pc << ", address=0x" << address << ")" << dec << endl;
    }
-   const vector<bool> &pattern = entry.data.pattern;
+   const BingoPattern &pattern = entry.data.pattern;
    this->pht.insert(pc, address, pattern);
 }
 
@@ -291,7 +292,7 @@ void Bingo::insert_in_pht(const AccumulationTable::Entry &entry) {
 * @return  The appropriate prefetch level for all blocks based on BINGO's voting thresholds or
 *          an empty vector if no blocks should be prefetched
 */
-vector<int> Bingo::vote(const vector<vector<bool>> &x) {
+vector<int> Bingo::vote(const vector<BingoPattern> &x) {
    if (this->debug_level >= 2)
    cerr << "Bingo::vote(...)" << endl;
    int n = x.size();
@@ -308,12 +309,10 @@ vector<int> Bingo::vote(const vector<vector<bool>> &x) {
    if (this->debug_level >= 2) {
       cerr << "[Bingo::vote] Taking a vote among:" << endl;
       for (int i = 0; i < n; i += 1)
-      cerr << "<" << setw(3) << i + 1 << "> " << pattern_to_string(x[i]) << endl;
+      cerr << "<" << setw(3) << i + 1 << "> " << pattern_to_string(x[i], this->pattern_len) << endl;
    }
    bool pf_flag = false;
    vector<int> res(this->pattern_len, 0);
-   for (int i = 0; i < n; i += 1)
-   // assert((int)x[i].size() == this->pattern_len);
    for (int i = 0; i < this->pattern_len; i += 1) {
       int cnt = 0;
       for (int j = 0; j < n; j += 1)
@@ -15,9 +15,9 @@ namespace knob
 char state_char[] = {'I', 'A', 'P'};
 char getStateChar(MLOP_State state) {return state_char[(int)state];}
 
-string map_to_string(const vector<MLOP_State> &access_map, const vector<int> &prefetch_map) {
+string map_to_string(const MLOP_State *access_map, const int *prefetch_map, unsigned blocks_in_zone) {
     ostringstream oss;
-    for (unsigned i = 0; i < access_map.size(); i += 1)
+    for (unsigned i = 0; i < blocks_in_zone; i += 1)
         if (access_map[i] == MLOP_State::PREFTCH) {
             oss << prefetch_map[i];
         } else {
@@ -42,6 +42,9 @@ void MLOP::init_knobs()
 	MAX_OFFSET = blocks_in_zone - 1;
 	MIN_OFFSET = (-1) * MAX_OFFSET;
 	NUM_OFFSETS = 2*blocks_in_zone - 1;
+
+	assert(blocks_in_zone <= MLOP_MAX_BLOCKS_IN_ZONE);
+	assert(PF_DEGREE >= 1 && PF_DEGREE <= MLOP_MAX_PF_DEGREE);
 }
 
 void MLOP::init_stats()
@@ -121,12 +124,13 @@ void MLOP::access(uint64_t block_number) {
 		/* ===== */
 		return;
 	}
-	vector<MLOP_State> access_map = entry->data.access_map;
-	if (access_map[zone_offset] == MLOP_State::ACCESS)
+	if (entry->data.access_map[zone_offset] == MLOP_State::ACCESS)
 		return; /* ignore repeated trigger access */
+	MLOP_State access_map[MLOP_MAX_BLOCKS_IN_ZONE];
+	copy(entry->data.access_map, entry->data.access_map + this->blocks_in_zone, access_map);
 	this->update_cnt += 1;
-	const deque<int> &queue = entry->data.hist_queue;
-	for (int d = 0; d <= (int)queue.size(); d += 1) {
+	const uint8_t *queue = entry->data.hist_queue;
+	for (int d = 0; d <= (int)entry->data.hist_len; d += 1) {
 		/* unmark latest access to increase prediction depth */
 		if (d != 0) {
 			int idx = queue[d - 1];
@@ -259,16 +263,19 @@ void MLOP::prefetch(CACHE *cache, uint64_t block_number) {
 	int zone_offset = block_number % this->blocks_in_zone;
 	AccessMapTable::Entry *entry = this->access_map_table->find(zone_number);
 	// assert(entry); /* I expect `mark` to have been called before `prefetch` */
-	const vector<MLOP_State> &access_map = entry->data.access_map;
-	const vector<int> &prefetch_map = entry->data.prefetch_map;
+	const MLOP_State *access_map = entry->data.access_map;
+	const int *prefetch_map = entry->data.prefetch_map;
 	if (this->debug_level >= 2) {
-		cout << "[MLOP::prefetch] old_access_map=" << map_to_string(access_map, prefetch_map) << endl;
+		cout << "[MLOP::prefetch] old_access_map=" << map_to_string(access_map, prefetch_map, this->blocks_in_zone) << endl;
 	}
 	for (uint32_t d = 0; d < PF_DEGREE; d += 1) {
 		for (auto &cur_pf_offset : this->pf_offset[d]) {
 			// assert(this->pf_level[d] > 0);
 			int offset_to_prefetch = zone_offset + cur_pf_offset;
 
+			if (!this->is_inside_zone(offset_to_prefetch))
+				continue;
+
 			/* use `access_map` to filter prefetches */
 			if (access_map[offset_to_prefetch] == MLOP_State::ACCESS)
 				continue;
@@ -276,7 +283,7 @@ void MLOP::prefetch(CACHE *cache, uint64_t block_number) {
 					prefetch_map[offset_to_prefetch] <= this->pf_level[d])
 				continue;
 
-			if (this->is_inside_zone(offset_to_prefetch) && cache->PQ.occupancy < cache->PQ.SIZE &&
+			if (cache->PQ.occupancy < cache->PQ.SIZE &&
 					cache->PQ.occupancy + cache->MSHR.occupancy < cache->MSHR.SIZE - 1) {
 				uint64_t pf_block_number = block_number + cur_pf_offset;
 				uint64_t base_addr = block_number << LOG2_BLOCK_SIZE;
@@ -289,7 +296,7 @@ void MLOP::prefetch(CACHE *cache, uint64_t block_number) {
 		}
 	}
 	if (this->debug_level >= 2) {
-		cout << "[MLOP::prefetch] new_access_map=" << map_to_string(access_map, prefetch_map) << endl;
+		cout << "[MLOP::prefetch] new_access_map=" << map_to_string(access_map, prefetch_map, this->blocks_in_zone) << endl;
 		cout << "[MLOP::prefetch] issued " << pf_issued << " prefetch(es)" << endl;
 	}
 }
@@ -339,9 +346,9 @@ void MLOP::track(uint64_t block_number) {
 			this->zone_life.push_back(string(this->blocks_in_zone, state_char[MLOP_State::INIT]));
 			return;
 		}
-		const vector<MLOP_State> &access_map = entry->data.access_map;
-		const vector<int> &prefetch_map = entry->data.prefetch_map;
-		string s = map_to_string(access_map, prefetch_map);
+		const MLOP_State *access_map = entry->data.access_map;
+		const int *prefetch_map = entry->data.prefetch_map;
+		string s = map_to_string(access_map, prefetch_map, this->blocks_in_zone);
 		if (s != this->zone_life.back())
 			this->zone_life.push_back(s);
 	}
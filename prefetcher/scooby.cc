@@ -6,6 +6,8 @@
 #include "memory_class.h"
 #include "scooby.h"
 #include "util.h"
+#include "checkpoint.h"
+#include "parallel_sim.h"
 
 #if 0
 #	define LOCKED(...) {fflush(stdout); __VA_ARGS__; fflush(stdout);}
@@ -56,6 +58,8 @@ namespace knob
 	extern uint32_t scooby_print_access_debug_pc_count;
 	extern bool     scooby_print_trace;
 	extern bool     scooby_enable_state_action_stats;
+	extern uint32_t scooby_state_action_stats_top_k;
+	extern uint32_t scooby_state_action_stats_sample_rate;
 	extern bool     scooby_enable_reward_tracker_hit;
 	extern int32_t  scooby_reward_tracker_hit;
 	extern bool     scooby_enable_shaggy;
@@ -69,6 +73,10 @@ namespace knob
 	extern vector<float> scooby_max_to_avg_q_thresholds;
 	extern vector<int32_t> scooby_dyn_degrees;
 	extern uint64_t scooby_early_exploration_window;
+	extern string   scooby_load_qtable;
+	extern string   scooby_save_qtable;
+	extern bool     scooby_share_brain;
+	extern bool     scooby_freeze_brain;
 	extern bool     scooby_enable_het_reward;
 	extern int32_t  scooby_reward_fa_correct_timely;
 	extern int32_t  scooby_reward_fa_correct_untimely;
@@ -114,6 +122,8 @@ namespace knob
 	extern uint32_t le_action_trace_interval;
 	extern std::string le_action_trace_name;
 	extern bool     le_enable_action_plot;
+	extern string   le_qtable_storage;
+	extern uint32_t le_qtable_frac_bits;
 
 	/* CMAC engine knobs */
 	extern uint32_t scooby_cmac_num_planes;
@@ -182,15 +192,24 @@ void Scooby::init_knobs()
 	assert(Actions.size() <= MAX_ACTIONS);
 	if(knob::scooby_access_debug)
 	{
-		cout << "***WARNING*** setting knob::scooby_max_pcs, knob::scooby_max_offsets, and knob::scooby_max_deltas to large value as knob::scooby_access_debug is true" << endl;
-		knob::scooby_max_pcs = 1024;
-		knob::scooby_max_offsets = 1024;
-		knob::scooby_max_deltas = 1024;
+		cout << "***WARNING*** setting knob::scooby_max_pcs, knob::scooby_max_offsets, and knob::scooby_max_deltas to their largest value as knob::scooby_access_debug is true" << endl;
+		knob::scooby_max_pcs = SCOOBY_ST_MAX_PCS;
+		knob::scooby_max_offsets = SCOOBY_ST_MAX_OFFSETS;
+		knob::scooby_max_deltas = SCOOBY_ST_MAX_DELTAS;
+	}
+	assert(knob::scooby_max_pcs >= 1 && knob::scooby_max_pcs <= SCOOBY_ST_MAX_PCS);
+	assert(knob::scooby_max_offsets >= 1 && knob::scooby_max_offsets <= SCOOBY_ST_MAX_OFFSETS);
+	assert(knob::scooby_max_deltas >= 1 && knob::scooby_max_deltas <= SCOOBY_ST_MAX_DELTAS);
+	assert(knob::scooby_action_tracker_size <= SCOOBY_ST_MAX_ACTION_TRACKER);
+	for(uint32_t index = 0; index < Actions.size(); ++index)
+	{
+		assert(Actions[index] > -64 && Actions[index] < 64);
 	}
 	assert(knob::scooby_pref_degree >= 1 && (knob::scooby_pref_degree == 1 || !knob::scooby_enable_dyn_degree));
 	assert(knob::scooby_max_to_avg_q_thresholds.size() == knob::scooby_dyn_degrees.size()-1);
 	assert(knob::scooby_last_pref_offset_conf_thresholds.size() == knob::scooby_dyn_degrees_type2.size()-1);
 	assert(knob::scooby_dyn_degrees_type2.size() == knob::scooby_dyn_degrees_afterburning.size());
+	assert(knob::scooby_state_action_stats_top_k >= 1 && knob::scooby_state_action_stats_sample_rate >= 1);
 }
 
 void Scooby::init_stats()
@@ -200,16 +219,39 @@ void Scooby::init_stats()
 	stats.predict.issue_dist.resize(knob::scooby_max_actions, 0);
 	stats.predict.pred_hit.resize(knob::scooby_max_actions, 0);
 	stats.predict.out_of_bounds_dist.resize(knob::scooby_max_actions, 0);
-	state_action_dist.clear();
+	state_action_stats = knob::scooby_enable_state_action_stats ? new HeavyHitters(knob::scooby_state_action_stats_top_k, knob::scooby_max_actions) : NULL;
+	state_action_stats_calls = 0;
+	action_deg_dist.assign(knob::scooby_max_actions * MAX_SCOOBY_DEGREE, 0);
 }
 
-Scooby::Scooby(string type) : Prefetcher(type)
+uint32_t Scooby::num_instances = 0;
+Scooby* Scooby::brain_owner = NULL;
+std::mutex Scooby::shared_brain_lock;
+
+Scooby::Scooby(string type, uint32_t cpu) : Prefetcher(type), cpu(cpu)
 {
 	init_knobs();
 	init_stats();
 
 	recorder = new ScoobyRecorder();
 
+	st_entries.resize(knob::scooby_st_size, NULL);
+	/* the extra link is the head of the circular LRU list */
+	st_prev.resize(knob::scooby_st_size + 1, knob::scooby_st_size);
+	st_next.resize(knob::scooby_st_size + 1, knob::scooby_st_size);
+	st_count = 0;
+	st_index.resize(knob::scooby_st_size);
+
+	pt_pool.resize(knob::scooby_pt_size + 1);
+	pt_fifo.resize(knob::scooby_pt_size, 0);
+	pt_prev.resize(knob::scooby_pt_size + 1, 0);
+	pt_next.resize(knob::scooby_pt_size + 1, 0);
+	for(uint32_t index = 0; index <= knob::scooby_pt_size; ++index)
+	{
+		pt_free.push_back(knob::scooby_pt_size - index);
+	}
+	pt_head = pt_count = 0;
+	pt_index.resize(knob::scooby_pt_size);
 	last_evicted_tracker = NULL;
 
 	/* init learning engine */
@@ -218,7 +260,14 @@ Scooby::Scooby(string type) : Prefetcher(type)
 	brain_featurewise = NULL;
 	brain = NULL;
 
-	if(knob::scooby_enable_cmac_engine)
+	if(knob::scooby_share_brain && brain_owner)
+	{
+		brain_cmac = brain_owner->brain_cmac;
+		brain_cmac2 = brain_owner->brain_cmac2;
+		brain_featurewise = brain_owner->brain_featurewise;
+		brain = brain_owner->brain;
+	}
+	else if(knob::scooby_enable_cmac_engine)
 	{
 		CMACConfig config;
 		config.num_planes = knob::scooby_cmac_num_planes;
@@ -282,7 +331,20 @@ Scooby::Scooby(string type) : Prefetcher(type)
 									knob::scooby_early_exploration_window);
 	}
 
+	if(knob::scooby_share_brain && !brain_owner)
+	{
+		brain_owner = this;
+	}
+
+	/* warm start from a trained engine */
+	instance_id = num_instances++;
+	if(!knob::scooby_load_qtable.empty() && owns_brain())
+	{
+		checkpoint_brain(knob::scooby_load_qtable, 1);
+	}
+
 	/* init Shaggy */
+	shaggy = NULL;
 	if(knob::scooby_enable_shaggy)
 	{
 		shaggy = new Shaggy();
@@ -291,6 +353,7 @@ Scooby::Scooby(string type) : Prefetcher(type)
 	bw_level = 0;
 	core_ipc = 0;
 
+	deg_detector = NULL;
 	if(knob::scooby_enable_dyn_degree_detector)
 	{
 		deg_detector = new DegreeDetector();
@@ -307,11 +370,19 @@ Scooby::Scooby(string type) : Prefetcher(type)
 
 Scooby::~Scooby()
 {
-	if(brain_cmac) 	delete brain_cmac;
-	if(brain_cmac2) delete brain_cmac2;
-	if(brain_featurewise) delete brain_featurewise;
-	if(brain) 		delete brain;
+	if(owns_brain())
+	{
+		if(brain_cmac) 	delete brain_cmac;
+		if(brain_cmac2) delete brain_cmac2;
+		if(brain_featurewise) delete brain_featurewise;
+		if(brain) 		delete brain;
+	}
 	if(deg_detector) delete deg_detector;
+	if(state_action_stats) delete state_action_stats;
+	for(uint32_t index = 0; index < st_count; ++index)
+	{
+		delete st_entries[index];
+	}
 }
 
 void Scooby::print_config()
@@ -348,6 +419,8 @@ void Scooby::print_config()
 		<< "scooby_print_access_debug_pc_count " << knob::scooby_print_access_debug_pc_count << endl
 		<< "scooby_print_trace " << knob::scooby_print_trace << endl
 		<< "scooby_enable_state_action_stats " << knob::scooby_enable_state_action_stats << endl
+		<< "scooby_state_action_stats_top_k " << knob::scooby_state_action_stats_top_k << endl
+		<< "scooby_state_action_stats_sample_rate " << knob::scooby_state_action_stats_sample_rate << endl
 		<< "scooby_enable_reward_tracker_hit " << knob::scooby_enable_reward_tracker_hit << endl
 		<< "scooby_reward_tracker_hit " << knob::scooby_reward_tracker_hit << endl
 		<< "scooby_enable_shaggy " << knob::scooby_enable_shaggy << endl
@@ -360,6 +433,10 @@ void Scooby::print_config()
 		<< "scooby_max_to_avg_q_thresholds " << array_to_string(knob::scooby_max_to_avg_q_thresholds) << endl
 		<< "scooby_dyn_degrees " << array_to_string(knob::scooby_dyn_degrees) << endl
 		<< "scooby_early_exploration_window " << knob::scooby_early_exploration_window << endl
+		<< "scooby_load_qtable " << knob::scooby_load_qtable << endl
+		<< "scooby_save_qtable " << knob::scooby_save_qtable << endl
+		<< "scooby_share_brain " << knob::scooby_share_brain << endl
+		<< "scooby_freeze_brain " << knob::scooby_freeze_brain << endl
 		<< "scooby_enable_het_reward " << knob::scooby_enable_het_reward << endl
 		<< "scooby_reward_fa_correct_timely " << knob::scooby_reward_fa_correct_timely << endl
 		<< "scooby_reward_fa_correct_untimely " << knob::scooby_reward_fa_correct_untimely << endl
@@ -406,6 +483,8 @@ void Scooby::print_config()
 		<< "le_action_trace_interval " << knob::le_action_trace_interval << endl
 		<< "le_action_trace_name " << knob::le_action_trace_name << endl
 		<< "le_enable_action_plot " << knob::le_enable_action_plot << endl
+		<< "le_qtable_storage " << knob::le_qtable_storage << endl
+		<< "le_qtable_frac_bits " << knob::le_qtable_frac_bits << endl
 		<< endl
 		<< "scooby_cmac_num_planes " << knob::scooby_cmac_num_planes << endl
 		<< "scooby_cmac_num_entries_per_plane " << knob::scooby_cmac_num_entries_per_plane << endl
@@ -496,19 +575,19 @@ void Scooby::invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cache_hit,
 	 * state can contain per page local information like delta signature, pc signature etc.
 	 * it can also contain global signatures like last three branch PCs etc.
 	 */
-	State *state = new State();
-	state->pc = pc;
-	state->address = address;
-	state->page = page;
-	state->offset = offset;
-	state->delta = !stentry->deltas.empty() ? stentry->deltas.back() : 0;
-	state->local_delta_sig = stentry->get_delta_sig();
-	state->local_delta_sig2 = stentry->get_delta_sig2();
-	state->local_pc_sig = stentry->get_pc_sig();
-	state->local_offset_sig = stentry->get_offset_sig();
-	state->bw_level = bw_level;
-	state->is_high_bw = is_high_bw();
-	state->acc_level = acc_level;
+	State state;
+	state.pc = pc;
+	state.address = address;
+	state.page = page;
+	state.offset = offset;
+	state.delta = !stentry->deltas.empty() ? stentry->deltas.back() : 0;
+	state.local_delta_sig = stentry->get_delta_sig();
+	state.local_delta_sig2 = stentry->get_delta_sig2();
+	state.local_pc_sig = stentry->get_pc_sig();
+	state.local_offset_sig = stentry->get_offset_sig();
+	state.bw_level = bw_level;
+	state.is_high_bw = is_high_bw();
+	state.acc_level = acc_level;
 
 	/* Shaggy only predicts for streaming accesses */
 	bool cond_streaming = (knob::scooby_enable_shaggy && stentry->streaming);
@@ -525,7 +604,16 @@ void Scooby::invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cache_hit,
 	if(!cond_streaming || knob::scooby_prefetch_with_shaggy)
 	{
 		uint32_t count = pref_addr.size();
-		predict(address, page, offset, state, pref_addr);
+		if(knob::scooby_share_brain)
+		{
+			/* the other cores train the same engine */
+			SHARED_ACCESS shared_brain_access(cpu, shared_brain_lock);
+			predict(address, page, offset, &state, pref_addr);
+		}
+		else
+		{
+			predict(address, page, offset, &state, pref_addr);
+		}
 		stats.pref_issue.scooby += (pref_addr.size() - count);
 	}
 }
@@ -539,23 +627,25 @@ Scooby_STEntry* Scooby::update_local_state(uint64_t pc, uint64_t page, uint32_t
 {
 	stats.st.lookup++;
 	Scooby_STEntry *stentry = NULL;
-	auto st_index = find_if(signature_table.begin(), signature_table.end(), [page](Scooby_STEntry *stentry){return stentry->page == page;});
-	if(st_index != signature_table.end())
+	int st_slot = st_index.find(page);
+	if(st_slot != -1)
 	{
 		stats.st.hit++;
-		stentry = (*st_index);
+		stentry = st_entries[st_slot];
 		stentry->update(page, pc, offset, address);
-		signature_table.erase(st_index);
-		signature_table.push_back(stentry);
+		st_unlink(st_slot);
+		st_push_mru(st_slot);
 		return stentry;
 	}
 	else
 	{
-		if(signature_table.size() >= knob::scooby_st_size)
+		if(st_count >= knob::scooby_st_size)
 		{
 			stats.st.evict++;
-			stentry = signature_table.front();
-			signature_table.pop_front();
+			st_slot = st_next[knob::scooby_st_size]; /* LRU */
+			stentry = st_entries[st_slot];
+			st_unlink(st_slot);
+			st_index.erase(stentry->page, st_slot);
 			if(knob::scooby_access_debug)
 			{
 				recorder->record_access_knowledge(stentry);
@@ -572,11 +662,16 @@ Scooby_STEntry* Scooby::update_local_state(uint64_t pc, uint64_t page, uint32_t
 			{
 				insert_global_action_tracker(stentry);
 			}
-			delete stentry;
+			stentry->reset(page, pc, offset);
+		}
+		else
+		{
+			st_slot = st_count++;
+			st_entries[st_slot] = new Scooby_STEntry(page, pc, offset);
+			stentry = st_entries[st_slot];
 		}
 
 		stats.st.insert++;
-		stentry = new Scooby_STEntry(page, pc, offset);
 		recorder->record_trigger_access(page, pc, offset);
 		if(knob::scooby_enable_shaggy)
 		{
@@ -587,11 +682,33 @@ Scooby_STEntry* Scooby::update_local_state(uint64_t pc, uint64_t page, uint32_t
 		{
 			lookup_global_action_tracker(stentry);
 		}
-		signature_table.push_back(stentry);
+		st_index.insert(page, st_slot);
+		st_push_mru(st_slot);
 		return stentry;
 	}
 }
 
+Scooby_STEntry* Scooby::search_st(uint64_t page)
+{
+	int st_slot = st_index.find(page);
+	return (st_slot != -1) ? st_entries[st_slot] : NULL;
+}
+
+void Scooby::st_unlink(uint32_t index)
+{
+	st_next[st_prev[index]] = st_next[index];
+	st_prev[st_next[index]] = st_prev[index];
+}
+
+void Scooby::st_push_mru(uint32_t index)
+{
+	uint32_t head = knob::scooby_st_size;
+	st_prev[index] = st_prev[head];
+	st_next[index] = head;
+	st_next[st_prev[head]] = index;
+	st_prev[head] = index;
+}
+
 uint32_t Scooby::predict(uint64_t base_address, uint64_t page, uint32_t offset, State *state, vector<uint64_t> &pref_addr)
 {
 	MYLOG("addr@%lx page %lx off %u state %x", base_address, page, offset, state->value());
@@ -748,30 +865,57 @@ bool Scooby::track(uint64_t address, State *state, uint32_t action_index, Scooby
 	}
 
 	Scooby_PTEntry *ptentry = NULL;
+	uint32_t pt_slot = 0;
 
-	if(prefetch_tracker.size() >= knob::scooby_pt_size)
+	if(pt_count >= knob::scooby_pt_size)
 	{
 		stats.track.evict++;
-		ptentry = prefetch_tracker.front();
-		prefetch_tracker.pop_front();
-		MYLOG("victim_state %x victim_act_idx %u victim_act %d", ptentry->state->value(), ptentry->action_index, Actions[ptentry->action_index]);
+		pt_slot = pt_fifo[pt_head];
+		pt_head = (pt_head + 1) % knob::scooby_pt_size;
+		pt_count--;
+		ptentry = &pt_pool[pt_slot];
+		/* the oldest entry of the FIFO is also the oldest one with its address */
+		pt_prev[pt_next[pt_slot]] = pt_prev[pt_slot];
+		pt_next[pt_prev[pt_slot]] = pt_next[pt_slot];
+		if(pt_index.erase(ptentry->address, pt_slot))
+		{
+			pt_index.repoint(ptentry->address, pt_next[pt_slot]);
+		}
+		MYLOG("victim_state %x victim_act_idx %u victim_act %d", ptentry->state.value(), ptentry->action_index, Actions[ptentry->action_index]);
 		if(last_evicted_tracker)
 		{
-			MYLOG("last_victim_state %x last_victim_act_idx %u last_victim_act %d", last_evicted_tracker->state->value(), last_evicted_tracker->action_index, Actions[last_evicted_tracker->action_index]);
+			MYLOG("last_victim_state %x last_victim_act_idx %u last_victim_act %d", last_evicted_tracker->state.value(), last_evicted_tracker->action_index, Actions[last_evicted_tracker->action_index]);
 			train(ptentry, last_evicted_tracker);
-			delete last_evicted_tracker->state;
-			delete last_evicted_tracker;
+			pt_free.push_back(last_evicted_tracker - &pt_pool[0]);
 		}
 		last_evicted_tracker = ptentry;
 	}
 
-	ptentry = new Scooby_PTEntry(address, state, action_index);
+	pt_slot = pt_free.back();
+	pt_free.pop_back();
+	ptentry = &pt_pool[pt_slot];
+	ptentry->reset(address, *state, action_index);
 	if(knob::scooby_enable_pt_address_compression && ptentry->address != 0xdeadbeef)
 	{
 		ptentry->address = compress_address(ptentry->address);
 	}
-	prefetch_tracker.push_back(ptentry);
-	assert(prefetch_tracker.size() <= knob::scooby_pt_size);
+	int oldest = pt_index.find(ptentry->address);
+	if(oldest == -1)
+	{
+		pt_prev[pt_slot] = pt_next[pt_slot] = pt_slot;
+	}
+	else
+	{
+		/* the newest entry with the address goes right before the oldest one */
+		pt_prev[pt_slot] = pt_prev[oldest];
+		pt_next[pt_slot] = oldest;
+		pt_next[pt_prev[oldest]] = pt_slot;
+		pt_prev[oldest] = pt_slot;
+	}
+	pt_index.insert(ptentry->address, pt_slot);
+	pt_fifo[(pt_head + pt_count) % knob::scooby_pt_size] = pt_slot;
+	pt_count++;
+	assert(pt_count <= knob::scooby_pt_size);
 
 	(*tracker) = ptentry;
 	MYLOG("end@%lx", address);
@@ -830,12 +974,12 @@ uint32_t Scooby::get_dyn_pref_degree(float max_to_avg_q_ratio, uint64_t page, in
 	}
 	else if(knob::scooby_multi_deg_select_type == 2)
 	{
-		auto st_index = find_if(signature_table.begin(), signature_table.end(), [page](Scooby_STEntry *stentry){return stentry->page == page;});
-		if(st_index != signature_table.end())
+		Scooby_STEntry *stentry = search_st(page);
+		if(stentry)
 		{
 			uint32_t conf = 0;
-			bool found = (*st_index)->search_action_tracker(action, conf);
-			bool is_afterburning = ((*st_index)->afterburning_actions.find(action) != (*st_index)->afterburning_actions.end());
+			bool found = stentry->search_action_tracker(action, conf);
+			bool is_afterburning = stentry->afterburning_actions.contains(action);
 			vector<int32_t> conf_thresholds, deg_afterburning, deg_normal;
 
 			conf_thresholds = is_high_bw() ? knob::scooby_last_pref_offset_conf_thresholds_hbw : knob::scooby_last_pref_offset_conf_thresholds;
@@ -867,7 +1011,7 @@ uint32_t Scooby::get_dyn_pref_degree(float max_to_avg_q_ratio, uint64_t page, in
 			/* remember the action that achieved max degree */
 			if(knob::scooby_enable_afterburner && degree >= knob::scooby_afterburner_degree_threshold)
 			{
-				(*st_index)->action_with_max_degree.insert(action);
+				stentry->action_with_max_degree.insert(action);
 			}
 		}
 	}
@@ -901,7 +1045,7 @@ void Scooby::reward(uint64_t address)
 		Scooby_PTEntry *ptentry = ptentries[index];
 		stats.reward.demand.pt_found_total++;
 
-		MYLOG("PT hit. state %x act_idx %u act %d", ptentry->state->value(), ptentry->action_index, Actions[ptentry->action_index]);
+		MYLOG("PT hit. state %x act_idx %u act %d", ptentry->state.value(), ptentry->action_index, Actions[ptentry->action_index]);
 		/* Do not compute reward if already has a reward.
 		 * This can happen when a prefetch access sees multiple demand reuse */
 		if(ptentry->has_reward)
@@ -936,7 +1080,7 @@ void Scooby::reward(uint64_t address)
 /* This reward function is called during eviction from prefetch_tracker */
 void Scooby::reward(Scooby_PTEntry *ptentry)
 {
-	MYLOG("reward PT evict %lx state %x act_idx %u act %d", ptentry->address, ptentry->state->value(), ptentry->action_index, Actions[ptentry->action_index]);
+	MYLOG("reward PT evict %lx state %x act_idx %u act %d", ptentry->address, ptentry->state.value(), ptentry->action_index, Actions[ptentry->action_index]);
 
 	stats.reward.train.called++;
 	assert(!ptentry->has_reward);
@@ -966,7 +1110,7 @@ void Scooby::reward(Scooby_PTEntry *ptentry)
 
 void Scooby::assign_reward(Scooby_PTEntry *ptentry, RewardType type)
 {
-	MYLOG("assign_reward PT evict %lx state %x act_idx %u act %d", ptentry->address, ptentry->state->value(), ptentry->action_index, Actions[ptentry->action_index]);
+	MYLOG("assign_reward PT evict %lx state %x act_idx %u act %d", ptentry->address, ptentry->state.value(), ptentry->action_index, Actions[ptentry->action_index]);
 	assert(!ptentry->has_reward);
 
 	/* compute the reward */
@@ -1156,8 +1300,8 @@ int32_t Scooby::compute_reward(Scooby_PTEntry *ptentry, RewardType type)
 
 void Scooby::train(Scooby_PTEntry *curr_evicted, Scooby_PTEntry *last_evicted)
 {
-	MYLOG("victim %s %u %d last_victim %s %u %d", curr_evicted->state->to_string().c_str(), curr_evicted->action_index, Actions[curr_evicted->action_index],
-												last_evicted->state->to_string().c_str(), last_evicted->action_index, Actions[last_evicted->action_index]);
+	MYLOG("victim %s %u %d last_victim %s %u %d", curr_evicted->state.to_string().c_str(), curr_evicted->action_index, Actions[curr_evicted->action_index],
+												last_evicted->state.to_string().c_str(), last_evicted->action_index, Actions[last_evicted->action_index]);
 
 	stats.train.called++;
 	if(!last_evicted->has_reward)
@@ -1167,26 +1311,32 @@ void Scooby::train(Scooby_PTEntry *curr_evicted, Scooby_PTEntry *last_evicted)
 	}
 	assert(last_evicted->has_reward);
 
+	/* a frozen engine only predicts */
+	if(knob::scooby_freeze_brain)
+	{
+		return;
+	}
+
 	/* train */
-	MYLOG("===SARSA=== S1: %s A1: %u R1: %d S2: %s A2: %u", last_evicted->state->to_string().c_str(), last_evicted->action_index,
+	MYLOG("===SARSA=== S1: %s A1: %u R1: %d S2: %s A2: %u", last_evicted->state.to_string().c_str(), last_evicted->action_index,
 															last_evicted->reward,
-															curr_evicted->state->to_string().c_str(), curr_evicted->action_index);
+															curr_evicted->state.to_string().c_str(), curr_evicted->action_index);
 	if(knob::scooby_enable_cmac_engine)
 	{
-		brain_cmac->learn(last_evicted->state, last_evicted->action_index, last_evicted->reward, curr_evicted->state, curr_evicted->action_index);
+		brain_cmac->learn(&last_evicted->state, last_evicted->action_index, last_evicted->reward, &curr_evicted->state, curr_evicted->action_index);
 	}
 	else if(knob::scooby_enable_cmac2_engine)
 	{
-		brain_cmac2->learn(last_evicted->state, last_evicted->action_index, last_evicted->reward, curr_evicted->state, curr_evicted->action_index);
+		brain_cmac2->learn(&last_evicted->state, last_evicted->action_index, last_evicted->reward, &curr_evicted->state, curr_evicted->action_index);
 	}
 	else if(knob::scooby_enable_featurewise_engine)
 	{
-		brain_featurewise->learn(last_evicted->state, last_evicted->action_index, last_evicted->reward, curr_evicted->state, curr_evicted->action_index,
+		brain_featurewise->learn(&last_evicted->state, last_evicted->action_index, last_evicted->reward, &curr_evicted->state, curr_evicted->action_index,
 								last_evicted->consensus_vec, last_evicted->reward_type);
 	}
 	else
 	{
-		brain->learn(last_evicted->state->value(), last_evicted->action_index, last_evicted->reward, curr_evicted->state->value(), curr_evicted->action_index);
+		brain->learn(last_evicted->state.value(), last_evicted->action_index, last_evicted->reward, curr_evicted->state.value(), curr_evicted->action_index);
 	}
 	MYLOG("train done");
 }
@@ -1240,62 +1390,42 @@ vector<Scooby_PTEntry*> Scooby::search_pt(uint64_t address, bool search_all)
 		address = compressed_addr;
 	}
 	vector<Scooby_PTEntry*> entries;
-	for(uint32_t index = 0; index < prefetch_tracker.size(); ++index)
+	int oldest = pt_index.find(address);
+	if(oldest != -1)
 	{
-		if(prefetch_tracker[index]->address == address)
+		uint32_t pt_slot = oldest;
+		do
 		{
-			entries.push_back(prefetch_tracker[index]);
+			entries.push_back(&pt_pool[pt_slot]);
 			if(!search_all) break;
-		}
+			pt_slot = pt_next[pt_slot];
+		} while(pt_slot != (uint32_t)oldest);
 	}
 	return entries;
 }
 
+/* only every scooby_state_action_stats_sample_rate-th prediction is counted */
+bool Scooby::sample_state_action_stats()
+{
+	return (state_action_stats_calls++ % knob::scooby_state_action_stats_sample_rate) == 0;
+}
+
 void Scooby::update_stats(uint32_t state, uint32_t action_index, uint32_t pref_degree)
 {
-	auto it = state_action_dist.find(state);
-	if(it != state_action_dist.end())
-	{
-		it->second[action_index]++;
-	}
-	else
+	if(sample_state_action_stats())
 	{
-		vector<uint64_t> act_dist;
-		act_dist.resize(knob::scooby_max_actions, 0);
-		act_dist[action_index]++;
-		state_action_dist.insert(std::pair<uint32_t, vector<uint64_t> >(state, act_dist));
+		state_action_stats->update(state, action_index);
 	}
 }
 
 void Scooby::update_stats(State *state, uint32_t action_index, uint32_t degree)
 {
-	string state_str = state->to_string();
-	auto it = state_action_dist2.find(state_str);
-	if(it != state_action_dist2.end())
-	{
-		it->second[action_index]++;
-		it->second[knob::scooby_max_actions]++; /* counts total occurences of this state */
-	}
-	else
-	{
-		vector<uint64_t> act_dist;
-		act_dist.resize(knob::scooby_max_actions+1, 0);
-		act_dist[action_index]++;
-		act_dist[knob::scooby_max_actions]++; /* counts total occurences of this state */
-		state_action_dist2.insert(std::pair<string, vector<uint64_t> >(state_str, act_dist));
-	}
+	assert(degree < MAX_SCOOBY_DEGREE);
+	action_deg_dist[action_index * MAX_SCOOBY_DEGREE + degree]++;
 
-	auto it2 = action_deg_dist.find(getAction(action_index));
-	if(it2 != action_deg_dist.end())
-	{
-		it2->second[degree]++;
-	}
-	else
+	if(sample_state_action_stats())
 	{
-		vector<uint64_t> deg_dist;
-		deg_dist.resize(MAX_SCOOBY_DEGREE, 0);
-		deg_dist[degree]++;
-		action_deg_dist.insert(std::pair<int32_t, vector<uint64_t> >(getAction(action_index), deg_dist));
+		state_action_stats->update(state->stats_key(), action_index);
 	}
 }
 
@@ -1307,10 +1437,10 @@ int32_t Scooby::getAction(uint32_t action_index)
 
 void Scooby::track_in_st(uint64_t page, uint32_t pred_offset, int32_t pref_offset)
 {
-	auto st_index = find_if(signature_table.begin(), signature_table.end(), [page](Scooby_STEntry *stentry){return stentry->page == page;});
-	if(st_index != signature_table.end())
+	Scooby_STEntry *stentry = search_st(page);
+	if(stentry)
 	{
-		(*st_index)->track_prefetch(pred_offset, pref_offset);
+		stentry->track_prefetch(pred_offset, pref_offset);
 	}
 }
 
@@ -1342,12 +1472,12 @@ void Scooby::insert_global_action_tracker(Scooby_STEntry *stentry)
 {
 	assert(stentry);
 	assert(knob::scooby_enable_afterburner);
-	unordered_set<int32_t> action_with_max_degree = stentry->action_with_max_degree;
+	DeltaSet &action_with_max_degree = stentry->action_with_max_degree;
 	for(auto it = global_action_tracker.begin(); it != global_action_tracker.end(); ++it)
 	{
 		if(it->second != 0)
 		{
-			if(action_with_max_degree.find(it->first) != action_with_max_degree.end())
+			if(action_with_max_degree.contains(it->first))
 			{
 				it->second++;
 			}
@@ -1357,11 +1487,11 @@ void Scooby::insert_global_action_tracker(Scooby_STEntry *stentry)
 			}
 		}
 	}
-	for(auto it = action_with_max_degree.begin(); it != action_with_max_degree.end(); ++it)
+	for(int32_t action = -63; action <= 63; ++action)
 	{
-		if(global_action_tracker[(*it)] == 0)
+		if(action_with_max_degree.contains(action) && global_action_tracker[action] == 0)
 		{
-			global_action_tracker[(*it)] = 1;
+			global_action_tracker[action] = 1;
 		}
 	}
 	// print_global_action_tracker();
@@ -1429,43 +1559,50 @@ void Scooby::dump_stats()
 
 	if(knob::scooby_enable_state_action_stats)
 	{
-		if(knob::scooby_enable_cmac_engine || knob::scooby_enable_cmac2_engine || knob::scooby_enable_featurewise_engine)
+		/* the most frequent states, the counts of a state start when it enters the tracker */
+		cout << "scooby_state_action_stats_sampled " << state_action_stats->get_updates() << endl
+			<< "scooby_state_action_stats_tracked " << state_action_stats->get_size() << endl
+			<< "scooby_state_action_stats_replaced " << state_action_stats->get_replacements() << endl;
+
+		bool full_state = knob::scooby_enable_cmac_engine || knob::scooby_enable_cmac2_engine || knob::scooby_enable_featurewise_engine;
+		vector<uint32_t> slots = state_action_stats->sorted();
+		for(auto it = slots.begin(); it != slots.end(); ++it)
 		{
-			std::vector<std::pair<string, vector<uint64_t> > > pairs;
-			for (auto itr = state_action_dist2.begin(); itr != state_action_dist2.end(); ++itr)
-			    pairs.push_back(*itr);
-			sort(pairs.begin(), pairs.end(), [](std::pair<string, vector<uint64_t>>& a, std::pair<string, vector<uint64_t>>& b){return a.second[knob::scooby_max_actions] > b.second[knob::scooby_max_actions];});
-			for(auto it = pairs.begin(); it != pairs.end(); ++it)
+			uint64_t key = state_action_stats->get_key(*it);
+			if(full_state)
 			{
-				cout << "scooby_state_" << hex << it->first << dec << " ";
-				for(uint32_t index = 0; index < it->second.size(); ++index)
-				{
-					cout << it->second[index] << ",";
-				}
-				cout << endl;
+				cout << "scooby_state_" << State::stats_key_to_string(key) << " ";
 			}
-		}
-		else
-		{
-			for(auto it = state_action_dist.begin(); it != state_action_dist.end(); ++it)
+			else
 			{
-				cout << "scooby_state_" << hex << it->first << dec << " ";
-				for(uint32_t index = 0; index < it->second.size(); ++index)
-				{
-					cout << it->second[index] << ",";
-				}
-				cout << endl;
+				cout << "scooby_state_" << hex << key << dec << " ";
+			}
+			uint64_t total = 0;
+			for(uint32_t index = 0; index < knob::scooby_max_actions; ++index)
+			{
+				total += state_action_stats->get_histogram(*it, index);
+				cout << state_action_stats->get_histogram(*it, index) << ",";
 			}
+			if(full_state)
+			{
+				cout << total << ",";
+			}
+			cout << endl;
 		}
 	}
 	cout << endl;
 
-	for(auto it = action_deg_dist.begin(); it != action_deg_dist.end(); ++it)
+	for(uint32_t action = 0; action < knob::scooby_max_actions; ++action)
 	{
-		cout << "scooby_action_" << it->first << "_deg_dist ";
+		uint64_t *deg_dist = &action_deg_dist[action * MAX_SCOOBY_DEGREE];
+		if(std::count(deg_dist, deg_dist + MAX_SCOOBY_DEGREE, 0) == MAX_SCOOBY_DEGREE)
+		{
+			continue;
+		}
+		cout << "scooby_action_" << Actions[action] << "_deg_dist ";
 		for(uint32_t index = 0; index < MAX_SCOOBY_DEGREE; ++index)
 		{
-			cout << it->second[index] << ",";
+			cout << deg_dist[index] << ",";
 		}
 		cout << endl;
 	}
@@ -1528,28 +1665,24 @@ void Scooby::dump_stats()
 		<< "scooby_pref_issue_shaggy " << stats.pref_issue.shaggy << endl
 		<< endl;
 
-	std::vector<std::pair<string, uint64_t>> pairs;
-	for (auto itr = target_action_state.begin(); itr != target_action_state.end(); ++itr)
-	    pairs.push_back(*itr);
-	sort(pairs.begin(), pairs.end(), [](std::pair<string, uint64_t>& a, std::pair<string, uint64_t>& b){return a.second > b.second;});
-	for(auto it = pairs.begin(); it != pairs.end(); ++it)
+	/* a shared engine reports once, with the core that created it */
+	if(!owns_brain())
 	{
-		cout << it->first << "," << it->second << endl;
+		cout << "scooby_shared_brain_with_core " << brain_owner->cpu << endl;
 	}
-
-	if(brain_cmac)
+	else if(brain_cmac)
 	{
 		brain_cmac->dump_stats();
 	}
-	if(brain_cmac2)
+	else if(brain_cmac2)
 	{
 		brain_cmac2->dump_stats();
 	}
-	if(brain_featurewise)
+	else if(brain_featurewise)
 	{
 		brain_featurewise->dump_stats();
 	}
-	if(brain)
+	else if(brain)
 	{
 		brain->dump_stats();
 	}
@@ -1585,4 +1718,32 @@ void Scooby::dump_stats()
 		cout << "scooby_cache_acc_level_" << index << " " << stats.cache_acc.histogram[index] << endl;
 	}
 	cout << endl;
+
+	if(!knob::scooby_save_qtable.empty() && owns_brain())
+	{
+		checkpoint_brain(knob::scooby_save_qtable, 0);
+	}
+}
+
+void Scooby::checkpoint_brain(string file_name, uint8_t restore)
+{
+	/* every core has a file of its own, unless they share the engine */
+	if(NUM_CPUS > 1 && !knob::scooby_share_brain)
+	{
+		file_name += ".cpu" + to_string(instance_id);
+	}
+	if(brain_cmac)
+	{
+		cout << "Q-tables of the CMAC engine cannot be saved or loaded" << endl;
+		assert(false);
+	}
+
+	CHECKPOINT_FILE checkpoint(file_name.c_str(), restore);
+	checkpoint.section("scooby actions " + array_to_string(knob::scooby_actions));
+	if(brain_cmac2)				brain_cmac2->checkpoint(checkpoint);
+	else if(brain_featurewise)	brain_featurewise->checkpoint(checkpoint);
+	else						brain->checkpoint(checkpoint);
+	checkpoint.section("end");
+
+	cout << (restore ? "Loaded Q-tables from " : "Saved Q-tables to ") << file_name << endl;
 }
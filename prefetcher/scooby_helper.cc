@@ -202,36 +202,118 @@ std::string State::to_string()
 	return ss.str();
 }
 
+uint64_t State::stats_key()
+{
+	/* offset and delta fit in 6 and 7 bits, the pc keeps its lower 51 bits */
+	return (pc << 13) | ((uint64_t)(offset & 0x3f) << 7) | (uint64_t)(delta & 0x7f);
+}
+
+std::string State::stats_key_to_string(uint64_t key)
+{
+	std::stringstream ss;
+	int32_t delta = (int32_t)(key & 0x7f);
+	if(delta >= 64) delta -= 128;
+
+	ss << std::hex << (key >> 13) << std::dec << "|"
+		<< ((key >> 7) & 0x3f) << "|"
+		<< delta;
+
+	return ss.str();
+}
+
+void Scooby_STEntry::reset(uint64_t page, uint64_t pc, uint32_t offset)
+{
+	this->page = page;
+	pcs.clear();
+	offsets.clear();
+	deltas.clear();
+	bmp_real.reset();
+	bmp_pred.reset();
+	num_unique_pcs = 0;
+	unique_deltas.clear();
+	trigger_pc = pc;
+	trigger_offset = offset;
+	streaming = false;
+	// last_pref_offset = 0;
+	// last_pref_offset_conf = 0;
+	num_action_trackers = 0;
+	action_with_max_degree.clear();
+	afterburning_actions.clear();
+	total_prefetches = 0;
+
+	pcs.push_back(pc, knob::scooby_max_pcs);
+	offsets.push_back(offset, knob::scooby_max_offsets);
+	record_unique_pc(pc);
+	bmp_real[offset] = 1;
+
+	delta_sig = 0;
+	delta_sig2 = 0;
+	pc_sig = (uint32_t)pc;
+	offset_sig = offset;
+}
+
+void Scooby_STEntry::record_unique_pc(uint64_t pc)
+{
+	if(knob::scooby_access_debug && num_unique_pcs < SCOOBY_ST_MAX_UNIQUE_PCS && !has_unique_pc(pc))
+	{
+		unique_pcs[num_unique_pcs++] = pc;
+	}
+}
+
+bool Scooby_STEntry::has_unique_pc(uint64_t pc)
+{
+	for(uint32_t index = 0; index < num_unique_pcs; ++index)
+	{
+		if(unique_pcs[index] == pc) return true;
+	}
+	return false;
+}
+
+/* The signatures cover the last four values of a history. Each one is a XOR of the values
+ * shifted by their age, so a new value shifts the signature and the value that leaves the
+ * last four is XORed out again at its shifted position. */
 void Scooby_STEntry::update(uint64_t page, uint64_t pc, uint32_t offset, uint64_t address)
 {
 	assert(this->page == page);
+	uint32_t window = 0;
 
 	/* insert PC */
-	if(this->pcs.size() >= knob::scooby_max_pcs)
+	window = min(4u, knob::scooby_max_pcs);
+	pc_sig = (pc_sig << PC_SIG_SHIFT) ^ (uint32_t)pc;
+	if(this->pcs.size() >= window)
 	{
-		this->pcs.pop_front();
+		pc_sig ^= (uint32_t)this->pcs[this->pcs.size() - window] << (PC_SIG_SHIFT * window);
 	}
-	this->pcs.push_back(pc);
-	this->unique_pcs.insert(pc);
+	this->pcs.push_back(pc, knob::scooby_max_pcs);
+	record_unique_pc(pc);
 
 	/* insert deltas */
 	if(!this->offsets.empty())
 	{
 		int32_t delta = (offset > this->offsets.back()) ? (offset - this->offsets.back()) : (-1)*(this->offsets.back() - offset);
-		if(this->deltas.size() >= knob::scooby_max_deltas)
+		window = min(4u, knob::scooby_max_deltas);
+		delta_sig = (delta_sig << DELTA_SIG_SHIFT) ^ (uint32_t)(delta & ((1ull << 7) - 1));
+		delta_sig2 = (delta_sig2 << SIG_SHIFT) ^ (uint32_t)((delta < 0) ? (((-1) * delta) + (1 << (SIG_DELTA_BIT - 1))) : delta);
+		if(this->deltas.size() >= window)
 		{
-			this->deltas.pop_front();
+			int32_t old_delta = this->deltas[this->deltas.size() - window];
+			delta_sig ^= (uint32_t)(old_delta & ((1ull << 7) - 1)) << (DELTA_SIG_SHIFT * window);
+			delta_sig2 ^= (uint32_t)((old_delta < 0) ? (((-1) * old_delta) + (1 << (SIG_DELTA_BIT - 1))) : old_delta) << (SIG_SHIFT * window);
 		}
-		this->deltas.push_back(delta);
+		delta_sig &= ((1ull << DELTA_SIG_MAX_BITS) - 1);
+		delta_sig2 &= SIG_MASK;
+		this->deltas.push_back(delta, knob::scooby_max_deltas);
 		this->unique_deltas.insert(delta);
 	}
 
 	/* insert offset */
-	if(this->offsets.size() >= knob::scooby_max_offsets)
+	window = min(4u, knob::scooby_max_offsets);
+	offset_sig = (offset_sig << OFFSET_SIG_SHIFT) ^ offset;
+	if(this->offsets.size() >= window)
 	{
-		this->offsets.pop_front();
+		offset_sig ^= (uint32_t)this->offsets[this->offsets.size() - window] << (OFFSET_SIG_SHIFT * window);
 	}
-	this->offsets.push_back(offset);
+	this->offsets.push_back(offset, knob::scooby_max_offsets);
 
 	/* update demanded pattern */
 	this->bmp_real[offset] = 1;
@@ -244,74 +326,23 @@ void Scooby_STEntry::update(uint64_t page, uint64_t pc, uint32_t offset, uint64_
 
 uint32_t Scooby_STEntry::get_delta_sig()
 {
-	uint32_t signature = 0;
-	uint32_t delta = 0;
-
-	/* compute signature only using last 4 deltas */
-	uint32_t n = deltas.size();
-	uint32_t ptr = (n >= 4) ? (n - 4) : 0;
-
-	for(uint32_t index = ptr; index < deltas.size(); ++index)
-	{
-		signature = (signature << DELTA_SIG_SHIFT);
-		signature = signature & ((1ull << DELTA_SIG_MAX_BITS) - 1);
-		delta = (uint32_t)(deltas[index] & ((1ull << 7) - 1));
-		signature = (signature ^ delta);
-		signature = signature & ((1ull << DELTA_SIG_MAX_BITS) - 1);
-	}
-	return signature;
+	return delta_sig;
 }
 
 /* This is directly inspired by SPP's signature */
 uint32_t Scooby_STEntry::get_delta_sig2()
 {
-	uint32_t curr_sig = 0;
-
-	/* compute signature only using last 4 deltas */
-	uint32_t n = deltas.size();
-	uint32_t ptr = (n >= 4) ? (n - 4) : 0;
-
-	for(uint32_t index = ptr; index < deltas.size(); ++index)
-	{
-		int sig_delta = (deltas[index] < 0) ? (((-1) * deltas[index]) + (1 << (SIG_DELTA_BIT - 1))) : deltas[index];
-		curr_sig = ((curr_sig << SIG_SHIFT) ^ sig_delta) & SIG_MASK;
-	}
-
-	return curr_sig;
+	return delta_sig2;
 }
 
 uint32_t Scooby_STEntry::get_pc_sig()
 {
-	uint32_t signature = 0;
-
-	/* compute signature only using last 4 PCs */
-	uint32_t n = pcs.size();
-	uint32_t ptr = (n >= 4) ? (n - 4) : 0;
-
-	for(uint32_t index = ptr; index < pcs.size(); ++index)
-	{
-		signature = (signature << PC_SIG_SHIFT);
-		signature = (signature ^ pcs[index]);
-	}
-	signature = signature & ((1ull << PC_SIG_MAX_BITS) - 1);
-	return signature;
+	return pc_sig & ((1ull << PC_SIG_MAX_BITS) - 1);
 }
 
 uint32_t Scooby_STEntry::get_offset_sig()
 {
-	uint32_t signature = 0;
-
-	/* compute signature only using last 4 offsets */
-	uint32_t n = offsets.size();
-	uint32_t ptr = (n >= 4) ? (n - 4) : 0;
-
-	for(uint32_t index = ptr; index < offsets.size(); ++index)
-	{
-		signature = (signature << OFFSET_SIG_SHIFT);
-		signature = (signature ^ offsets[index]);
-	}
-	signature = signature & ((1ull << OFFSET_SIG_MAX_BITS) - 1);
-	return signature;
+	return offset_sig & ((1ull << OFFSET_SIG_MAX_BITS) - 1);
 }
 
 void Scooby_STEntry::track_prefetch(uint32_t pred_offset, int32_t pref_offset)
@@ -327,40 +358,48 @@ void Scooby_STEntry::track_prefetch(uint32_t pred_offset, int32_t pref_offset)
 
 void Scooby_STEntry::insert_action_tracker(int32_t pref_offset)
 {
-	bool found = false;
-	auto it = find_if(action_tracker.begin(), action_tracker.end(), [pref_offset](ActionTracker *at){return at->action == pref_offset;});
-	if(it != action_tracker.end())
+	uint32_t index = 0;
+	while(index < num_action_trackers && action_tracker[index].action != pref_offset)
 	{
-		(*it)->conf++;
+		index++;
+	}
+	if(index < num_action_trackers)
+	{
+		ActionTracker tracker = action_tracker[index];
+		tracker.conf++;
 		/* maintain the recency order */
-		action_tracker.erase(it);
-		action_tracker.push_back((*it));
+		for(; index + 1 < num_action_trackers; ++index)
+		{
+			action_tracker[index] = action_tracker[index + 1];
+		}
+		action_tracker[num_action_trackers - 1] = tracker;
 	}
 	else
 	{
-		if(action_tracker.size() >= knob::scooby_action_tracker_size)
+		if(num_action_trackers >= knob::scooby_action_tracker_size)
 		{
-			ActionTracker *victim = action_tracker.front();
-			action_tracker.pop_front();
-			delete victim;
+			for(index = 0; index + 1 < num_action_trackers; ++index)
+			{
+				action_tracker[index] = action_tracker[index + 1];
+			}
+			num_action_trackers--;
 		}
-		action_tracker.push_back(new ActionTracker(pref_offset, 0));
+		action_tracker[num_action_trackers++] = ActionTracker(pref_offset, 0);
 	}
 }
 
 bool Scooby_STEntry::search_action_tracker(int32_t action, uint32_t &conf)
 {
 	conf = 0;
-	auto it = find_if(action_tracker.begin(), action_tracker.end(), [action](ActionTracker *at){return at->action == action;});
-	if(it != action_tracker.end())
+	for(uint32_t index = 0; index < num_action_trackers; ++index)
 	{
-		conf = (*it)->conf;
-		return true;
-	}
-	else
-	{
-		return false;
+		if(action_tracker[index].action == action)
+		{
+			conf = action_tracker[index].conf;
+			return true;
+		}
 	}
+	return false;
 }
 
 void ScoobyRecorder::record_access(uint64_t pc, uint64_t address, uint64_t page, uint32_t offset, uint8_t bw_level)
@@ -487,7 +526,7 @@ void print_access_debug(Scooby_STEntry *stentry)
 	bool to_print = true;
 	if(knob::scooby_print_access_debug_pc)
 	{
-		if(stentry->unique_pcs.find(knob::scooby_print_access_debug_pc) == stentry->unique_pcs.end())
+		if(!stentry->has_unique_pc(knob::scooby_print_access_debug_pc))
 		{
 			to_print = false;
 		}
@@ -512,7 +551,7 @@ void print_access_debug(Scooby_STEntry *stentry)
 	// 	return;
 	// }
 	uint32_t trigger_offset = stentry->offsets.front();
-	uint32_t unique_pc_count = stentry->unique_pcs.size();
+	uint32_t unique_pc_count = stentry->num_unique_pcs;
 	fprintf(stdout, "[ACCESS] %16lx|%16lx|%2u|%2u|%64s|%64s|%2u|%2u|%2u|%2u|%2u|",
 		stentry->page,
 		trigger_pc,
@@ -526,14 +565,17 @@ void print_access_debug(Scooby_STEntry *stentry)
 		BitmapHelper::count_bits_diff(stentry->bmp_real, stentry->bmp_pred), /* uncovered */
 		BitmapHelper::count_bits_diff(stentry->bmp_pred, stentry->bmp_real)  /* over prediction */
 	);
-	for (const uint64_t& pc: stentry->unique_pcs)
+	for(uint32_t index = 0; index < stentry->num_unique_pcs; ++index)
 	{
-		fprintf(stdout, "%lx,", pc);
+		fprintf(stdout, "%lx,", stentry->unique_pcs[index]);
 	}
 	fprintf(stdout, "|");
-	for (const int32_t& delta: stentry->unique_deltas)
+	for(int32_t delta = -63; delta <= 63; ++delta)
 	{
-		fprintf(stdout, "%d,", delta);
+		if(stentry->unique_deltas.contains(delta))
+		{
+			fprintf(stdout, "%d,", delta);
+		}
 	}
 	fprintf(stdout, "\n");
 }
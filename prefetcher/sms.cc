@@ -50,9 +50,12 @@ SMSPrefetcher::SMSPrefetcher(string type) : Prefetcher(type)
 	init_stats();
 	print_config();
 
-	/* init PHT */
-	deque<PHTEntry*> d;
-	pht.resize(pht_sets, d);
+	/* the filter and accumulation tables are fully associative */
+	filter_table.init(1, knob::sms_ft_size);
+	acc_table.init(1, knob::sms_at_size);
+	pht.init(pht_sets, knob::sms_pht_assoc);
+	pht_reset.assign(pht_sets, 0);
+	pht_inserted = 0;
 }
 
 SMSPrefetcher::~SMSPrefetcher()
@@ -71,25 +74,25 @@ void SMSPrefetcher::invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cac
 	// 	<< " offset " << dec << setw(2) << offset
 	// 	<< endl;
 
-	auto at_index = search_acc_table(page);
+	uint32_t at_index = search_acc_table(page);
 	stats.at.lookup++;
-	if(at_index != acc_table.end())
+	if(at_index != acc_table.num_ways())
 	{
 		/* accumulation table hit */
 		stats.at.hit++;
-		(*at_index)->pattern[offset] = 1;
+		acc_table.entry(0, at_index).pattern[offset] = 1;
 		update_age_acc_table(at_index);
 	}
 	else
 	{
 		/* search filter table */
-		auto ft_index = search_filter_table(page);
+		uint32_t ft_index = search_filter_table(page);
 		stats.ft.lookup++;
-		if(ft_index != filter_table.end())
+		if(ft_index != filter_table.num_ways())
 		{
 			/* filter table hit */
 			stats.ft.hit++;
-			insert_acc_table((*ft_index), offset);
+			insert_acc_table(&filter_table.entry(0, ft_index), offset);
 			evict_filter_table(ft_index);
 		}
 		else
@@ -113,89 +116,76 @@ void SMSPrefetcher::invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cac
 }
 
 /* Functions for Filter table */
-deque<FTEntry*>::iterator SMSPrefetcher::search_filter_table(uint64_t page)
+uint32_t SMSPrefetcher::search_filter_table(uint64_t page)
 {
-	return find_if(filter_table.begin(), filter_table.end(), [page](FTEntry *ftentry){return (ftentry->page == page);});
+	return filter_table.find(0, page);
 }
 
 void SMSPrefetcher::insert_filter_table(uint64_t pc, uint64_t page, uint32_t offset)
 {
 	stats.ft.insert++;
-	FTEntry *ftentry = NULL;
-	if(filter_table.size() >= knob::sms_ft_size)
+	uint32_t index = filter_table.find_invalid(0);
+	if(index == filter_table.num_ways())
 	{
-		auto victim = search_victim_filter_table();
-		evict_filter_table(victim);
+		index = search_victim_filter_table();
+		evict_filter_table(index);
 	}
 
-	ftentry = new FTEntry();
-	ftentry->page = page;
-	ftentry->pc = pc;
-	ftentry->trigger_offset = offset;
-	filter_table.push_back(ftentry);
+	FTEntry &ftentry = filter_table.entry(0, index);
+	ftentry.page = page;
+	ftentry.pc = pc;
+	ftentry.trigger_offset = offset;
+	filter_table.insert(0, index, page);
 }
 
-deque<FTEntry*>::iterator SMSPrefetcher::search_victim_filter_table()
+uint32_t SMSPrefetcher::search_victim_filter_table()
 {
-	return filter_table.begin();
+	/* entries are only stamped when inserted, so the LRU entry is the oldest one */
+	return filter_table.find_lru(0);
 }
 
-void SMSPrefetcher::evict_filter_table(deque<FTEntry*>::iterator victim)
+void SMSPrefetcher::evict_filter_table(uint32_t victim)
 {
 	stats.ft.evict++;
-	FTEntry *ftentry = (*victim);
-	filter_table.erase(victim);
-	delete ftentry;
+	filter_table.erase(0, victim);
 }
 
 /* Functions for Accumulation Table */
-deque<ATEntry*>::iterator SMSPrefetcher::search_acc_table(uint64_t page)
+uint32_t SMSPrefetcher::search_acc_table(uint64_t page)
 {
-	return find_if(acc_table.begin(), acc_table.end(), [page](ATEntry *atentry){return (atentry->page == page);});	
+	return acc_table.find(0, page);
 }
 
 void SMSPrefetcher::insert_acc_table(FTEntry *ftentry, uint32_t offset)
 {
 	stats.at.insert++;
-	ATEntry *atentry = NULL;
-	if(acc_table.size() >= knob::sms_at_size)
+	uint32_t index = acc_table.find_invalid(0);
+	if(index == acc_table.num_ways())
 	{
-		auto victim = search_victim_acc_table();
-		evict_acc_table(victim);
+		index = search_victim_acc_table();
+		evict_acc_table(index);
 	}
 
-	atentry = new ATEntry();
-	atentry->pc = ftentry->pc;
-	atentry->page = ftentry->page;
-	atentry->trigger_offset = ftentry->trigger_offset;
-	atentry->pattern[ftentry->trigger_offset] = 1;
-	atentry->pattern[offset] = 1;
-	atentry->age = 0;
-	for(uint32_t index = 0; index < acc_table.size(); ++index) acc_table[index]->age++;
-	acc_table.push_back(atentry);
+	ATEntry &atentry = acc_table.entry(0, index);
+	atentry.reset();
+	atentry.pc = ftentry->pc;
+	atentry.page = ftentry->page;
+	atentry.trigger_offset = ftentry->trigger_offset;
+	atentry.pattern[ftentry->trigger_offset] = 1;
+	atentry.pattern[offset] = 1;
+	acc_table.insert(0, index, atentry.page);
 }
 
-deque<ATEntry*>::iterator SMSPrefetcher::search_victim_acc_table()
+uint32_t SMSPrefetcher::search_victim_acc_table()
 {
-	uint32_t max_age = 0;
-	deque<ATEntry*>::iterator it, victim;
-	for(it = acc_table.begin(); it != acc_table.end(); ++it)
-	{
-		if((*it)->age >= max_age)
-		{
-			max_age	 = (*it)->age;
-			victim = it;
-		}
-	}
-	return victim;
+	return acc_table.find_lru(0);
 }
 
-void SMSPrefetcher::evict_acc_table(deque<ATEntry*>::iterator victim)
+void SMSPrefetcher::evict_acc_table(uint32_t victim)
 {
 	stats.at.evict++;
-	ATEntry *atentry = (*victim);
+	ATEntry *atentry = &acc_table.entry(0, victim);
 	insert_pht_table(atentry);
-	acc_table.erase(victim);
 
 	// cout << "[PHT_INSERT] pc " << hex << setw(10) << atentry->pc
 	// 	<< " page " << hex << setw(10) << atentry->page
@@ -203,16 +193,12 @@ void SMSPrefetcher::evict_acc_table(deque<ATEntry*>::iterator victim)
 	// 	<< " pattern " << BitmapHelper::to_string(atentry->pattern)
 	// 	<< endl;
 
-	delete(atentry);
+	acc_table.erase(0, victim);
 }
 
-void SMSPrefetcher::update_age_acc_table(deque<ATEntry*>::iterator current)
+void SMSPrefetcher::update_age_acc_table(uint32_t current)
 {
-	for(auto it = acc_table.begin(); it != acc_table.end(); ++it)
-	{
-		(*it)->age++;
-	}
-	(*current)->age = 0;
+	acc_table.touch(0, current);
 }
 
 /* Functions for Pattern History Table */
@@ -226,71 +212,73 @@ void SMSPrefetcher::insert_pht_table(ATEntry *atentry)
 	// 	<< endl;
 
 	int32_t set = -1;
-	auto pht_index = search_pht(signature, &set);
+	uint32_t pht_index = search_pht(signature, &set);
 	assert(set != -1);
-	if(pht_index != pht[set].end())
+	if(pht_index != pht.num_ways())
 	{
 		/* PHT hit */
 		stats.pht.hit++;
-		(*pht_index)->pattern = atentry->pattern;
+		pht.entry(set, pht_index).pattern = atentry->pattern;
 		update_age_pht(set, pht_index);
 	}
 	else
 	{
 		/* PHT miss */
 		assert(set != -1);
-		if(pht[set].size() >= knob::sms_pht_assoc)
+		pht_index = pht.find_invalid(set);
+		if(pht_index == pht.num_ways())
 		{
-			auto victim = search_victim_pht(set);
-			evcit_pht(set, victim);
+			pht_index = search_victim_pht(set);
+			evcit_pht(set, pht_index);
 		}
 
 		stats.pht.insert++;
-		PHTEntry *phtentry = new PHTEntry();
-		phtentry->signature = signature;
-		phtentry->pattern = atentry->pattern;
-		phtentry->age = 0;
-		for(uint32_t index = 0; index < pht[set].size(); ++index) pht[set][index]->age = 0;
-		pht[set].push_back(phtentry);
+		PHTEntry &phtentry = pht.entry(set, pht_index);
+		phtentry.signature = signature;
+		phtentry.pattern = atentry->pattern;
+		phtentry.inserted = pht_inserted++;
+		pht.insert(set, pht_index, signature);
+		/* an insertion makes every entry of the set as young as the new one */
+		pht_reset[set] = pht.stamp(set, pht_index);
 	}
 }
 
-deque<PHTEntry*>::iterator SMSPrefetcher::search_pht(uint64_t signature, int32_t *set)
+uint32_t SMSPrefetcher::search_pht(uint64_t signature, int32_t *set)
 {
 	(*set) = signature % pht_sets;
-	return find_if(pht[(*set)].begin(), pht[(*set)].end(), [signature](PHTEntry *phtentry){return (phtentry->signature == signature);});	
+	return pht.find((*set), signature);
 }
 
-deque<PHTEntry*>::iterator SMSPrefetcher::search_victim_pht(int32_t set)
+uint32_t SMSPrefetcher::search_victim_pht(int32_t set)
 {
-	uint32_t max_age = 0;
-	deque<PHTEntry*>::iterator it, victim;
-	for(it = pht[set].begin(); it != pht[set].end(); ++it)
+	/* the least recently used entry, where entries not used since the latest
+	 * insertion into the set are equally old and the most recently inserted
+	 * of them goes first */
+	uint32_t victim = 0;
+	uint64_t victim_stamp = UINT64_MAX, victim_inserted = 0;
+	for(uint32_t way = 0; way < pht.num_ways(); ++way)
 	{
-		if((*it)->age >= max_age)
+		uint64_t stamp = max(pht.stamp(set, way), pht_reset[set]);
+		uint64_t inserted = pht.entry(set, way).inserted;
+		if(stamp < victim_stamp || (stamp == victim_stamp && inserted > victim_inserted))
 		{
-			max_age	 = (*it)->age;
-			victim = it;
+			victim = way;
+			victim_stamp = stamp;
+			victim_inserted = inserted;
 		}
 	}
 	return victim;
 }
 
-void SMSPrefetcher::update_age_pht(int32_t set, deque<PHTEntry*>::iterator current)
+void SMSPrefetcher::update_age_pht(int32_t set, uint32_t current)
 {
-	for(auto it = pht[set].begin(); it != pht[set].end(); ++it)
-	{
-		(*it)->age++;
-	}
-	(*current)->age = 0;
+	pht.touch(set, current);
 }
 
-void SMSPrefetcher::evcit_pht(int32_t set, deque<PHTEntry*>::iterator victim)
+void SMSPrefetcher::evcit_pht(int32_t set, uint32_t victim)
 {
 	stats.pht.evict++;
-	PHTEntry *phtentry = (*victim);
-	pht[set].erase(victim);
-	delete phtentry;
+	pht.erase(set, victim);
 }
 
 uint64_t SMSPrefetcher::create_signature(uint64_t pc, uint32_t offset)
@@ -306,15 +294,15 @@ int SMSPrefetcher::generate_prefetch(uint64_t pc, uint64_t address, uint64_t pag
 	stats.generate_prefetch.called++;
 	uint64_t signature = create_signature(pc, offset);
 	int32_t set = -1;
-	auto pht_index = search_pht(signature, &set);
+	uint32_t pht_index = search_pht(signature, &set);
 	assert(set != -1);
-	if(pht_index == pht[set].end())
+	if(pht_index == pht.num_ways())
 	{
 		stats.generate_prefetch.pht_miss++;
 		return 0;
 	}
 
-	PHTEntry *phtentry = (*pht_index);
+	PHTEntry *phtentry = &pht.entry(set, pht_index);
 	for(uint32_t index = 0; index < BITMAP_MAX_SIZE; ++index)
 	{
 		if(phtentry->pattern[index] && offset != index)
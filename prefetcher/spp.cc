@@ -33,7 +33,7 @@ namespace knob
 
 void SPP::init_knobs()
 {
-
+	assert(knob::spp_max_outcomes >= 1 && knob::spp_max_outcomes <= SPP_MAX_OUTCOMES);
 }
 
 void SPP::init_stats()
@@ -72,6 +72,15 @@ SPP::SPP(string type) : Prefetcher(type)
 	total_pref = 0;
 	used_pref = 0;
 	demand_counter = 0;
+
+	signature_table.init(1, knob::spp_st_size);
+	pattern_table.init(1, knob::spp_pt_size);
+	pt_oldest = pattern_table.num_ways();
+	pt_inserted = 0;
+	prefetch_filter.init(1, knob::spp_pf_size);
+	pf_next = 0;
+	ghr.resize(knob::spp_ghr_size);
+	ghr_head = ghr_count = 0;
 }
 
 SPP::~SPP()
@@ -97,12 +106,12 @@ void SPP::invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cache_hit, ui
 		register_demand_hit(address);
 	}
 
-	auto st_index = search_signature_table(page);
+	uint32_t st_index = search_signature_table(page);
 	stats.st.lookup++;
-	if(st_index != signature_table.end())
+	if(st_index != signature_table.num_ways())
 	{
 		stats.st.hit++;
-		STEntry *stentry = (*st_index);
+		STEntry *stentry = &signature_table.entry(0, st_index);
 		int32_t curr_delta = compute_delta(offset, stentry->last_offset);
 		uint64_t new_signature = compute_signature(stentry->signature, curr_delta);
 
@@ -160,60 +169,43 @@ void SPP::invoke_prefetcher(uint64_t pc, uint64_t address, uint8_t cache_hit, ui
 }
 
 /* Functions for Signature Table */
-deque<STEntry*>::iterator SPP::search_signature_table(uint64_t page)
+uint32_t SPP::search_signature_table(uint64_t page)
 {
-	return find_if(signature_table.begin(), signature_table.end(), [page](STEntry* stentry){return (stentry->page == page);});
+	return signature_table.find(0, page);
 }
 
-void SPP::update_age_signature_table(deque<STEntry*>::iterator st_index)
+void SPP::update_age_signature_table(uint32_t st_index)
 {
-	for(auto it = signature_table.begin(); it != signature_table.end(); ++it)
-	{
-		(*it)->age++;
-	}
-	(*st_index)->age = 0;
+	signature_table.touch(0, st_index);
 }
 
 void SPP::insert_signature_table(uint64_t page, uint32_t offset, uint64_t signature)
 {
 	stats.st.insert++;
-	if(signature_table.size() >= knob::spp_st_size)
+	uint32_t index = signature_table.find_invalid(0);
+	if(index == signature_table.num_ways())
 	{
-		auto victim = search_victim_signature_table();
-		evict_signature_table(victim);
+		index = search_victim_signature_table();
+		evict_signature_table(index);
 	}
 
-	STEntry *stentry = new STEntry();
-	stentry->page = page;
-	stentry->last_offset = offset;
-	stentry->signature = signature;
-	stentry->age = 0;
-	for(uint32_t index = 0; index < signature_table.size(); ++index) signature_table[index]->age++;
-	signature_table.push_back(stentry);	
-	// cout << "    [ST_insert] " << stentry->to_string() << endl;
+	STEntry &stentry = signature_table.entry(0, index);
+	stentry.page = page;
+	stentry.last_offset = offset;
+	stentry.signature = signature;
+	signature_table.insert(0, index, page);
+	// cout << "    [ST_insert] " << stentry.to_string() << endl;
 }
 
-deque<STEntry*>::iterator SPP::search_victim_signature_table()
+uint32_t SPP::search_victim_signature_table()
 {
-	deque<STEntry*>::iterator it, victim;
-	uint32_t max_age = 0;
-	for(it = signature_table.begin(); it != signature_table.end(); ++it)
-	{
-		if((*it)->age > max_age)
-		{
-			max_age = (*it)->age;
-			victim = it;
-		}
-	}
-	return victim;
+	return signature_table.find_lru(0);
 }
 
-void SPP::evict_signature_table(deque<STEntry*>::iterator victim)
+void SPP::evict_signature_table(uint32_t victim)
 {
 	stats.st.evict++;
-	STEntry *stentry = (*victim);
-	signature_table.erase(victim);
-	delete stentry;
+	signature_table.erase(0, victim);
 }
 
 /* Functions for Pattern Table */
@@ -221,11 +213,11 @@ void SPP::update_pattern_table(uint64_t signature, int32_t delta)
 {
 	stats.pt.lookup++;
 	PTEntry *ptentry = NULL;
-	auto pt_index = search_pattern_table(signature);
-	if(pt_index != pattern_table.end())
+	uint32_t pt_index = search_pattern_table(signature);
+	if(pt_index != pattern_table.num_ways())
 	{
 		stats.pt.hit++;
-		ptentry = (*pt_index);
+		ptentry = &pattern_table.entry(0, pt_index);
 		// cout << "    [PT_b] " << ptentry->to_string() << endl;
 		ptentry->update_delta(delta);
 		incr_counter(ptentry->occurence, knob::spp_max_confidence_counter_value);
@@ -241,96 +233,102 @@ void SPP::update_pattern_table(uint64_t signature, int32_t delta)
 void SPP::insert_pattern_table(uint64_t signature, int32_t delta)
 {
 	stats.pt.insert++;
-	if(pattern_table.size() >= knob::spp_pt_size)
+	uint32_t index = pattern_table.find_invalid(0);
+	if(index == pattern_table.num_ways())
 	{
-		auto victim = search_victim_pattern_table();
-		evict_pattern_table(victim);
+		index = search_victim_pattern_table();
+		evict_pattern_table(index);
 	}
 
-	PTEntry *ptentry = new PTEntry();
-	ptentry->signature = signature;
-	incr_counter(ptentry->occurence, knob::spp_max_confidence_counter_value);
-	ptentry->update_delta(delta);
-	ptentry->age = 0;
-	for(uint32_t index = 0; index < pattern_table.size(); ++index) pattern_table[index]->age++;
-	pattern_table.push_back(ptentry);
-	// cout << "    [PT_insert] " << ptentry->to_string() << endl;
-}
-
-deque<PTEntry*>::iterator SPP::search_pattern_table(uint64_t signature)
-{
-	return find_if(pattern_table.begin(), pattern_table.end(), [signature](PTEntry *ptentry){return (ptentry->signature = signature);});
+	PTEntry &ptentry = pattern_table.entry(0, index);
+	ptentry.reset();
+	ptentry.signature = signature;
+	ptentry.inserted = pt_inserted++;
+	incr_counter(ptentry.occurence, knob::spp_max_confidence_counter_value);
+	ptentry.update_delta(delta);
+	pattern_table.insert(0, index, signature);
+	if(pt_oldest == pattern_table.num_ways())
+	{
+		pt_oldest = index;
+	}
+	// cout << "    [PT_insert] " << ptentry.to_string() << endl;
 }
 
-deque<PTEntry*>::iterator SPP::search_victim_pattern_table()
+uint32_t SPP::search_pattern_table(uint64_t signature)
 {
-	deque<PTEntry*>::iterator it, victim;
-	uint32_t max_age = 0;
-	for(it = pattern_table.begin(); it != pattern_table.end(); ++it)
+	/* NOTE: this lookup has always assigned the signature to the entries instead of
+	 * comparing it, so a non-zero signature hits the oldest entry and zero misses.
+	 * It is kept that way so that SPP results stay comparable to earlier runs. */
+	if(signature == 0 || pt_oldest == pattern_table.num_ways())
 	{
-		if((*it)->age > max_age)
-		{
-			max_age = (*it)->age;
-			victim = it;
-		}
+		return pattern_table.num_ways();
 	}
-	return victim;	
+	pattern_table.entry(0, pt_oldest).signature = signature;
+	return pt_oldest;
 }
 
-void SPP::evict_pattern_table(deque<PTEntry*>::iterator victim)
+uint32_t SPP::search_victim_pattern_table()
 {
-	stats.pt.evict++;
-	PTEntry *ptentry = (*victim);
-	pattern_table.erase(victim);
-	delete ptentry;
+	return pattern_table.find_lru(0);
 }
 
-void SPP::update_age_pattern_table(deque<PTEntry*>::iterator pt_index)
+void SPP::evict_pattern_table(uint32_t victim)
 {
-	for(auto it = pattern_table.begin(); it != pattern_table.end(); ++it)
+	stats.pt.evict++;
+	pattern_table.erase(0, victim);
+	if(victim == pt_oldest)
 	{
-		(*it)->age++;
+		pt_oldest = pattern_table.num_ways();
+		for(uint32_t index = 0; index < pattern_table.num_ways(); ++index)
+		{
+			if(pattern_table.is_valid(0, index)
+				&& (pt_oldest == pattern_table.num_ways() || pattern_table.entry(0, index).inserted < pattern_table.entry(0, pt_oldest).inserted))
+			{
+				pt_oldest = index;
+			}
+		}
 	}
-	(*pt_index)->age = 0;
+}
+
+void SPP::update_age_pattern_table(uint32_t pt_index)
+{
+	pattern_table.touch(0, pt_index);
 }
 
 /* PTEntry functions */
 void PTEntry::update_delta(int32_t delta)
 {
-	Outcome *outcome = NULL;
-	auto oindex = find_if(outcomes.begin(), outcomes.end(), [delta](Outcome *outcome){return (outcome->delta == delta);});
-	if(oindex != outcomes.end())
+	uint32_t oindex = 0;
+	while(oindex < num_outcomes && outcomes[oindex].delta != delta) oindex++;
+	if(oindex < num_outcomes)
 	{
-		incr_counter((*oindex)->occurence, knob::spp_max_confidence_counter_value);
+		incr_counter(outcomes[oindex].occurence, knob::spp_max_confidence_counter_value);
 	}
 	else
 	{
-		if(outcomes.size() >= knob::spp_max_outcomes)
+		if(num_outcomes >= knob::spp_max_outcomes)
 		{
-			outcome = outcomes.back();
-			outcomes.pop_back();
-			delete outcome;
+			num_outcomes--; /* replace the least frequent outcome */
 		}
 
-		outcome = new Outcome();
-		outcome->delta = delta;
-		outcome->occurence = 1;
-		outcomes.push_back(outcome);
+		outcomes[num_outcomes].delta = delta;
+		outcomes[num_outcomes].occurence = 1;
+		num_outcomes++;
 	}
-	sort(outcomes.begin(), outcomes.end(), [](Outcome *o1, Outcome *o2){return (o1->occurence >= o2->occurence);});
+	sort(outcomes, outcomes + num_outcomes, [](const Outcome &o1, const Outcome &o2){return (o1.occurence >= o2.occurence);});
 }
 
 void PTEntry::get_satisfying_deltas(double confidence, vector<int32_t> &satisfying_deltas, int32_t &max_delta, uint32_t &max_delta_occur)
 {
-	assert(outcomes.size() != 0);
-	max_delta = outcomes.front()->delta;
-	max_delta_occur = outcomes.front()->occurence;
-	for(uint32_t index = 0; index < outcomes.size(); ++index)
+	assert(num_outcomes != 0);
+	max_delta = outcomes[0].delta;
+	max_delta_occur = outcomes[0].occurence;
+	for(uint32_t index = 0; index < num_outcomes; ++index)
 	{
-		double conf = confidence * ((double)outcomes[index]->occurence / occurence);
+		double conf = confidence * ((double)outcomes[index].occurence / occurence);
 		if((100*conf) >= knob::spp_max_confidence)
 		{
-			satisfying_deltas.push_back(outcomes[index]->delta);
+			satisfying_deltas.push_back(outcomes[index].delta);
 		}
 		else
 		{
@@ -343,12 +341,11 @@ string PTEntry::to_string()
 {
 	stringstream ss;
 	ss << "sig: " << hex << setw(12) << signature
-		<< " occ: " << dec << setw(3) << occurence
-		<< " age: " << dec << setw(4) << age << " "
+		<< " occ: " << dec << setw(3) << occurence << " "
 		;
-	for(uint32_t index = 0; index < outcomes.size(); ++index)
+	for(uint32_t index = 0; index < num_outcomes; ++index)
 	{
-		ss << "(" << outcomes[index]->delta << "," << outcomes[index]->occurence << ")";
+		ss << "(" << outcomes[index].delta << "," << outcomes[index].occurence << ")";
 	}
 	return ss.str();
 }
@@ -360,7 +357,6 @@ string STEntry::to_string()
 	ss << "page: " << hex << setw(10) << page
 		<< " offset: " << dec << setw(2) << last_offset
 		<< " sig: " << hex << setw(12) << signature
-		<< " age: " << dec << setw(4) << age
 		;
 	return ss.str(); 
 }
@@ -385,13 +381,13 @@ void SPP::generate_prefetch(uint64_t page, uint32_t offset, uint64_t signature,
 
 	while((100*curr_confidence) >= knob::spp_max_confidence && depth < knob::spp_max_depth)
 	{
-		auto pt_index = search_pattern_table(signature);
-		if(pt_index == pattern_table.end())
+		uint32_t pt_index = search_pattern_table(signature);
+		if(pt_index == pattern_table.num_ways())
 		{
 			break;
 		}
 
-		PTEntry *ptentry = (*pt_index);
+		PTEntry *ptentry = &pattern_table.entry(0, pt_index);
 		vector<int32_t> satisfying_deltas;
 		int32_t max_delta = 0;
 		uint32_t max_delta_occur = 0;
@@ -550,8 +546,8 @@ void SPP::filter_prefetch(vector<uint64_t> tmp_pref_addr, vector<uint64_t> &pref
 	for(uint32_t index = 0; index < tmp_pref_addr.size(); ++index)
 	{
 		stats.pref_filter.lookup[from_ghr]++;
-		auto it = search_prefetch_filter(tmp_pref_addr[index]);
-		if(it != prefetch_filter.end())
+		uint32_t pf_index = search_prefetch_filter(tmp_pref_addr[index]);
+		if(pf_index != prefetch_filter.num_ways())
 		{
 			stats.pref_filter.hit[from_ghr]++;
 		}
@@ -565,57 +561,64 @@ void SPP::filter_prefetch(vector<uint64_t> tmp_pref_addr, vector<uint64_t> &pref
 	}
 }
 
-deque<PFEntry*>::iterator SPP::search_prefetch_filter(uint64_t address)
+uint32_t SPP::search_prefetch_filter(uint64_t address)
 {
-	return find_if(prefetch_filter.begin(), prefetch_filter.end(), [address](PFEntry *pfentry){return (pfentry->address == address);});
+	return prefetch_filter.find(0, address);
 }
 
 void SPP::insert_prefetch_filter(uint64_t address, bool from_ghr)
 {
 	stats.pref_filter.insert[from_ghr]++;
-	if(prefetch_filter.size() >= knob::spp_pf_size)
+	uint32_t index;
+	if(prefetch_filter.full(0))
+	{
+		index = search_victim_prefetch_filter();
+		evict_prefetch_filter(index);
+	}
+	else
 	{
-		auto victim = search_victim_prefetch_filter();
-		evict_prefetch_filter(victim);
+		index = prefetch_filter.find_invalid(0);
 	}
 
-	PFEntry *pfentry = new PFEntry();
-	pfentry->address = address;
-	pfentry->demand_hit = false;
-	pfentry->from_ghr = from_ghr;
-	prefetch_filter.push_back(pfentry);
+	PFEntry &pfentry = prefetch_filter.entry(0, index);
+	pfentry.address = address;
+	pfentry.demand_hit = false;
+	pfentry.from_ghr = from_ghr;
+	prefetch_filter.insert(0, index, address);
+	pf_next = (index + 1) % prefetch_filter.num_ways();
 }
 
-deque<PFEntry*>::iterator SPP::search_victim_prefetch_filter()
+uint32_t SPP::search_victim_prefetch_filter()
 {
-	return prefetch_filter.begin();
+	/* entries are only ever replaced, so the filter fills up in order and the oldest entry follows the latest one */
+	return pf_next;
 }
 
-void SPP::evict_prefetch_filter(deque<PFEntry*>::iterator victim)
+void SPP::evict_prefetch_filter(uint32_t victim)
 {
-	PFEntry *pfentry = (*victim);
-	stats.pref_filter.evict[pfentry->from_ghr]++;
-	if(!pfentry->demand_hit)
+	PFEntry &pfentry = prefetch_filter.entry(0, victim);
+	stats.pref_filter.evict[pfentry.from_ghr]++;
+	if(!pfentry.demand_hit)
 	{
-		stats.pref_filter.evict_not_demanded[pfentry->from_ghr]++;
+		stats.pref_filter.evict_not_demanded[pfentry.from_ghr]++;
 	}
-	prefetch_filter.erase(victim);
-	delete pfentry;
+	prefetch_filter.erase(0, victim);
 }
 
 void SPP::register_demand_hit(uint64_t address)
 {
 	address = (address >> LOG2_BLOCK_SIZE) << LOG2_BLOCK_SIZE;
-	auto it = search_prefetch_filter(address);
-	if(it != prefetch_filter.end())
+	uint32_t pf_index = search_prefetch_filter(address);
+	if(pf_index != prefetch_filter.num_ways())
 	{
-		if(!(*it)->demand_hit)
+		PFEntry &pfentry = prefetch_filter.entry(0, pf_index);
+		if(!pfentry.demand_hit)
 		{
-			(*it)->demand_hit = true;
-			stats.pref_filter.demand_seen_unique[(*it)->from_ghr]++;
+			pfentry.demand_hit = true;
+			stats.pref_filter.demand_seen_unique[pfentry.from_ghr]++;
 			incr_counter(used_pref, knob::spp_max_global_counter_value);
 		}
-		stats.pref_filter.demand_seen[(*it)->from_ghr]++;
+		stats.pref_filter.demand_seen[pfentry.from_ghr]++;
 	}
 	demand_counter++;
 	if(demand_counter >= knob::spp_alpha_epoch)
@@ -664,33 +667,33 @@ void SPP::insert_ghr(uint64_t signature, uint32_t offset, int32_t delta, double
 	// 	<< endl;
 
 	stats.ghr.insert++;
-	GHREntry *ghrentry = NULL;
-	if(ghr.size() >= knob::spp_ghr_size)
+	if(ghr_count >= knob::spp_ghr_size)
 	{
-		auto victim = ghr.begin();
-		ghrentry = (*victim);
-		ghr.erase(victim);
-		delete ghrentry;
+		/* evict the oldest entry */
+		ghr_head = (ghr_head + 1) % knob::spp_ghr_size;
+		ghr_count--;
 		stats.ghr.evict++;
 	}
 
-	ghrentry = new GHREntry();
-	ghrentry->signature = signature;
-	ghrentry->offset = offset;
-	ghrentry->delta = delta;
-	ghrentry->confidence = confidence;
-	ghr.push_back(ghrentry);
+	GHREntry &ghrentry = ghr[(ghr_head + ghr_count) % knob::spp_ghr_size];
+	ghrentry.signature = signature;
+	ghrentry.offset = offset;
+	ghrentry.delta = delta;
+	ghrentry.confidence = confidence;
+	ghr_count++;
 }
 
 bool SPP::lookup_ghr(uint32_t offset, uint64_t &signature, double &confidence)
 {
-	for(uint32_t index = 0; index < ghr.size(); ++index)
+	/* oldest entry first */
+	for(uint32_t index = 0; index < ghr_count; ++index)
 	{
-		if(compute_congruent_offset(ghr[index]->offset, ghr[index]->delta) == offset)
+		GHREntry &ghrentry = ghr[(ghr_head + index) % knob::spp_ghr_size];
+		if(compute_congruent_offset(ghrentry.offset, ghrentry.delta) == offset)
 		{
-			signature = ghr[index]->signature;
-			confidence = ghr[index]->confidence;
-			// cout << "[GHR_hit] offset " << offset << " ghr.offset " << ghr[index]->offset << " ghr.delta " << ghr[index]->delta << endl; 
+			signature = ghrentry.signature;
+			confidence = ghrentry.confidence;
+			// cout << "[GHR_hit] offset " << offset << " ghr.offset " << ghrentry.offset << " ghr.delta " << ghrentry.delta << endl; 
 			return true;
 		}
 	}
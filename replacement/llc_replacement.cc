@@ -51,3 +51,10 @@ void CACHE::llc_replacement_final_stats()
 {
 
 }
+
+// checkpoint the replacement state
+void CACHE::llc_checkpoint_replacement(CHECKPOINT_FILE &checkpoint)
+{
+    checkpoint.section("lru");
+    // the LRU stack lives in the cache blocks
+}
@@ -15,6 +15,7 @@ my $local = "0";
 my $ncores = 1;
 my $slurm_partition = "slurm_part";
 my $exclude_list;
+my $batch = 0;
 
 GetOptions('tlist=s' => \$tlist_file,
 	   'exp=s' => \$exp_file,
@@ -22,6 +23,7 @@ GetOptions('tlist=s' => \$tlist_file,
 	   'ncores=s' => \$ncores,
 	   'local=s' => \$local,
 	   'exclude=s' => \$exclude_list,
+	   'batch' => \$batch,
 ) or die "Usage: $0 --exe <executable> --exp <exp file> --tlist <trace list>\n";
 die "Supply exe\n" unless defined $exe;
 
@@ -37,7 +39,7 @@ if($ncores == 0)
 }
 
 # preamble for sbatch script
-if($local eq "0")
+if($local eq "0" and !$batch)
 {
 	print "#!/bin/bash -l\n";
 	print "#\n";
@@ -77,7 +79,12 @@ foreach $trace (@trace_info)
 		my $trace_knobs = $trace->{"KNOBS"};
 
 		my $cmdline;
-		if($local)
+		if($batch)
+		{
+			# a job line for --batch_jobs: the output file, then the arguments
+			$cmdline = "${trace_name}_${exp_name}.out $exp_knobs $trace_knobs -traces $trace_input";
+		}
+		elsif($local)
 		{
 			$cmdline = "$exe $exp_knobs $trace_knobs -traces $trace_input";
 		}
@@ -0,0 +1,173 @@
+#include <sys/wait.h>
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <set>
+
+#include "champsim.h"
+#include "instruction.h"
+#include "trace_reader.h"
+#include "compact_trace.h"
+#include "batch.h"
+
+using namespace std;
+
+namespace knob
+{
+    extern uint64_t warmup_instructions;
+    extern uint64_t simulation_instructions;
+    extern uint64_t skip_instructions;
+    extern uint8_t  knob_cloudsuite;
+    extern string   batch_jobs;
+    extern uint32_t batch_threads;
+    extern bool     batch_trace_cache;
+    extern uint64_t batch_cache_instructions;
+}
+
+vector<BATCH_JOB> read_batch_jobs(const char *job_file)
+{
+    ifstream file(job_file);
+    if (!file.good()) {
+        cerr << endl << "*** CANNOT OPEN BATCH JOB FILE: " << job_file << " ***" << endl;
+        assert(0);
+    }
+
+    vector<BATCH_JOB> jobs;
+    string line;
+    for (uint32_t line_number=1; getline(file, line); line_number++) {
+        istringstream tokens(line);
+        BATCH_JOB job;
+        if (!(tokens >> job.output) || (job.output[0] == '#'))
+            continue;
+
+        string arg;
+        bool has_traces = 0;
+        while (tokens >> arg) {
+            if (arg == "-traces")
+                has_traces = 1;
+            job.args.push_back(arg);
+        }
+
+        if (!has_traces) {
+            cerr << endl << "*** BATCH JOB WITHOUT -traces: " << job_file << ":" << line_number << " ***" << endl;
+            assert(0);
+        }
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+// decompresses the start of every distinct trace of the batch, num_threads traces at a time
+static void cache_batch_traces(const vector<BATCH_JOB> &jobs, uint32_t num_threads)
+{
+    // compact traces are indexed and decode fast enough on their own
+    set<string> names;
+    for (uint32_t i=0; i<jobs.size(); i++) {
+        bool found_traces = 0;
+        for (uint32_t j=0; j<jobs[i].args.size(); j++) {
+            if (found_traces && ifstream(jobs[i].args[j]).good() && !is_compact_trace(jobs[i].args[j].c_str()))
+                names.insert(jobs[i].args[j]);
+            else if (jobs[i].args[j] == "-traces")
+                found_traces = 1;
+        }
+    }
+    vector<string> traces(names.begin(), names.end());
+
+    uint64_t instructions = knob::batch_cache_instructions;
+    if (instructions == 0)
+        instructions = knob::skip_instructions + knob::warmup_instructions + knob::simulation_instructions + BATCH_CACHE_SLACK;
+    uint64_t max_bytes = instructions * (knob::knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr));
+
+    atomic<uint32_t> next_trace(0);
+    atomic<uint64_t> cached_bytes(0);
+    auto cache_worker = [&]() {
+        for (uint32_t i = next_trace++; i < traces.size(); i = next_trace++)
+            cached_bytes += cache_trace(traces[i].c_str(), max_bytes);
+    };
+
+    vector<thread> workers;
+    for (uint32_t i=0; i<min(num_threads, (uint32_t)traces.size()); i++)
+        workers.push_back(thread(cache_worker));
+    for (uint32_t i=0; i<workers.size(); i++)
+        workers[i].join();
+
+    cout << "Cached " << traces.size() << " traces (" << (cached_bytes >> 20) << " MB)" << endl;
+}
+
+// redirects the output of a job process and hands it the arguments of the job
+static void start_batch_job(const BATCH_JOB &job, int &argc, char **&argv)
+{
+    if (freopen(job.output.c_str(), "w", stdout) == NULL) {
+        cerr << endl << "*** CANNOT OPEN BATCH JOB OUTPUT: " << job.output << " ***" << endl;
+        _exit(1);
+    }
+    dup2(fileno(stdout), fileno(stderr));
+
+    char **job_argv = new char*[job.args.size() + 2];
+    job_argv[0] = argv[0];
+    for (uint32_t i=0; i<job.args.size(); i++)
+        job_argv[i+1] = strdup(job.args[i].c_str());
+    job_argv[job.args.size() + 1] = NULL;
+
+    argc = job.args.size() + 1;
+    argv = job_argv;
+}
+
+void run_batch(int &argc, char **&argv)
+{
+    vector<BATCH_JOB> jobs = read_batch_jobs(knob::batch_jobs.c_str());
+    uint32_t num_threads = knob::batch_threads ? knob::batch_threads : max(1u, thread::hardware_concurrency());
+
+    cout << endl << "Batch " << knob::batch_jobs << ": " << jobs.size() << " jobs, " << num_threads << " at a time" << endl;
+    if (knob::batch_trace_cache)
+        cache_batch_traces(jobs, num_threads);
+
+    map<pid_t, uint32_t> running;
+    uint32_t failed = 0;
+    for (uint32_t i=0; i<=jobs.size(); i++) {
+        // wait for a free slot, and for every job still running once all are started
+        while (running.size() && ((running.size() >= num_threads) || (i == jobs.size()))) {
+            int status;
+            pid_t pid = wait(&status);
+            if (pid < 0) {
+                cerr << endl << "*** BATCH LOST TRACK OF ITS JOBS ***" << endl;
+                assert(0);
+            }
+
+            uint32_t job = running[pid];
+            running.erase(pid);
+            cout << "Job " << job << " " << jobs[job].output;
+            if (WIFEXITED(status) && (WEXITSTATUS(status) == 0))
+                cout << " finished" << endl;
+            else {
+                failed++;
+                if (WIFSIGNALED(status))
+                    cout << " FAILED with signal " << WTERMSIG(status) << endl;
+                else
+                    cout << " FAILED with exit status " << WEXITSTATUS(status) << endl;
+            }
+        }
+
+        if (i == jobs.size())
+            break;
+
+        // nothing buffered may be written twice
+        cout.flush();
+        fflush(NULL);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << endl << "*** CANNOT START BATCH JOB " << i << " ***" << endl;
+            assert(0);
+        }
+        if (pid == 0) {
+            start_batch_job(jobs[i], argc, argv);
+            return;
+        }
+        running[pid] = i;
+    }
+
+    cout << "Batch finished: " << (jobs.size() - failed) << " of " << jobs.size() << " jobs completed" << endl;
+    exit(failed ? 1 : 0);
+}
@@ -1,78 +1,137 @@
 #include "block.h"
 
-int PACKET_QUEUE::check_queue(PACKET *packet)
+DEPENDENCY_TABLE packet_dependents[NUM_CPUS];
+
+DEPENDENTS &DEPENDENCY_TABLE::get(PACKET *packet)
 {
-    if ((head == tail) && occupancy == 0)
-        return -1;
+    if (packet->depend_id == NO_DEPENDENTS) {
+        if (free_ids.empty()) {
+            packet->depend_id = entries.size();
+            entries.push_back(DEPENDENTS());
+        }
+        else {
+            packet->depend_id = free_ids.back();
+            free_ids.pop_back();
+        }
 
-    if (head < tail) {
-        for (uint32_t i=head; i<tail; i++) {
-            if (NAME == "L1D_WQ") {
-                if (entry[i].full_addr == packet->full_addr) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-            else {
-                if (entry[i].address == packet->address) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
+        DEPENDENTS &dependents = entries[packet->depend_id];
+        dependents.rob_index_depend_on_me.clear();
+        dependents.lq_index_depend_on_me.clear();
+        dependents.sq_index_depend_on_me.clear();
+    }
+
+    return entries[packet->depend_id];
+}
+
+void DEPENDENCY_TABLE::release(PACKET *packet)
+{
+    if (packet->depend_id != NO_DEPENDENTS) {
+        free_ids.push_back(packet->depend_id);
+        packet->depend_id = NO_DEPENDENTS;
+    }
+}
+
+void QUEUE_INDEX::resize(uint32_t queue_size)
+{
+    // at most half full, so probe sequences stay short
+    uint32_t capacity = 1;
+    while (capacity < 2*queue_size)
+        capacity <<= 1;
+
+    delete[] slots;
+    slots = new SLOT[capacity];
+    mask = capacity - 1;
+    for (uint32_t i=0; i<capacity; i++)
+        slots[i].count = 0;
+}
+
+void QUEUE_INDEX::insert(uint64_t key, uint32_t index)
+{
+    uint32_t i = home(key);
+    for (; slots[i].count; i = (i + 1) & mask) {
+        if (slots[i].key == key) {
+            // a packet added later comes after the ones already queued
+            slots[i].count++;
+            return;
         }
     }
-    else {
-        for (uint32_t i=head; i<SIZE; i++) {
-            if (NAME == "L1D_WQ") {
-                if (entry[i].full_addr == packet->full_addr) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-            else {
-                if (entry[i].address == packet->address) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
+
+    slots[i].key = key;
+    slots[i].index = index;
+    slots[i].count = 1;
+}
+
+uint8_t QUEUE_INDEX::erase(uint64_t key, uint32_t index)
+{
+    uint32_t i = home(key);
+    for (; slots[i].key != key; i = (i + 1) & mask) {
+        if (slots[i].count == 0)
+            return 0;
+    }
+    if (slots[i].count == 0)
+        return 0;
+
+    if (slots[i].count > 1) {
+        slots[i].count--;
+        return (slots[i].index == index);
+    }
+
+    // shift the following slots of the probe sequence back into the hole
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & mask; slots[j].count; j = (j + 1) & mask) {
+        uint32_t h = home(slots[j].key);
+        if (((j - h) & mask) >= ((j - hole) & mask)) {
+            slots[hole] = slots[j];
+            hole = j;
         }
-        for (uint32_t i=0; i<tail; i++) {
-            if (NAME == "L1D_WQ") {
-                if (entry[i].full_addr == packet->full_addr) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
-            else {
-                if (entry[i].address == packet->address) {
-                    DP (if (warmup_complete[packet->cpu]) {
-                    cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
-                    cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
-                    cout << " cycle " << packet->event_cycle << endl; });
-                    return i;
-                }
-            }
+    }
+    slots[hole].count = 0;
+
+    return 0;
+}
+
+void QUEUE_INDEX::repoint(uint64_t key, uint32_t index)
+{
+    for (uint32_t i = home(key); slots[i].count; i = (i + 1) & mask) {
+        if (slots[i].key == key) {
+            slots[i].index = index;
+            return;
         }
     }
+}
+
+int PACKET_QUEUE::scan_queue(uint64_t key, int skip)
+{
+    for (uint32_t n=0; n<SIZE; n++) {
+        uint32_t i = (head + n) % SIZE;
+        if (((int)i != skip) && (match_key(&entry[i]) == key))
+            return i;
+    }
 
     return -1;
 }
 
+int PACKET_QUEUE::check_queue(PACKET *packet)
+{
+    if ((head == tail) && occupancy == 0)
+        return -1;
+
+    int i;
+    if (match == QUEUE_MATCH_NONE)
+        i = scan_queue(match_key(packet), -1);
+    else
+        i = index.find(match_key(packet));
+
+    if (i != -1) {
+        DP (if (warmup_complete[packet->cpu]) {
+        cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id << " same address: " << hex << packet->address;
+        cout << " full_addr: " << packet->full_addr << dec << " by instr_id: " << entry[i].instr_id << " index: " << i;
+        cout << " cycle " << packet->event_cycle << endl; });
+    }
+
+    return i;
+}
+
 void PACKET_QUEUE::add_queue(PACKET *packet)
 {
 #ifdef SANITY_CHECK
@@ -80,14 +139,17 @@ void PACKET_QUEUE::add_queue(PACKET *packet)
         assert(0);
 #endif
 
-    // add entry
+    // add entry, its dependents move along with it
     entry[tail] = *packet;
+    packet->depend_id = NO_DEPENDENTS;
 
     DP ( if (warmup_complete[packet->cpu]) {
     cout << "[" << NAME << "] " << __func__ << " cpu: " << packet->cpu << " instr_id: " << packet->instr_id;
     cout << " address: " << hex << entry[tail].address << " full_addr: " << entry[tail].full_addr << dec;
     cout << " head: " << head << " tail: " << tail << " occupancy: " << occupancy << " event_cycle: " << entry[tail].event_cycle << endl; });
 
+    track(tail);
+
     occupancy++;
     tail++;
     if (tail >= SIZE)
@@ -106,9 +168,17 @@ void PACKET_QUEUE::remove_queue(PACKET *packet)
     cout << " address: " << hex << packet->address << " full_addr: " << packet->full_addr << dec << " fill_level: " << packet->fill_level;
     cout << " head: " << head << " tail: " << tail << " occupancy: " << occupancy << " event_cycle: " << packet->event_cycle << endl; });
 
+    if (match != QUEUE_MATCH_NONE) {
+        uint32_t i = packet - entry;
+        uint64_t key = match_key(packet);
+        if (index.erase(key, i))
+            index.repoint(key, scan_queue(key, i));
+    }
+
     // reset entry
-    PACKET empty_packet;
-    *packet = empty_packet;
+    if (packet->depend_id != NO_DEPENDENTS)
+        packet_dependents[packet->cpu].release(packet);
+    packet->reset();
 
     occupancy--;
     head++;
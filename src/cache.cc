@@ -15,72 +15,163 @@ namespace knob
     extern uint32_t semi_perfect_cache_page_buffer_size;
     extern bool measure_cache_acc;
     extern uint32_t measure_cache_acc_epoch;
+    extern uint32_t itlb_set;
+    extern uint32_t itlb_way;
+    extern uint32_t itlb_rq_size;
+    extern uint32_t itlb_wq_size;
+    extern uint32_t itlb_pq_size;
+    extern uint32_t itlb_mshr_size;
+    extern uint32_t itlb_latency;
+    extern uint32_t dtlb_set;
+    extern uint32_t dtlb_way;
+    extern uint32_t dtlb_rq_size;
+    extern uint32_t dtlb_wq_size;
+    extern uint32_t dtlb_pq_size;
+    extern uint32_t dtlb_mshr_size;
+    extern uint32_t dtlb_latency;
+    extern uint32_t stlb_set;
+    extern uint32_t stlb_way;
+    extern uint32_t stlb_rq_size;
+    extern uint32_t stlb_wq_size;
+    extern uint32_t stlb_pq_size;
+    extern uint32_t stlb_mshr_size;
+    extern uint32_t stlb_latency;
+    extern uint32_t l1i_set;
+    extern uint32_t l1i_way;
+    extern uint32_t l1i_rq_size;
+    extern uint32_t l1i_wq_size;
+    extern uint32_t l1i_pq_size;
+    extern uint32_t l1i_mshr_size;
+    extern uint32_t l1i_latency;
+    extern uint32_t l1d_set;
+    extern uint32_t l1d_way;
+    extern uint32_t l1d_rq_size;
+    extern uint32_t l1d_wq_size;
+    extern uint32_t l1d_pq_size;
+    extern uint32_t l1d_mshr_size;
+    extern uint32_t l1d_latency;
+    extern uint32_t l2c_set;
+    extern uint32_t l2c_way;
+    extern uint32_t l2c_rq_size;
+    extern uint32_t l2c_wq_size;
+    extern uint32_t l2c_pq_size;
+    extern uint32_t l2c_mshr_size;
+    extern uint32_t l2c_latency;
+    extern uint32_t llc_set;
+    extern uint32_t llc_way;
+    extern uint32_t llc_rq_size;
+    extern uint32_t llc_wq_size;
+    extern uint32_t llc_pq_size;
+    extern uint32_t llc_mshr_size;
+    extern uint32_t llc_latency;
 }
 
 void print_cache_config()
 {
-    cout << "itlb_set " << ITLB_SET << endl
-        << "itlb_way " << ITLB_WAY << endl
-        << "itlb_rq_size " << ITLB_RQ_SIZE << endl
-        << "itlb_wq_size " << ITLB_WQ_SIZE << endl
-        << "itlb_pq_size " << ITLB_PQ_SIZE << endl
-        << "itlb_mshr_size " << ITLB_MSHR_SIZE << endl
-        << "itlb_latency " << ITLB_LATENCY << endl
+    cout << "itlb_set " << knob::itlb_set << endl
+        << "itlb_way " << knob::itlb_way << endl
+        << "itlb_rq_size " << knob::itlb_rq_size << endl
+        << "itlb_wq_size " << knob::itlb_wq_size << endl
+        << "itlb_pq_size " << knob::itlb_pq_size << endl
+        << "itlb_mshr_size " << knob::itlb_mshr_size << endl
+        << "itlb_latency " << knob::itlb_latency << endl
         << endl
-        << "dtlb_set " << DTLB_SET << endl
-        << "dtlb_way " << DTLB_WAY << endl
-        << "dtlb_rq_size " << DTLB_RQ_SIZE << endl
-        << "dtlb_wq_size " << DTLB_WQ_SIZE << endl
-        << "dtlb_pq_size " << DTLB_PQ_SIZE << endl
-        << "dtlb_mshr_size " << DTLB_MSHR_SIZE << endl
-        << "dtlb_latency " << DTLB_LATENCY << endl
+        << "dtlb_set " << knob::dtlb_set << endl
+        << "dtlb_way " << knob::dtlb_way << endl
+        << "dtlb_rq_size " << knob::dtlb_rq_size << endl
+        << "dtlb_wq_size " << knob::dtlb_wq_size << endl
+        << "dtlb_pq_size " << knob::dtlb_pq_size << endl
+        << "dtlb_mshr_size " << knob::dtlb_mshr_size << endl
+        << "dtlb_latency " << knob::dtlb_latency << endl
         << endl
-        << "stlb_set " << STLB_SET << endl
-        << "stlb_way " << STLB_WAY << endl
-        << "stlb_rq_size " << STLB_RQ_SIZE << endl
-        << "stlb_wq_size " << STLB_WQ_SIZE << endl
-        << "stlb_pq_size " << STLB_PQ_SIZE << endl
-        << "stlb_mshr_size " << STLB_MSHR_SIZE << endl
-        << "stlb_latency " << STLB_LATENCY << endl
+        << "stlb_set " << knob::stlb_set << endl
+        << "stlb_way " << knob::stlb_way << endl
+        << "stlb_rq_size " << knob::stlb_rq_size << endl
+        << "stlb_wq_size " << knob::stlb_wq_size << endl
+        << "stlb_pq_size " << knob::stlb_pq_size << endl
+        << "stlb_mshr_size " << knob::stlb_mshr_size << endl
+        << "stlb_latency " << knob::stlb_latency << endl
         << endl
-        << "l1i_size " << (L1I_SET*L1I_WAY*BLOCK_SIZE)/1024 << endl
-        << "l1i_set " << L1I_SET << endl
-        << "l1i_way " << L1I_WAY << endl
-        << "l1i_rq_size " << L1I_RQ_SIZE << endl
-        << "l1i_wq_size " << L1I_WQ_SIZE << endl
-        << "l1i_pq_size " << L1I_PQ_SIZE << endl
-        << "l1i_mshr_size " << L1I_MSHR_SIZE << endl
-        << "l1i_latency " << L1I_LATENCY << endl
+        << "l1i_size " << (knob::l1i_set*knob::l1i_way*BLOCK_SIZE)/1024 << endl
+        << "l1i_set " << knob::l1i_set << endl
+        << "l1i_way " << knob::l1i_way << endl
+        << "l1i_rq_size " << knob::l1i_rq_size << endl
+        << "l1i_wq_size " << knob::l1i_wq_size << endl
+        << "l1i_pq_size " << knob::l1i_pq_size << endl
+        << "l1i_mshr_size " << knob::l1i_mshr_size << endl
+        << "l1i_latency " << knob::l1i_latency << endl
         << endl
-        << "l1d_size " << (L1D_SET*L1D_WAY*BLOCK_SIZE)/1024 << endl
-        << "l1d_set " << L1D_SET << endl
-        << "l1d_way " << L1D_WAY << endl
-        << "l1d_rq_size " << L1D_RQ_SIZE << endl
-        << "l1d_wq_size " << L1D_WQ_SIZE << endl
-        << "l1d_pq_size " << L1D_PQ_SIZE << endl
-        << "l1d_mshr_size " << L1D_MSHR_SIZE << endl
-        << "l1d_latency " << L1D_LATENCY << endl
+        << "l1d_size " << (knob::l1d_set*knob::l1d_way*BLOCK_SIZE)/1024 << endl
+        << "l1d_set " << knob::l1d_set << endl
+        << "l1d_way " << knob::l1d_way << endl
+        << "l1d_rq_size " << knob::l1d_rq_size << endl
+        << "l1d_wq_size " << knob::l1d_wq_size << endl
+        << "l1d_pq_size " << knob::l1d_pq_size << endl
+        << "l1d_mshr_size " << knob::l1d_mshr_size << endl
+        << "l1d_latency " << knob::l1d_latency << endl
         << endl
-        << "l2c_size " << (L2C_SET*L2C_WAY*BLOCK_SIZE)/1024 << endl
-        << "l2c_set " << L2C_SET << endl
-        << "l2c_way " << L2C_WAY << endl
-        << "l2c_rq_size " << L2C_RQ_SIZE << endl
-        << "l2c_wq_size " << L2C_WQ_SIZE << endl
-        << "l2c_pq_size " << L2C_PQ_SIZE << endl
-        << "l2c_mshr_size " << L2C_MSHR_SIZE << endl
-        << "l2c_latency " << L2C_LATENCY << endl
+        << "l2c_size " << (knob::l2c_set*knob::l2c_way*BLOCK_SIZE)/1024 << endl
+        << "l2c_set " << knob::l2c_set << endl
+        << "l2c_way " << knob::l2c_way << endl
+        << "l2c_rq_size " << knob::l2c_rq_size << endl
+        << "l2c_wq_size " << knob::l2c_wq_size << endl
+        << "l2c_pq_size " << knob::l2c_pq_size << endl
+        << "l2c_mshr_size " << knob::l2c_mshr_size << endl
+        << "l2c_latency " << knob::l2c_latency << endl
         << endl
-        << "llc_size " << (LLC_SET*LLC_WAY*BLOCK_SIZE)/1024 << endl
-        << "llc_set " << LLC_SET << endl
-        << "llc_way " << LLC_WAY << endl
-        << "llc_rq_size " << LLC_RQ_SIZE << endl
-        << "llc_wq_size " << LLC_WQ_SIZE << endl
-        << "llc_pq_size " << LLC_PQ_SIZE << endl
-        << "llc_mshr_size " << LLC_MSHR_SIZE << endl
-        << "llc_latency " << LLC_LATENCY << endl
+        << "llc_size " << (knob::llc_set*knob::llc_way*BLOCK_SIZE)/1024 << endl
+        << "llc_set " << knob::llc_set << endl
+        << "llc_way " << knob::llc_way << endl
+        << "llc_rq_size " << knob::llc_rq_size << endl
+        << "llc_wq_size " << knob::llc_wq_size << endl
+        << "llc_pq_size " << knob::llc_pq_size << endl
+        << "llc_mshr_size " << knob::llc_mshr_size << endl
+        << "llc_latency " << knob::llc_latency << endl
         << endl;
 }
 
+void CACHE::set_geometry(uint32_t num_set, uint32_t num_way, uint32_t wq_size, uint32_t rq_size, uint32_t pq_size, uint32_t mshr_size)
+{
+    // sets are indexed with the low bits of the block address
+    if ((num_set == 0) || (num_set & (num_set - 1)) || (num_way == 0)) {
+        cerr << "[" << NAME << "] " << num_set << " sets of " << num_way << " ways, the number of sets must be a power of two ***" << endl;
+        assert(0);
+    }
+
+    if (block) {
+        for (uint32_t i=0; i<NUM_SET; i++)
+            delete[] block[i];
+        delete[] block;
+    }
+
+    NUM_SET = num_set;
+    NUM_WAY = num_way;
+    NUM_LINE = num_set * num_way;
+    set_mask = num_set - 1;
+    tag_store.resize(NUM_SET, NUM_WAY);
+
+    block = new BLOCK* [NUM_SET];
+    for (uint32_t i=0; i<NUM_SET; i++) {
+        block[i] = new BLOCK[NUM_WAY];
+
+        for (uint32_t j=0; j<NUM_WAY; j++) {
+            block[i][j].lru = j;
+        }
+    }
+
+    WQ_SIZE = wq_size;
+    RQ_SIZE = rq_size;
+    PQ_SIZE = pq_size;
+    MSHR_SIZE = mshr_size;
+    WQ.resize(WQ_SIZE);
+    RQ.resize(RQ_SIZE);
+    PQ.resize(PQ_SIZE);
+    MSHR.resize(MSHR_SIZE);
+
+    // at most one processed packet per ROB entry
+    PROCESSED.resize(ROB_SIZE);
+}
+
 void CACHE::handle_fill()
 {
     // handle fill
@@ -114,7 +205,7 @@ void CACHE::handle_fill()
         }
 
 #ifdef LLC_BYPASS
-        if ((cache_type == IS_LLC) && (way == LLC_WAY)) // this is a bypass that does not fill the LLC
+        if ((cache_type == IS_LLC) && (way == NUM_WAY)) // this is a bypass that does not fill the LLC
         {
             // update replacement policy
             if (cache_type == IS_LLC)
@@ -458,7 +549,7 @@ void CACHE::handle_writeback()
                     way = find_victim(writeback_cpu, WQ.entry[index].instr_id, set, block[set], WQ.entry[index].ip, WQ.entry[index].full_addr, WQ.entry[index].type);
 
 #ifdef LLC_BYPASS
-                if ((cache_type == IS_LLC) && (way == LLC_WAY)) {
+                if ((cache_type == IS_LLC) && (way == NUM_WAY)) {
                     cerr << "LLC bypassing for writebacks is not allowed!" << endl;
                     assert(0);
                 }
@@ -724,22 +815,30 @@ void CACHE::handle_read()
                     else if (mshr_index != -1) // already in-flight miss
                     {
                         // mark merged consumer
+                        DEPENDENTS *mshr_dependents = NULL,
+                                   *rq_dependents = packet_dependents[read_cpu].find(&RQ.entry[index]);
+                        if (tracks_dependents())
+                            mshr_dependents = &packet_dependents[read_cpu].get(&MSHR.entry[mshr_index]);
+
                         if (RQ.entry[index].type == RFO)
                         {
                             if (RQ.entry[index].tlb_access)
                             {
                                 uint32_t sq_index = RQ.entry[index].sq_index;
                                 MSHR.entry[mshr_index].store_merged = 1;
-                                MSHR.entry[mshr_index].sq_index_depend_on_me.insert (sq_index);
-                                MSHR.entry[mshr_index].sq_index_depend_on_me.join (RQ.entry[index].sq_index_depend_on_me, SQ_SIZE);
+                                if (mshr_dependents)
+                                {
+                                    mshr_dependents->sq_index_depend_on_me.insert (sq_index);
+                                    if (rq_dependents)
+                                        mshr_dependents->sq_index_depend_on_me.join (rq_dependents->sq_index_depend_on_me, SQ_SIZE);
+                                }
                             }
 
                             if (RQ.entry[index].load_merged)
                             {
-                                //uint32_t lq_index = RQ.entry[index].lq_index; 
                                 MSHR.entry[mshr_index].load_merged = 1;
-                                //MSHR.entry[mshr_index].lq_index_depend_on_me[lq_index] = 1;
-                                MSHR.entry[mshr_index].lq_index_depend_on_me.join (RQ.entry[index].lq_index_depend_on_me, LQ_SIZE);
+                                if (rq_dependents)
+                                    mshr_dependents->lq_index_depend_on_me.join (rq_dependents->lq_index_depend_on_me, LQ_SIZE);
                             }
                         }
                         else 
@@ -748,15 +847,16 @@ void CACHE::handle_read()
                             {
                                 uint32_t rob_index = RQ.entry[index].rob_index;
                                 MSHR.entry[mshr_index].instr_merged = 1;
-                                MSHR.entry[mshr_index].rob_index_depend_on_me.insert (rob_index);
+                                if (mshr_dependents)
+                                    mshr_dependents->rob_index_depend_on_me.insert (rob_index);
 
                                 DP (if (warmup_complete[MSHR.entry[mshr_index].cpu]) {
                                 cout << "[INSTR_MERGED] " << __func__ << " cpu: " << MSHR.entry[mshr_index].cpu << " instr_id: " << MSHR.entry[mshr_index].instr_id;
                                 cout << " merged rob_index: " << rob_index << " instr_id: " << RQ.entry[index].instr_id << endl; });
 
-                                if (RQ.entry[index].instr_merged) 
+                                if (RQ.entry[index].instr_merged && rq_dependents) 
                                 {
-                                    MSHR.entry[mshr_index].rob_index_depend_on_me.join (RQ.entry[index].rob_index_depend_on_me, ROB_SIZE);
+                                    mshr_dependents->rob_index_depend_on_me.join (rq_dependents->rob_index_depend_on_me, ROB_SIZE);
                                     DP (if (warmup_complete[MSHR.entry[mshr_index].cpu]) {
                                     cout << "[INSTR_MERGED] " << __func__ << " cpu: " << MSHR.entry[mshr_index].cpu << " instr_id: " << MSHR.entry[mshr_index].instr_id;
                                     cout << " merged rob_index: " << i << " instr_id: N/A" << endl; });
@@ -766,16 +866,19 @@ void CACHE::handle_read()
                             {
                                 uint32_t lq_index = RQ.entry[index].lq_index;
                                 MSHR.entry[mshr_index].load_merged = 1;
-                                MSHR.entry[mshr_index].lq_index_depend_on_me.insert (lq_index);
+                                if (mshr_dependents)
+                                    mshr_dependents->lq_index_depend_on_me.insert (lq_index);
 
                                 DP (if (warmup_complete[read_cpu]) {
                                 cout << "[DATA_MERGED] " << __func__ << " cpu: " << read_cpu << " instr_id: " << RQ.entry[index].instr_id;
                                 cout << " merged rob_index: " << RQ.entry[index].rob_index << " instr_id: " << RQ.entry[index].instr_id << " lq_index: " << RQ.entry[index].lq_index << endl; });
-                                MSHR.entry[mshr_index].lq_index_depend_on_me.join (RQ.entry[index].lq_index_depend_on_me, LQ_SIZE);
+                                if (rq_dependents)
+                                    mshr_dependents->lq_index_depend_on_me.join (rq_dependents->lq_index_depend_on_me, LQ_SIZE);
                                 if (RQ.entry[index].store_merged)
                                 {
                                     MSHR.entry[mshr_index].store_merged = 1;
-                                    MSHR.entry[mshr_index].sq_index_depend_on_me.join (RQ.entry[index].sq_index_depend_on_me, SQ_SIZE);
+                                    if (rq_dependents)
+                                        mshr_dependents->sq_index_depend_on_me.join (rq_dependents->sq_index_depend_on_me, SQ_SIZE);
                                 }
                             }
                         }
@@ -793,7 +896,10 @@ void CACHE::handle_read()
                             pf_late++;
                             uint8_t  prior_returned = MSHR.entry[mshr_index].returned;
                             uint64_t prior_event_cycle = MSHR.entry[mshr_index].event_cycle;
+                            // the demand request takes over the entry together with its own dependents
+                            packet_dependents[read_cpu].release(&MSHR.entry[mshr_index]);
                             MSHR.entry[mshr_index] = RQ.entry[index];
+                            RQ.entry[index].depend_id = NO_DEPENDENTS;
                             
                             // in case request is already returned, we should keep event_cycle and retunred variables
                             MSHR.entry[mshr_index].returned = prior_returned;
@@ -1106,19 +1212,42 @@ void CACHE::operate()
     handle_prefetch_feedback();
 }
 
+uint64_t CACHE::cycles_to_next_event()
+{
+    // every handler only looks at the head of its queue, so nothing happens before the heads are ready
+    uint64_t cycles = UINT64_MAX;
+
+    uint32_t fill_cpu = (MSHR.next_fill_index == MSHR_SIZE) ? NUM_CPUS : MSHR.entry[MSHR.next_fill_index].cpu;
+    if (fill_cpu != NUM_CPUS)
+        cycles = min(cycles, cycles_until(MSHR.next_fill_cycle, current_core_cycle[fill_cpu]));
+
+    uint32_t writeback_cpu = WQ.entry[WQ.head].cpu;
+    if ((writeback_cpu != NUM_CPUS) && (WQ.occupancy > 0))
+        cycles = min(cycles, cycles_until(WQ.entry[WQ.head].event_cycle, current_core_cycle[writeback_cpu]));
+
+    uint32_t read_cpu = RQ.entry[RQ.head].cpu;
+    if ((read_cpu != NUM_CPUS) && (RQ.occupancy > 0))
+        cycles = min(cycles, cycles_until(RQ.entry[RQ.head].event_cycle, current_core_cycle[read_cpu]));
+
+    uint32_t prefetch_cpu = PQ.entry[PQ.head].cpu;
+    if ((prefetch_cpu != NUM_CPUS) && (PQ.occupancy > 0))
+        cycles = min(cycles, cycles_until(PQ.entry[PQ.head].event_cycle, current_core_cycle[prefetch_cpu]));
+
+    // the accuracy epoch follows this cache's own cycle counter
+    if (knob::measure_cache_acc)
+        cycles = min(cycles, cycles_until(next_measure_cycle, cycle));
+
+    return cycles;
+}
+
 uint32_t CACHE::get_set(uint64_t address)
 {
-    return (uint32_t) (address & ((1 << lg2(NUM_SET)) - 1)); 
+    return (uint32_t) (address & set_mask);
 }
 
 uint32_t CACHE::get_way(uint64_t address, uint32_t set)
 {
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == address)) 
-            return way;
-    }
-
-    return NUM_WAY;
+    return tag_store.find(set, address);
 }
 
 void CACHE::fill_cache(uint32_t set, uint32_t way, PACKET *packet)
@@ -1160,6 +1289,7 @@ void CACHE::fill_cache(uint32_t set, uint32_t way, PACKET *packet)
     block[set][way].confidence = packet->confidence;
 
     block[set][way].tag = packet->address;
+    tag_store.set(set, way, packet->address);
     block[set][way].address = packet->address;
     block[set][way].full_addr = packet->full_addr;
     block[set][way].data = packet->data;
@@ -1209,19 +1339,16 @@ int CACHE::check_hit(PACKET *packet)
     }
 
     // hit
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == packet->address)) {
+    uint32_t way = tag_store.find(set, packet->address);
+    if (way < NUM_WAY) {
 
-            match_way = way;
+        match_way = way;
 
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "] " << __func__ << " instr_id: " << packet->instr_id << " type: " << +packet->type << hex << " addr: " << packet->address;
-            cout << " full_addr: " << packet->full_addr << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
-            cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru;
-            cout << " event: " << packet->event_cycle << " cycle: " << current_core_cycle[cpu] << endl; });
-
-            break;
-        }
+        DP ( if (warmup_complete[packet->cpu]) {
+        cout << "[" << NAME << "] " << __func__ << " instr_id: " << packet->instr_id << " type: " << +packet->type << hex << " addr: " << packet->address;
+        cout << " full_addr: " << packet->full_addr << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
+        cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru;
+        cout << " event: " << packet->event_cycle << " cycle: " << current_core_cycle[cpu] << endl; });
     }
 
     return match_way;
@@ -1239,25 +1366,109 @@ int CACHE::invalidate_entry(uint64_t inval_addr)
     }
 
     // invalidate
-    for (uint32_t way=0; way<NUM_WAY; way++) {
-        if (block[set][way].valid && (block[set][way].tag == inval_addr)) {
-
-            block[set][way].valid = 0;
+    uint32_t way = tag_store.find(set, inval_addr);
+    if (way < NUM_WAY) {
 
-            match_way = way;
+        block[set][way].valid = 0;
+        tag_store.invalidate(set, way);
 
-            DP ( if (warmup_complete[cpu]) {
-            cout << "[" << NAME << "] " << __func__ << " inval_addr: " << hex << inval_addr;  
-            cout << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
-            cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru << " cycle: " << current_core_cycle[cpu] << endl; });
+        match_way = way;
 
-            break;
-        }
+        DP ( if (warmup_complete[cpu]) {
+        cout << "[" << NAME << "] " << __func__ << " inval_addr: " << hex << inval_addr;  
+        cout << " tag: " << block[set][way].tag << " data: " << block[set][way].data << dec;
+        cout << " set: " << set << " way: " << way << " lru: " << block[set][way].lru << " cycle: " << current_core_cycle[cpu] << endl; });
     }
 
     return match_way;
 }
 
+void CACHE::functional_access(PACKET *packet)
+{
+    // functional warming while fast-forwarding: only the tags, the replacement state and the translations are updated,
+    // nothing goes through the queues and no stats are collected
+    uint32_t set = get_set(packet->address),
+             way = get_way(packet->address, set);
+    uint8_t  mark_dirty = (packet->type == WRITEBACK) || ((cache_type == IS_L1D) && (packet->type == RFO));
+
+    if (way < NUM_WAY) {
+        if (cache_type == IS_LLC)
+            llc_update_replacement_state(packet->cpu, set, way, packet->full_addr, packet->ip, 0, packet->type, 1);
+        else
+            update_replacement_state(packet->cpu, set, way, packet->full_addr, packet->ip, 0, packet->type, 1);
+
+        if (mark_dirty)
+            block[set][way].dirty = 1;
+        packet->data = block[set][way].data;
+
+        return;
+    }
+
+    // bring the block from the lower level first (the TLB data is the physical page)
+    if (packet->type != WRITEBACK) {
+        if (cache_type == IS_STLB)
+            packet->data = va_to_pa(packet->cpu, packet->instr_id, packet->full_addr, packet->address) >> LOG2_PAGE_SIZE;
+        else if (lower_level && (cache_type != IS_LLC))
+            ((CACHE *)lower_level)->functional_access(packet);
+    }
+
+    if (cache_type == IS_LLC)
+        way = llc_find_victim(packet->cpu, packet->instr_id, set, block[set], packet->ip, packet->full_addr, packet->type);
+    else
+        way = find_victim(packet->cpu, packet->instr_id, set, block[set], packet->ip, packet->full_addr, packet->type);
+
+#ifdef LLC_BYPASS
+    if ((cache_type == IS_LLC) && (way == NUM_WAY)) {
+        llc_update_replacement_state(packet->cpu, set, way, packet->full_addr, packet->ip, 0, packet->type, 0);
+        return;
+    }
+#endif
+
+    // dirty victims of the private caches are written back to the next level, the LLC drops them
+    if (block[set][way].valid && block[set][way].dirty && lower_level && ((cache_type == IS_L1D) || (cache_type == IS_L2C))) {
+        PACKET writeback_packet;
+
+        writeback_packet.fill_level = fill_level << 1;
+        writeback_packet.cpu = packet->cpu;
+        writeback_packet.address = block[set][way].address;
+        writeback_packet.full_addr = block[set][way].full_addr;
+        writeback_packet.data = block[set][way].data;
+        writeback_packet.instr_id = packet->instr_id;
+        writeback_packet.ip = 0; // writeback does not have ip
+        writeback_packet.type = WRITEBACK;
+
+        ((CACHE *)lower_level)->functional_access(&writeback_packet);
+    }
+
+    if (cache_type == IS_LLC)
+        llc_update_replacement_state(packet->cpu, set, way, packet->full_addr, packet->ip, block[set][way].full_addr, packet->type, 0);
+    else
+        update_replacement_state(packet->cpu, set, way, packet->full_addr, packet->ip, block[set][way].full_addr, packet->type, 0);
+
+    fill_cache(set, way, packet);
+
+    if (mark_dirty)
+        block[set][way].dirty = 1;
+}
+
+void CACHE::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+    checkpoint.section(NAME + " " + to_string(NUM_SET) + "x" + to_string(NUM_WAY));
+
+    // the LRU stack of the other caches lives in the blocks
+    for (uint32_t i=0; i<NUM_SET; i++)
+        checkpoint.transfer(block[i], NUM_WAY * sizeof(BLOCK));
+
+    if (checkpoint.restore) {
+        for (uint32_t i=0; i<NUM_SET; i++)
+            for (uint32_t j=0; j<NUM_WAY; j++)
+                tag_store.set(i, j, block[i][j].valid ? block[i][j].tag : INVALID_TAG);
+    }
+
+    if (cache_type == IS_LLC)
+        llc_checkpoint_replacement(checkpoint);
+}
+
 int CACHE::add_rq(PACKET *packet)
 {
     // check for the latest wirtebacks in the write queue
@@ -1308,7 +1519,8 @@ int CACHE::add_rq(PACKET *packet)
         
         if (packet->instruction) {
             uint32_t rob_index = packet->rob_index;
-            RQ.entry[index].rob_index_depend_on_me.insert (rob_index);
+            if (tracks_dependents())
+                packet_dependents[RQ.entry[index].cpu].get(&RQ.entry[index]).rob_index_depend_on_me.insert (rob_index);
             RQ.entry[index].instr_merged = 1;
 
             DP (if (warmup_complete[packet->cpu]) {
@@ -1321,12 +1533,14 @@ int CACHE::add_rq(PACKET *packet)
             if (packet->type == RFO) {
 
                 uint32_t sq_index = packet->sq_index;
-                RQ.entry[index].sq_index_depend_on_me.insert (sq_index);
+                if (tracks_dependents())
+                    packet_dependents[RQ.entry[index].cpu].get(&RQ.entry[index]).sq_index_depend_on_me.insert (sq_index);
                 RQ.entry[index].store_merged = 1;
             }
             else {
                 uint32_t lq_index = packet->lq_index; 
-                RQ.entry[index].lq_index_depend_on_me.insert (lq_index);
+                if (tracks_dependents())
+                    packet_dependents[RQ.entry[index].cpu].get(&RQ.entry[index]).lq_index_depend_on_me.insert (lq_index);
                 RQ.entry[index].load_merged = 1;
 
                 DP (if (warmup_complete[packet->cpu]) {
@@ -1361,6 +1575,7 @@ int CACHE::add_rq(PACKET *packet)
 #endif
 
     RQ.entry[index] = *packet;
+    RQ.track(index);
 
     // ADD LATENCY
     if (RQ.entry[index].event_cycle < current_core_cycle[packet->cpu])
@@ -1414,6 +1629,7 @@ int CACHE::add_wq(PACKET *packet)
     }
 
     WQ.entry[index] = *packet;
+    WQ.track(index);
 
     // ADD LATENCY
     if (WQ.entry[index].event_cycle < current_core_cycle[packet->cpu])
@@ -1578,6 +1794,7 @@ int CACHE::add_pq(PACKET *packet)
 #endif
 
     PQ.entry[index] = *packet;
+    PQ.track(index);
 
     // ADD LATENCY
     if (PQ.entry[index].event_cycle < current_core_cycle[packet->cpu])
@@ -1684,16 +1901,15 @@ void CACHE::update_fill_cycle()
 int CACHE::check_mshr(PACKET *packet)
 {
     // search mshr
-    for (uint32_t index=0; index<MSHR_SIZE; index++) {
-        if (MSHR.entry[index].address == packet->address) {
-            
-            DP ( if (warmup_complete[packet->cpu]) {
-            cout << "[" << NAME << "_MSHR] " << __func__ << " same entry instr_id: " << packet->instr_id << " prior_id: " << MSHR.entry[index].instr_id;
-            cout << " address: " << hex << packet->address;
-            cout << " full_addr: " << packet->full_addr << dec << endl; });
+    int index = MSHR.index.find(packet->address);
+    if (index != -1) {
 
-            return index;
-        }
+        DP ( if (warmup_complete[packet->cpu]) {
+        cout << "[" << NAME << "_MSHR] " << __func__ << " same entry instr_id: " << packet->instr_id << " prior_id: " << MSHR.entry[index].instr_id;
+        cout << " address: " << hex << packet->address;
+        cout << " full_addr: " << packet->full_addr << dec << endl; });
+
+        return index;
     }
 
     DP ( if (warmup_complete[packet->cpu]) {
@@ -1720,8 +1936,11 @@ void CACHE::add_mshr(PACKET *packet)
     for (index=0; index<MSHR_SIZE; index++) {
         if (MSHR.entry[index].address == 0) {
             
+            // the dependents move from the queue entry to the MSHR
             MSHR.entry[index] = *packet;
+            packet->depend_id = NO_DEPENDENTS;
             MSHR.entry[index].returned = INFLIGHT;
+            MSHR.track(index);
             MSHR.occupancy++;
 
             DP ( if (warmup_complete[packet->cpu]) {
@@ -0,0 +1,143 @@
+#include <sstream>
+#include <vector>
+
+#include "ooo_cpu.h"
+#include "uncore.h"
+#include "checkpoint.h"
+
+CHECKPOINT_FILE::CHECKPOINT_FILE(const char *checkpoint_name, uint8_t restore)
+    : name(checkpoint_name), restore(restore)
+{
+    file = fopen(checkpoint_name, restore ? "rb" : "wb");
+    if (file == NULL) {
+        cerr << endl << "*** CANNOT OPEN CHECKPOINT: " << name << " ***" << endl;
+        assert(0);
+    }
+
+    section(string(CHECKPOINT_MAGIC) + " " + to_string(CHECKPOINT_VERSION));
+}
+
+CHECKPOINT_FILE::~CHECKPOINT_FILE()
+{
+    if (fclose(file) != 0) {
+        cerr << endl << "*** CANNOT WRITE CHECKPOINT: " << name << " ***" << endl;
+        assert(0);
+    }
+}
+
+void CHECKPOINT_FILE::transfer(void *data, size_t size)
+{
+    size_t done = restore ? fread(data, 1, size, file) : fwrite(data, 1, size, file);
+    if (done != size) {
+        cerr << endl << "*** CHECKPOINT IS TRUNCATED OR CANNOT BE WRITTEN: " << name << " ***" << endl;
+        assert(0);
+    }
+}
+
+void CHECKPOINT_FILE::transfer(map<uint64_t, uint64_t> &table)
+{
+    uint64_t size = table.size();
+    value(size);
+
+    if (restore) {
+        table.clear();
+        for (uint64_t i=0; i<size; i++) {
+            pair<uint64_t, uint64_t> entry;
+            value(entry.first);
+            value(entry.second);
+            table.insert(table.end(), entry);
+        }
+    }
+    else {
+        for (map<uint64_t, uint64_t>::iterator it = table.begin(); it != table.end(); it++) {
+            uint64_t key = it->first;
+            value(key);
+            value(it->second);
+        }
+    }
+}
+
+void CHECKPOINT_FILE::section(const string &tag)
+{
+    uint32_t size = tag.size();
+    value(size);
+
+    string saved(size, '\0');
+    if (!restore)
+        saved = tag;
+    if (size)
+        transfer(&saved[0], size);
+
+    if (saved != tag) {
+        cerr << endl << "*** CHECKPOINT " << name << " DOES NOT MATCH THIS CONFIGURATION" << endl;
+        cerr << "expected: " << tag << " found: " << saved << " ***" << endl;
+        assert(0);
+    }
+}
+
+static void checkpoint_page_table(CHECKPOINT_FILE &checkpoint)
+{
+    page_table.checkpoint(checkpoint);
+
+    checkpoint.value(previous_ppage);
+    checkpoint.value(num_adjacent_page);
+    checkpoint.value(allocated_pages);
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        unique_cl[i].checkpoint(checkpoint);
+        checkpoint.value(num_page[i]);
+        checkpoint.value(minor_fault[i]);
+        checkpoint.value(major_fault[i]);
+    }
+
+    // the physical page allocator continues from the same random state
+    stringstream engine;
+    string engine_state;
+    if (!checkpoint.restore) {
+        engine << champsim_rand.engine;
+        engine_state = engine.str();
+    }
+    uint64_t size = engine_state.size();
+    checkpoint.value(size);
+    engine_state.resize(size);
+    if (size)
+        checkpoint.transfer(&engine_state[0], size);
+    if (checkpoint.restore) {
+        engine.str(engine_state);
+        engine >> champsim_rand.engine;
+    }
+}
+
+void checkpoint_simulator(const char *checkpoint_name, uint8_t restore)
+{
+    CHECKPOINT_FILE checkpoint(checkpoint_name, restore);
+
+    checkpoint.section("num_cpus " + to_string(NUM_CPUS));
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        checkpoint.section("cpu " + to_string(i));
+
+        // the timing model restarts from the oldest instruction that had not retired yet
+        uint64_t trace_position = ooo_cpu[i].trace_offset + ooo_cpu[i].num_retired;
+        checkpoint.value(trace_position);
+        if (restore)
+            ooo_cpu[i].trace_offset = trace_position;
+
+        ooo_cpu[i].checkpoint_branch_predictor(checkpoint);
+
+        ooo_cpu[i].ITLB.checkpoint(checkpoint);
+        ooo_cpu[i].DTLB.checkpoint(checkpoint);
+        ooo_cpu[i].STLB.checkpoint(checkpoint);
+        ooo_cpu[i].L1I.checkpoint(checkpoint);
+        ooo_cpu[i].L1D.checkpoint(checkpoint);
+        ooo_cpu[i].L2C.checkpoint(checkpoint);
+    }
+
+    uncore.LLC.checkpoint(checkpoint);
+    uncore.DRAM.checkpoint(checkpoint);
+
+    checkpoint_page_table(checkpoint);
+
+    checkpoint.section("end");
+
+    cout << (restore ? "Restored checkpoint " : "Saved checkpoint ") << checkpoint_name << endl;
+}
@@ -0,0 +1,445 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+
+#include <zlib.h>
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compact_trace.h"
+
+using namespace std;
+
+static inline void put_varint(vector<uint8_t> &buf, uint64_t value)
+{
+    while (value >= 0x80) {
+        buf.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buf.push_back(value);
+}
+
+// the decoder reads every byte through these, so a truncated or corrupt block stops the
+// simulation instead of reading past the decompressed buffer
+static void corrupt_compact_trace()
+{
+    cerr << endl << "*** CORRUPT COMPACT TRACE: BLOCK ENDS IN THE MIDDLE OF AN INSTRUCTION ***" << endl;
+    assert(0);
+    exit(1);
+}
+
+static inline uint8_t get_byte(const uint8_t *buf, uint32_t size, uint32_t &position)
+{
+    if (position >= size)
+        corrupt_compact_trace();
+    return buf[position++];
+}
+
+static inline uint64_t get_varint(const uint8_t *buf, uint32_t size, uint32_t &position)
+{
+    uint64_t value = 0;
+    uint32_t shift = 0;
+    uint8_t byte;
+    do {
+        if (shift >= 64)
+            corrupt_compact_trace();
+        byte = get_byte(buf, size, position);
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+static inline uint64_t zigzag(uint64_t delta)
+{
+    return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+}
+
+static inline uint64_t unzigzag(uint64_t value)
+{
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+bool is_compact_trace(const char *trace_name)
+{
+    char magic[8] = {0};
+    FILE *file = fopen(trace_name, "rb");
+    if (file == NULL)
+        return 0;
+    size_t magic_size = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    return (magic_size == sizeof(magic)) && (strcmp(magic, COMPACT_TRACE_MAGIC) == 0);
+}
+
+COMPACT_TRACE_WRITER::COMPACT_TRACE_WRITER(const char *trace_name, uint8_t cloudsuite, uint8_t codec, uint32_t block_size)
+{
+#ifndef ENABLE_ZSTD
+    if (codec == COMPACT_TRACE_CODEC_ZSTD) {
+        cerr << "*** ChampSim was built without zstd support ***" << endl;
+        assert(0);
+    }
+#endif
+
+    file = fopen(trace_name, "wb");
+    if (file == NULL) {
+        cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, COMPACT_TRACE_MAGIC);
+    header.version = COMPACT_TRACE_VERSION;
+    header.codec = codec;
+    header.num_destinations = cloudsuite ? NUM_INSTR_DESTINATIONS_SPARC : NUM_INSTR_DESTINATIONS;
+    header.num_sources = NUM_INSTR_SOURCES;
+    header.cloudsuite = cloudsuite;
+    header.block_size = block_size;
+    fwrite(&header, sizeof(header), 1, file);
+
+    num_instrs = 0;
+    block_instrs = 0;
+    last_ip = 0;
+    last_destination_memory = 0;
+    last_source_memory = 0;
+}
+
+COMPACT_TRACE_WRITER::~COMPACT_TRACE_WRITER()
+{
+    if (file)
+        close();
+}
+
+void COMPACT_TRACE_WRITER::write_instr(const cloudsuite_instr &instr)
+{
+    uint32_t num_destinations = header.num_destinations,
+             num_sources = header.num_sources,
+             bit = 2;
+    uint64_t mask = instr.is_branch | (instr.branch_taken << 1);
+
+    for (uint32_t i=0; i<num_destinations; i++, bit++)
+        if (instr.destination_registers[i])
+            mask |= 1ull << bit;
+    for (uint32_t i=0; i<num_sources; i++, bit++)
+        if (instr.source_registers[i])
+            mask |= 1ull << bit;
+    for (uint32_t i=0; i<num_destinations; i++, bit++)
+        if (instr.destination_memory[i])
+            mask |= 1ull << bit;
+    for (uint32_t i=0; i<num_sources; i++, bit++)
+        if (instr.source_memory[i])
+            mask |= 1ull << bit;
+
+    put_varint(raw, mask);
+    put_varint(raw, zigzag(instr.ip - last_ip));
+    last_ip = instr.ip;
+
+    for (uint32_t i=0; i<num_destinations; i++)
+        if (instr.destination_registers[i])
+            raw.push_back(instr.destination_registers[i]);
+    for (uint32_t i=0; i<num_sources; i++)
+        if (instr.source_registers[i])
+            raw.push_back(instr.source_registers[i]);
+
+    for (uint32_t i=0; i<num_destinations; i++) {
+        if (instr.destination_memory[i]) {
+            put_varint(raw, zigzag(instr.destination_memory[i] - last_destination_memory));
+            last_destination_memory = instr.destination_memory[i];
+        }
+    }
+    for (uint32_t i=0; i<num_sources; i++) {
+        if (instr.source_memory[i]) {
+            put_varint(raw, zigzag(instr.source_memory[i] - last_source_memory));
+            last_source_memory = instr.source_memory[i];
+        }
+    }
+
+    if (header.cloudsuite) {
+        raw.push_back(instr.asid[0]);
+        raw.push_back(instr.asid[1]);
+    }
+
+    num_instrs++;
+    block_instrs++;
+    if (block_instrs == header.block_size)
+        flush_block();
+}
+
+void COMPACT_TRACE_WRITER::flush_block()
+{
+    if (block_instrs == 0)
+        return;
+
+    compact_trace_block_header block;
+    block.raw_size = raw.size();
+    block.num_instrs = block_instrs;
+
+    if (header.codec == COMPACT_TRACE_CODEC_ZLIB) {
+        uLongf compressed_size = compressBound(raw.size());
+        compressed.resize(compressed_size);
+        if (compress2(compressed.data(), &compressed_size, raw.data(), raw.size(), Z_BEST_COMPRESSION) != Z_OK) {
+            cerr << "*** CANNOT COMPRESS TRACE BLOCK ***" << endl;
+            assert(0);
+        }
+        compressed.resize(compressed_size);
+    }
+#ifdef ENABLE_ZSTD
+    else if (header.codec == COMPACT_TRACE_CODEC_ZSTD) {
+        compressed.resize(ZSTD_compressBound(raw.size()));
+        size_t compressed_size = ZSTD_compress(compressed.data(), compressed.size(), raw.data(), raw.size(), 19);
+        if (ZSTD_isError(compressed_size)) {
+            cerr << "*** CANNOT COMPRESS TRACE BLOCK: " << ZSTD_getErrorName(compressed_size) << " ***" << endl;
+            assert(0);
+        }
+        compressed.resize(compressed_size);
+    }
+#endif
+    else
+        compressed = raw;
+    block.compressed_size = compressed.size();
+
+    compact_trace_index_entry entry;
+    entry.first_instr = num_instrs - block_instrs;
+    entry.offset = ftello(file);
+    index.push_back(entry);
+
+    fwrite(&block, sizeof(block), 1, file);
+    fwrite(compressed.data(), 1, compressed.size(), file);
+
+    // every block is decoded on its own
+    raw.clear();
+    block_instrs = 0;
+    last_ip = 0;
+    last_destination_memory = 0;
+    last_source_memory = 0;
+}
+
+void COMPACT_TRACE_WRITER::close()
+{
+    flush_block();
+
+    compact_trace_trailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.index_offset = ftello(file);
+    trailer.num_blocks = index.size();
+    trailer.num_instrs = num_instrs;
+    strcpy(trailer.magic, COMPACT_TRACE_MAGIC);
+
+    fwrite(index.data(), sizeof(compact_trace_index_entry), index.size(), file);
+    fwrite(&trailer, sizeof(trailer), 1, file);
+    fclose(file);
+    file = NULL;
+}
+
+COMPACT_TRACE_DECODER::COMPACT_TRACE_DECODER(uint32_t cpu, const char *trace_name, uint8_t cloudsuite)
+    : cpu(cpu)
+{
+    file = fopen(trace_name, "rb");
+    if (file == NULL) {
+        cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+
+    if ((fread(&header, sizeof(header), 1, file) != 1) || strcmp(header.magic, COMPACT_TRACE_MAGIC) || (header.version != COMPACT_TRACE_VERSION)) {
+        cerr << endl << "*** UNSUPPORTED COMPACT TRACE VERSION: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+    if ((header.num_destinations > NUM_INSTR_DESTINATIONS_SPARC) || (header.num_sources != NUM_INSTR_SOURCES)) {
+        cerr << endl << "*** UNSUPPORTED NUMBER OF OPERANDS IN COMPACT TRACE: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+    if (header.cloudsuite != cloudsuite) {
+        cerr << endl << "*** knob_cloudsuite DOES NOT MATCH THE TRACE: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+#ifndef ENABLE_ZSTD
+    if (header.codec == COMPACT_TRACE_CODEC_ZSTD) {
+        cerr << endl << "*** ChampSim was built without zstd support: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+#endif
+
+    compact_trace_trailer trailer;
+    fseeko(file, -(off_t)sizeof(trailer), SEEK_END);
+    if ((fread(&trailer, sizeof(trailer), 1, file) != 1) || strcmp(trailer.magic, COMPACT_TRACE_MAGIC)) {
+        cerr << endl << "*** COMPACT TRACE HAS NO INDEX (truncated?): " << trace_name << " ***" << endl;
+        assert(0);
+    }
+
+    index.resize(trailer.num_blocks);
+    fseeko(file, trailer.index_offset, SEEK_SET);
+    if (fread(index.data(), sizeof(compact_trace_index_entry), index.size(), file) != index.size()) {
+        cerr << endl << "*** CANNOT READ COMPACT TRACE INDEX: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+    num_instrs = trailer.num_instrs;
+
+    rewind();
+}
+
+COMPACT_TRACE_DECODER::~COMPACT_TRACE_DECODER()
+{
+    fclose(file);
+}
+
+bool COMPACT_TRACE_DECODER::load_block(uint64_t block)
+{
+    if (block >= index.size())
+        return 0;
+
+    compact_trace_block_header block_header;
+    fseeko(file, index[block].offset, SEEK_SET);
+    if (fread(&block_header, sizeof(block_header), 1, file) != 1) {
+        cerr << endl << "*** CANNOT READ COMPACT TRACE BLOCK " << block << " ***" << endl;
+        assert(0);
+    }
+
+    raw.resize(block_header.raw_size);
+    if (header.codec == COMPACT_TRACE_CODEC_NONE) {
+        if (fread(raw.data(), 1, raw.size(), file) != raw.size()) {
+            cerr << endl << "*** CANNOT READ COMPACT TRACE BLOCK " << block << " ***" << endl;
+            assert(0);
+        }
+    }
+    else {
+        compressed.resize(block_header.compressed_size);
+        if (fread(compressed.data(), 1, compressed.size(), file) != compressed.size()) {
+            cerr << endl << "*** CANNOT READ COMPACT TRACE BLOCK " << block << " ***" << endl;
+            assert(0);
+        }
+
+        if (header.codec == COMPACT_TRACE_CODEC_ZLIB) {
+            uLongf raw_size = raw.size();
+            if ((uncompress(raw.data(), &raw_size, compressed.data(), compressed.size()) != Z_OK) || (raw_size != raw.size())) {
+                cerr << endl << "*** CANNOT DECOMPRESS COMPACT TRACE BLOCK " << block << " ***" << endl;
+                assert(0);
+            }
+        }
+#ifdef ENABLE_ZSTD
+        else if (header.codec == COMPACT_TRACE_CODEC_ZSTD) {
+            size_t raw_size = ZSTD_decompress(raw.data(), raw.size(), compressed.data(), compressed.size());
+            if (ZSTD_isError(raw_size) || (raw_size != raw.size())) {
+                cerr << endl << "*** CANNOT DECOMPRESS COMPACT TRACE BLOCK " << block << " ***" << endl;
+                assert(0);
+            }
+        }
+#endif
+    }
+
+    block_instrs = block_header.num_instrs;
+    position = 0;
+    next_block = block + 1;
+    last_ip = 0;
+    last_destination_memory = 0;
+    last_source_memory = 0;
+
+    return 1;
+}
+
+bool COMPACT_TRACE_DECODER::decode_instr(ooo_model_instr *arch_instr)
+{
+    while (block_instrs == 0) {
+        if (!load_block(next_block))
+            return 0;
+    }
+
+    const uint8_t *buf = raw.data();
+    uint32_t size = raw.size(),
+             num_destinations = min<uint32_t>(header.num_destinations, NUM_INSTR_DESTINATIONS_SPARC),
+             num_sources = min<uint32_t>(header.num_sources, NUM_INSTR_SOURCES),
+             bit = 2;
+
+    uint64_t mask = get_varint(buf, size, position);
+    arch_instr->is_branch = mask & 1;
+    arch_instr->branch_taken = (mask >> 1) & 1;
+
+    last_ip += unzigzag(get_varint(buf, size, position));
+    arch_instr->ip = last_ip;
+
+    for (uint32_t i=0; i<num_destinations; i++, bit++)
+        if (mask & (1ull << bit))
+            arch_instr->destination_registers[i] = get_byte(buf, size, position);
+    for (uint32_t i=0; i<num_sources; i++, bit++)
+        if (mask & (1ull << bit))
+            arch_instr->source_registers[i] = get_byte(buf, size, position);
+
+    for (uint32_t i=0; i<num_destinations; i++, bit++) {
+        if (mask & (1ull << bit)) {
+            last_destination_memory += unzigzag(get_varint(buf, size, position));
+            arch_instr->destination_memory[i] = last_destination_memory;
+        }
+    }
+    for (uint32_t i=0; i<num_sources; i++, bit++) {
+        if (mask & (1ull << bit)) {
+            last_source_memory += unzigzag(get_varint(buf, size, position));
+            arch_instr->source_memory[i] = last_source_memory;
+        }
+    }
+
+    if (header.cloudsuite) {
+        arch_instr->asid[0] = get_byte(buf, size, position);
+        arch_instr->asid[1] = get_byte(buf, size, position);
+    }
+    else {
+        arch_instr->asid[0] = cpu;
+        arch_instr->asid[1] = cpu;
+    }
+
+    block_instrs--;
+
+    finish_instr_decode(arch_instr);
+
+    return 1;
+}
+
+void COMPACT_TRACE_DECODER::rewind()
+{
+    next_block = 0;
+    block_instrs = 0;
+}
+
+uint64_t COMPACT_TRACE_DECODER::tell()
+{
+    uint64_t block_end = (next_block < index.size()) ? index[next_block].first_instr : num_instrs;
+    return block_end - block_instrs;
+}
+
+uint64_t COMPACT_TRACE_DECODER::skip(uint64_t count)
+{
+    uint64_t position = tell(),
+             remaining = num_instrs - position;
+
+    if (count >= remaining) {
+        next_block = index.size();
+        block_instrs = 0;
+        return remaining;
+    }
+
+    seek(position + count);
+    return count;
+}
+
+void COMPACT_TRACE_DECODER::seek(uint64_t instr_count)
+{
+    // the trace repeats from the beginning once it ends
+    if (num_instrs)
+        instr_count %= num_instrs;
+
+    // last block that starts at or before instr_count
+    vector<compact_trace_index_entry>::iterator it = upper_bound(index.begin(), index.end(), instr_count,
+            [](uint64_t count, const compact_trace_index_entry &entry) { return count < entry.first_instr; });
+    if (it == index.begin()) {
+        rewind();
+        return;
+    }
+    --it;
+
+    load_block(it - index.begin());
+
+    ooo_model_instr skipped;
+    for (uint64_t i=it->first_instr; i<instr_count; i++)
+        decode_instr(&skipped);
+}
@@ -137,6 +137,47 @@ void MEMORY_CONTROLLER::operate()
     }
 }
 
+uint64_t MEMORY_CONTROLLER::cycles_to_next_event()
+{
+    uint64_t cycles = UINT64_MAX;
+
+    for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
+
+        // read/write mode switches depend only on the queue occupancies
+        if ((write_mode[i] == 0) && ((WQ[i].occupancy >= DRAM_WRITE_HIGH_WM) || ((RQ[i].occupancy == 0) && (WQ[i].occupancy > 0))))
+            return 1;
+        if (write_mode[i] && ((WQ[i].occupancy == 0) || (RQ[i].occupancy && (WQ[i].occupancy < DRAM_WRITE_LOW_WM))))
+            return 1;
+
+        PACKET_QUEUE *queue = write_mode[i] ? &WQ[i] : &RQ[i];
+
+        // the scheduler does nothing while every waiting request targets a busy bank,
+        // and banks are only released by process()
+        if (queue->next_schedule_index < queue->SIZE) {
+            for (uint32_t j=0; j<queue->SIZE; j++) {
+                uint64_t address = queue->entry[j].address;
+                if ((address == 0) || queue->entry[j].scheduled)
+                    continue;
+
+                if (bank_request[dram_get_channel(address)][dram_get_rank(address)][dram_get_bank(address)].working == 0) {
+                    uint32_t schedule_cpu = queue->entry[queue->next_schedule_index].cpu;
+                    cycles = min(cycles, cycles_until(queue->next_schedule_cycle, current_core_cycle[schedule_cpu]));
+                    break;
+                }
+            }
+        }
+
+        // a scheduled request is processed once both its turn has come and its bank has paid the access latency
+        if (queue->next_process_index < queue->SIZE) {
+            PACKET *packet = &queue->entry[queue->next_process_index];
+            BANK_REQUEST *bank = &bank_request[dram_get_channel(packet->address)][dram_get_rank(packet->address)][dram_get_bank(packet->address)];
+            cycles = min(cycles, cycles_until(max(queue->next_process_cycle, bank->cycle_available), current_core_cycle[packet->cpu]));
+        }
+    }
+
+    return cycles;
+}
+
 void MEMORY_CONTROLLER::schedule(PACKET_QUEUE *queue)
 {
     uint64_t read_addr;
@@ -722,3 +763,16 @@ void MEMORY_CONTROLLER::increment_WQ_FULL(uint64_t address)
     uint32_t channel = dram_get_channel(address);
     WQ[channel].FULL++;
 }
+
+void MEMORY_CONTROLLER::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+    checkpoint.section("DRAM " + to_string(DRAM_CHANNELS) + "x" + to_string(DRAM_RANKS) + "x" + to_string(DRAM_BANKS));
+
+    // only the open rows, requests in flight are not part of the checkpoint
+    for (uint32_t i=0; i<DRAM_CHANNELS; i++) {
+        for (uint32_t j=0; j<DRAM_RANKS; j++) {
+            for (uint32_t k=0; k<DRAM_BANKS; k++)
+                checkpoint.value(bank_request[i][j][k].open_row);
+        }
+    }
+}
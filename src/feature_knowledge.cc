@@ -1,7 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
 #include <assert.h>
 #include "feature_knowledge.h"
 #include "feature_knowledge_helper.h"
+#include "checkpoint.h"
 
 #if 0
 #	define LOCKED(...) {fflush(stdout); __VA_ARGS__; fflush(stdout);}
@@ -22,6 +25,8 @@ namespace knob
 	extern uint32_t 		le_featurewise_trace_interval;
 	extern uint32_t 		le_featurewise_trace_record_count;
 	extern std::string 	le_featurewise_trace_file_name;
+	extern std::string 	le_qtable_storage;
+	extern uint32_t 	le_qtable_frac_bits;
 }
 
 const char* MapFeatureTypeString[] = {"PC", "Offset", "Delta", "Address", "PC_Offset", "PC_Address", "PC_Page", "PC_Path", "Delta_Path", "Offset_Path", "PC_Delta", "PC_Offset_Delta", "Page", "PC_Path_Offset", "PC_Path_Offset_Path", "PC_Path_Delta", "PC_Path_Delta_Path", "PC_Path_Offset_Path_Delta_Path", "Offset_Path_PC", "Delta_Path_PC"};
@@ -38,20 +43,6 @@ FeatureKnowledge::FeatureKnowledge(FeatureType feature_type, float alpha, float
 	assert(m_num_tilings <= FK_MAX_TILINGS);
 	assert(m_num_tilings == 1 || m_enable_tiling_offset); /* enforce the use of tiling offsets in case of multiple tilings */
 
-	/* create Q-table */
-	m_qtable = (float***)calloc(m_num_tilings, sizeof(float**));
-	assert(m_qtable);
-	for(uint32_t tiling = 0; tiling < m_num_tilings; ++tiling)
-	{
-		m_qtable[tiling] = (float**)calloc(m_num_tiles, sizeof(float*));
-		assert(m_qtable[tiling]);
-		for(uint32_t tile = 0; tile < m_num_tiles; ++tile)
-		{
-			m_qtable[tiling][tile] = (float*)calloc(m_actions, sizeof(float));
-			assert(m_qtable[tiling][tile]);
-		}
-	}
-
 	/* init Q-table */
 	if(zero_init)
 	{
@@ -61,16 +52,8 @@ FeatureKnowledge::FeatureKnowledge(FeatureType feature_type, float alpha, float
 	{
 		m_init_value = (float)1ul/(1-gamma);
 	}
-	for(uint32_t tiling = 0; tiling < m_num_tilings; ++tiling)
-	{
-		for(uint32_t tile = 0; tile < m_num_tiles; ++tile)
-		{
-			for(uint32_t action = 0; action < m_actions; ++action)
-			{
-				m_qtable[tiling][tile][action] = m_init_value;
-			}
-		}
-	}
+	m_qtable = new QTable(m_num_tilings * m_num_tiles, m_actions, m_init_value, parseQTableStorage(knob::le_qtable_storage), knob::le_qtable_frac_bits);
+	assert(m_qtable->get_row_size() <= FK_MAX_ROW_SIZE);
 
 	min_weight = 1000000;
 	max_weight = 0;
@@ -88,62 +71,42 @@ FeatureKnowledge::FeatureKnowledge(FeatureType feature_type, float alpha, float
 
 FeatureKnowledge::~FeatureKnowledge()
 {
-
+	delete m_qtable;
 }
 
-float FeatureKnowledge::getQ(uint32_t tiling, uint32_t tile_index, uint32_t action)
+void FeatureKnowledge::retrieveQ(State *state, float *q_values)
 {
-	assert(tiling < m_num_tilings);
-	assert(tile_index < m_num_tiles);
-	assert(action < m_actions);
-	return m_qtable[tiling][tile_index][action];
-}
+	uint32_t rows[FK_MAX_TILINGS];
+	get_tile_rows(state, rows);
 
-void FeatureKnowledge::setQ(uint32_t tiling, uint32_t tile_index, uint32_t action, float value)
-{
-	assert(tiling < m_num_tilings);
-	assert(tile_index < m_num_tiles);
-	assert(action < m_actions);
-	m_qtable[tiling][tile_index][action] = value;
-}
-
-float FeatureKnowledge::retrieveQ(State *state, uint32_t action)
-{
-	uint32_t tile_index = 0;
-	float q_value = 0.0;
-
-	for(uint32_t tiling = 0; tiling < m_num_tilings; ++tiling)
-	{
-		tile_index = get_tile_index(tiling, state);
-		q_value += getQ(tiling, tile_index, action);
-	}
-
-	return m_weight * q_value;
+	/* every action is summed over the tilings in tiling order, then weighted */
+	m_qtable->sum_rows(rows, m_num_tilings, q_values, m_weight);
 }
 
 void FeatureKnowledge::updateQ(State *state1, uint32_t action1, int32_t reward, State *state2, uint32_t action2)
 {
-	uint32_t tile_index1 = 0, tile_index2 = 0;
-	float Qsa1, Qsa2, Qsa1_old;
-
-	float QSa1_old_overall = retrieveQ(state1, action1);
-	float QSa2_old_overall = retrieveQ(state2, action2);
+	/* index every tiling once per state */
+	uint32_t rows1[FK_MAX_TILINGS], rows2[FK_MAX_TILINGS];
+	get_tile_rows(state1, rows1);
+	get_tile_rows(state2, rows2);
 
+	float Qsa1, Qsa2, Qsa1_old;
+	float QSa1_old_overall = 0.0, QSa2_old_overall = 0.0, QSa1_new_overall = 0.0; /* for logging */
 	for(uint32_t tiling = 0; tiling < m_num_tilings; ++tiling)
 	{
-		tile_index1 = get_tile_index(tiling, state1);
-		tile_index2 = get_tile_index(tiling, state2);
-		Qsa1 = getQ(tiling, tile_index1, action1);
-		Qsa2 = getQ(tiling, tile_index2, action2);
+		Qsa1 = m_qtable->get(rows1[tiling], action1);
+		Qsa2 = m_qtable->get(rows2[tiling], action2);
 		Qsa1_old = Qsa1;
 		/* SARSA */
 		Qsa1 = Qsa1 + m_alpha * ((float)reward + m_gamma * Qsa2 - Qsa1);
-		setQ(tiling, tile_index1, action1, Qsa1);
+		m_qtable->set(rows1[tiling], action1, Qsa1);
 		MYLOG("<tiling %u> Q(%s,%u) = %0.2f, R = %d, Q(%s,%u) = %0.2f, Q(%s,%u) = %0.2f", tiling, state1->to_string().c_str(), action1, Qsa1_old, reward, state2->to_string().c_str(), action2, Qsa2, state1->to_string().c_str(), action1, Qsa1);
+		QSa1_old_overall += Qsa1_old;
+		QSa2_old_overall += Qsa2;
+		QSa1_new_overall += Qsa1;
 	}
 
-	float QSa1_new_overall = retrieveQ(state1, action1);
-	MYLOG("<feature %s> Q(%s,%u) = %0.2f, R = %d, Q(%s,%u) = %0.2f, Q(%s,%u) = %0.2f", getFeatureString(m_feature_type).c_str(), state1->to_string().c_str(), action1, QSa1_old_overall, reward, state2->to_string().c_str(), action2, QSa2_old_overall, state1->to_string().c_str(), action1, QSa1_new_overall);
+	MYLOG("<feature %s> Q(%s,%u) = %0.2f, R = %d, Q(%s,%u) = %0.2f, Q(%s,%u) = %0.2f", getFeatureString(m_feature_type).c_str(), state1->to_string().c_str(), action1, m_weight * QSa1_old_overall, reward, state2->to_string().c_str(), action2, m_weight * QSa2_old_overall, state1->to_string().c_str(), action1, m_weight * QSa1_new_overall);
 
 	/* tracing Q-values */
 	if(knob::le_featurewise_enable_trace
@@ -195,20 +158,37 @@ uint32_t FeatureKnowledge::get_tile_index(uint32_t tiling, State *state)
 	}
 }
 
+void FeatureKnowledge::get_tile_rows(State *state, uint32_t *rows)
+{
+	for(uint32_t tiling = 0; tiling < m_num_tilings; ++tiling)
+	{
+		uint32_t tile_index = get_tile_index(tiling, state);
+		assert(tile_index < m_num_tiles);
+		rows[tiling] = tiling * m_num_tiles + tile_index;
+	}
+}
+
 uint32_t FeatureKnowledge::getMaxAction(State *state)
+{
+	float q_values[FK_MAX_ROW_SIZE];
+	retrieveQ(state, q_values);
+	return getMaxAction(q_values);
+}
+
+uint32_t FeatureKnowledge::getMaxAction(const float *q_values)
 {
 	float max_q_value = 0.0, q_value = 0.0;
 	uint32_t selected_action = 0, init_index = 0;
 
 	if(!knob::le_featurewise_enable_action_fallback)
 	{
-		max_q_value = retrieveQ(state, 0);
+		max_q_value = q_values[0];
 		init_index = 1;
 	}
 
 	for(uint32_t action = init_index; action < m_actions; ++action)
 	{
-		q_value = retrieveQ(state, action);
+		q_value = q_values[action];
 		if(q_value > max_q_value)
 		{
 			max_q_value = q_value;
@@ -218,6 +198,18 @@ uint32_t FeatureKnowledge::getMaxAction(State *state)
 	return selected_action;
 }
 
+void FeatureKnowledge::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+	checkpoint.section("feature " + getFeatureString(m_feature_type) + " actions " + std::to_string(m_actions) + " tilings " + std::to_string(m_num_tilings)
+		+ " tiles " + std::to_string(m_num_tiles) + " hash " + std::to_string(m_hash_type) + " tiling_offset " + std::to_string(m_enable_tiling_offset));
+	checkpoint.value(m_alpha);
+	checkpoint.value(m_gamma);
+	checkpoint.value(m_weight);
+	checkpoint.value(min_weight);
+	checkpoint.value(max_weight);
+	m_qtable->checkpoint(checkpoint);
+}
+
 string FeatureKnowledge::get_feature_string(State *state)
 {
 	uint64_t pc = state->pc;
@@ -247,11 +239,13 @@ string FeatureKnowledge::get_feature_string(State *state)
 
 void FeatureKnowledge::dump_feature_trace(State *state)
 {
+	float q_values[FK_MAX_ROW_SIZE];
+	retrieveQ(state, q_values);
 	trace_timestamp++;
 	fprintf(trace, "%lu,", trace_timestamp);
 	for(uint32_t action = 0; action < m_actions; ++action)
 	{
-		fprintf(trace, "%.2f,", retrieveQ(state, action));
+		fprintf(trace, "%.2f,", q_values[action]);
 	}
 	fprintf(trace, "\n");
 	fflush(trace);
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <algorithm>
+#include "heavy_hitters.h"
+
+#define HH_EMPTY UINT32_MAX
+
+HeavyHitters::HeavyHitters(uint32_t capacity, uint32_t columns)
+	: m_capacity(capacity), m_columns(columns)
+{
+	assert(m_capacity && m_columns);
+	m_keys.resize(m_capacity, 0);
+	m_counts.resize(m_capacity, 0);
+	m_errors.resize(m_capacity, 0);
+	m_histograms.resize((uint64_t)m_capacity * m_columns, 0);
+	m_heap.resize(m_capacity, 0);
+	m_heap_pos.resize(m_capacity, 0);
+
+	/* at most half full, so probes stay short */
+	uint32_t index_size = 1;
+	while(index_size < 2 * m_capacity) index_size <<= 1;
+	m_index.resize(index_size, HH_EMPTY);
+	m_index_mask = index_size - 1;
+
+	clear();
+}
+
+void HeavyHitters::clear()
+{
+	m_size = 0;
+	m_updates = 0;
+	m_replacements = 0;
+	std::fill(m_index.begin(), m_index.end(), HH_EMPTY);
+}
+
+uint32_t HeavyHitters::find(uint64_t key) const
+{
+	for(uint32_t pos = hash(key); m_index[pos] != HH_EMPTY; pos = (pos + 1) & m_index_mask)
+	{
+		if(m_keys[m_index[pos]] == key)
+		{
+			return m_index[pos];
+		}
+	}
+	return HH_EMPTY;
+}
+
+void HeavyHitters::index_insert(uint64_t key, uint32_t slot)
+{
+	uint32_t pos = hash(key);
+	while(m_index[pos] != HH_EMPTY) pos = (pos + 1) & m_index_mask;
+	m_index[pos] = slot;
+}
+
+/* backward shift deletion, so the index needs no tombstones */
+void HeavyHitters::index_erase(uint64_t key)
+{
+	uint32_t pos = hash(key);
+	while(m_keys[m_index[pos]] != key)
+	{
+		pos = (pos + 1) & m_index_mask;
+		assert(m_index[pos] != HH_EMPTY);
+	}
+
+	uint32_t next = (pos + 1) & m_index_mask;
+	while(m_index[next] != HH_EMPTY)
+	{
+		uint32_t home = hash(m_keys[m_index[next]]);
+		/* move the entry back if its home is not in (pos, next] */
+		if(((next - home) & m_index_mask) >= ((next - pos) & m_index_mask))
+		{
+			m_index[pos] = m_index[next];
+			pos = next;
+		}
+		next = (next + 1) & m_index_mask;
+	}
+	m_index[pos] = HH_EMPTY;
+}
+
+void HeavyHitters::heap_swap(uint32_t pos1, uint32_t pos2)
+{
+	std::swap(m_heap[pos1], m_heap[pos2]);
+	m_heap_pos[m_heap[pos1]] = pos1;
+	m_heap_pos[m_heap[pos2]] = pos2;
+}
+
+/* counts only grow, so a slot only ever moves down the heap */
+void HeavyHitters::sift_down(uint32_t pos)
+{
+	while(true)
+	{
+		uint32_t smallest = pos;
+		uint32_t left = 2 * pos + 1, right = 2 * pos + 2;
+		if(left < m_size && m_counts[m_heap[left]] < m_counts[m_heap[smallest]]) smallest = left;
+		if(right < m_size && m_counts[m_heap[right]] < m_counts[m_heap[smallest]]) smallest = right;
+		if(smallest == pos) break;
+		heap_swap(pos, smallest);
+		pos = smallest;
+	}
+}
+
+void HeavyHitters::update(uint64_t key, uint32_t column)
+{
+	assert(column < m_columns);
+	m_updates++;
+
+	uint32_t slot = find(key);
+	if(slot == HH_EMPTY)
+	{
+		if(m_size < m_capacity)
+		{
+			/* a new slot with the smallest possible count goes to the root */
+			slot = m_size++;
+			m_counts[slot] = 0;
+			m_errors[slot] = 0;
+			uint32_t pos = m_size - 1;
+			m_heap[pos] = slot;
+			m_heap_pos[slot] = pos;
+			while(pos > 0)
+			{
+				heap_swap(pos, (pos - 1) / 2);
+				pos = (pos - 1) / 2;
+			}
+		}
+		else
+		{
+			/* take over the least frequent key */
+			slot = m_heap[0];
+			index_erase(m_keys[slot]);
+			m_errors[slot] = m_counts[slot];
+			m_replacements++;
+		}
+		m_keys[slot] = key;
+		index_insert(key, slot);
+		std::fill(m_histograms.begin() + (uint64_t)slot * m_columns, m_histograms.begin() + (uint64_t)(slot + 1) * m_columns, 0);
+	}
+
+	m_counts[slot]++;
+	m_histograms[(uint64_t)slot * m_columns + column]++;
+	sift_down(m_heap_pos[slot]);
+}
+
+std::vector<uint32_t> HeavyHitters::sorted() const
+{
+	std::vector<uint32_t> slots(m_size);
+	for(uint32_t slot = 0; slot < m_size; ++slot)
+	{
+		slots[slot] = slot;
+	}
+	std::sort(slots.begin(), slots.end(), [this](uint32_t a, uint32_t b)
+	{
+		return m_counts[a] != m_counts[b] ? m_counts[a] > m_counts[b] : m_keys[a] < m_keys[b];
+	});
+	return slots;
+}
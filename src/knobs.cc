@@ -3,6 +3,7 @@
 #include <string.h>
 #include <math.h>
 #include "knobs.h"
+#include "cache.h"
 #include "ini.h"
 using namespace std;
 
@@ -12,6 +13,80 @@ namespace knob
 {
 	uint64_t warmup_instructions = 1000000;
 	uint64_t simulation_instructions = 1000000;
+	uint64_t skip_instructions = 0;
+	bool     functional_warming = false;
+	string   save_checkpoint;
+	string   load_checkpoint;
+	bool     cycle_skipping = true;
+	bool     parallel_simulation = false;
+	uint32_t parallel_quantum = 1;
+	string   batch_jobs;
+	uint32_t batch_threads = 0;
+	bool     batch_trace_cache = true;
+	uint64_t batch_cache_instructions = 0;
+	bool     approximate_footprint = false;
+	uint32_t fetch_width = 6;
+	uint32_t decode_width = 6;
+	uint32_t exec_width = 4;
+	uint32_t lq_width = 2;
+	uint32_t sq_width = 2;
+	uint32_t retire_width = 4;
+	uint32_t scheduler_size = 128;
+	uint32_t branch_mispredict_penalty = 20;
+	uint32_t scheduling_latency = 6;
+	uint32_t exec_latency = 1;
+	uint32_t rob_size = 256;
+	uint32_t lq_size = 72;
+	uint32_t sq_size = 56;
+	uint32_t itlb_set = ITLB_SET;
+	uint32_t itlb_way = ITLB_WAY;
+	uint32_t itlb_rq_size = ITLB_RQ_SIZE;
+	uint32_t itlb_wq_size = ITLB_WQ_SIZE;
+	uint32_t itlb_pq_size = ITLB_PQ_SIZE;
+	uint32_t itlb_mshr_size = ITLB_MSHR_SIZE;
+	uint32_t itlb_latency = ITLB_LATENCY;
+	uint32_t dtlb_set = DTLB_SET;
+	uint32_t dtlb_way = DTLB_WAY;
+	uint32_t dtlb_rq_size = DTLB_RQ_SIZE;
+	uint32_t dtlb_wq_size = DTLB_WQ_SIZE;
+	uint32_t dtlb_pq_size = DTLB_PQ_SIZE;
+	uint32_t dtlb_mshr_size = DTLB_MSHR_SIZE;
+	uint32_t dtlb_latency = DTLB_LATENCY;
+	uint32_t stlb_set = STLB_SET;
+	uint32_t stlb_way = STLB_WAY;
+	uint32_t stlb_rq_size = STLB_RQ_SIZE;
+	uint32_t stlb_wq_size = STLB_WQ_SIZE;
+	uint32_t stlb_pq_size = STLB_PQ_SIZE;
+	uint32_t stlb_mshr_size = STLB_MSHR_SIZE;
+	uint32_t stlb_latency = STLB_LATENCY;
+	uint32_t l1i_set = L1I_SET;
+	uint32_t l1i_way = L1I_WAY;
+	uint32_t l1i_rq_size = L1I_RQ_SIZE;
+	uint32_t l1i_wq_size = L1I_WQ_SIZE;
+	uint32_t l1i_pq_size = L1I_PQ_SIZE;
+	uint32_t l1i_mshr_size = L1I_MSHR_SIZE;
+	uint32_t l1i_latency = L1I_LATENCY;
+	uint32_t l1d_set = L1D_SET;
+	uint32_t l1d_way = L1D_WAY;
+	uint32_t l1d_rq_size = L1D_RQ_SIZE;
+	uint32_t l1d_wq_size = L1D_WQ_SIZE;
+	uint32_t l1d_pq_size = L1D_PQ_SIZE;
+	uint32_t l1d_mshr_size = L1D_MSHR_SIZE;
+	uint32_t l1d_latency = L1D_LATENCY;
+	uint32_t l2c_set = L2C_SET;
+	uint32_t l2c_way = L2C_WAY;
+	uint32_t l2c_rq_size = L2C_RQ_SIZE;
+	uint32_t l2c_wq_size = L2C_WQ_SIZE;
+	uint32_t l2c_pq_size = L2C_PQ_SIZE;
+	uint32_t l2c_mshr_size = L2C_MSHR_SIZE;
+	uint32_t l2c_latency = L2C_LATENCY;
+	uint32_t llc_set = LLC_SET;
+	uint32_t llc_way = LLC_WAY;
+	uint32_t llc_rq_size = LLC_RQ_SIZE;
+	uint32_t llc_wq_size = LLC_WQ_SIZE;
+	uint32_t llc_pq_size = LLC_PQ_SIZE;
+	uint32_t llc_mshr_size = LLC_MSHR_SIZE;
+	uint32_t llc_latency = LLC_LATENCY;
 	bool  	 knob_cloudsuite = false;
 	bool     knob_low_bandwidth = false;
 	vector<string> 	 l2c_prefetcher_types;
@@ -203,6 +278,8 @@ namespace knob
 	uint32_t scooby_print_access_debug_pc_count;
 	bool     scooby_print_trace;
 	bool     scooby_enable_state_action_stats;
+	uint32_t scooby_state_action_stats_top_k = 1024;
+	uint32_t scooby_state_action_stats_sample_rate = 1;
 	bool     scooby_enable_reward_tracker_hit;
 	int32_t  scooby_reward_tracker_hit;
 	bool     scooby_enable_shaggy;
@@ -216,6 +293,10 @@ namespace knob
 	vector<float> scooby_max_to_avg_q_thresholds;
 	vector<int32_t> scooby_dyn_degrees;
 	uint64_t scooby_early_exploration_window;
+	string   scooby_load_qtable;
+	string   scooby_save_qtable;
+	bool     scooby_share_brain = false;
+	bool     scooby_freeze_brain = false;
 	bool     scooby_enable_het_reward;
 	int32_t  scooby_reward_fa_correct_timely;
 	int32_t  scooby_reward_fa_correct_untimely;
@@ -261,6 +342,8 @@ namespace knob
 	uint32_t le_action_trace_interval;
 	std::string le_action_trace_name;
 	bool     le_enable_action_plot;
+	string   le_qtable_storage = "float";
+	uint32_t le_qtable_frac_bits = 8;
 
 	/* CMAC Engine */
 	uint32_t scooby_cmac_num_planes;
@@ -415,6 +498,302 @@ int parse_knobs(void* user, const char* section, const char* name, const char* v
     {
 		knob::simulation_instructions = atol(value);
     }
+    else if (MATCH("", "skip_instructions"))
+    {
+		knob::skip_instructions = atol(value);
+    }
+    else if (MATCH("", "functional_warming"))
+    {
+		knob::functional_warming = !strcmp(value, "true") ? true : false;
+    }
+    else if (MATCH("", "save_checkpoint"))
+    {
+		knob::save_checkpoint = string(value);
+    }
+    else if (MATCH("", "load_checkpoint"))
+    {
+		knob::load_checkpoint = string(value);
+    }
+    else if (MATCH("", "cycle_skipping"))
+    {
+		knob::cycle_skipping = !strcmp(value, "true") ? true : false;
+    }
+    else if (MATCH("", "parallel_simulation"))
+    {
+		knob::parallel_simulation = !strcmp(value, "true") ? true : false;
+    }
+    else if (MATCH("", "parallel_quantum"))
+    {
+		knob::parallel_quantum = atoi(value);
+    }
+    else if (MATCH("", "batch_jobs"))
+    {
+		knob::batch_jobs = string(value);
+    }
+    else if (MATCH("", "batch_threads"))
+    {
+		knob::batch_threads = atoi(value);
+    }
+    else if (MATCH("", "batch_trace_cache"))
+    {
+		knob::batch_trace_cache = !strcmp(value, "true") ? true : false;
+    }
+    else if (MATCH("", "batch_cache_instructions"))
+    {
+		knob::batch_cache_instructions = atol(value);
+    }
+    else if (MATCH("", "approximate_footprint"))
+    {
+		knob::approximate_footprint = !strcmp(value, "true") ? true : false;
+    }
+    else if (MATCH("", "fetch_width"))
+    {
+		knob::fetch_width = atoi(value);
+    }
+    else if (MATCH("", "decode_width"))
+    {
+		knob::decode_width = atoi(value);
+    }
+    else if (MATCH("", "exec_width"))
+    {
+		knob::exec_width = atoi(value);
+    }
+    else if (MATCH("", "lq_width"))
+    {
+		knob::lq_width = atoi(value);
+    }
+    else if (MATCH("", "sq_width"))
+    {
+		knob::sq_width = atoi(value);
+    }
+    else if (MATCH("", "retire_width"))
+    {
+		knob::retire_width = atoi(value);
+    }
+    else if (MATCH("", "scheduler_size"))
+    {
+		knob::scheduler_size = atoi(value);
+    }
+    else if (MATCH("", "branch_mispredict_penalty"))
+    {
+		knob::branch_mispredict_penalty = atoi(value);
+    }
+    else if (MATCH("", "scheduling_latency"))
+    {
+		knob::scheduling_latency = atoi(value);
+    }
+    else if (MATCH("", "exec_latency"))
+    {
+		knob::exec_latency = atoi(value);
+    }
+    else if (MATCH("", "rob_size"))
+    {
+		knob::rob_size = atoi(value);
+    }
+    else if (MATCH("", "lq_size"))
+    {
+		knob::lq_size = atoi(value);
+    }
+    else if (MATCH("", "sq_size"))
+    {
+		knob::sq_size = atoi(value);
+    }
+    else if (MATCH("", "itlb_set"))
+    {
+		knob::itlb_set = atoi(value);
+    }
+    else if (MATCH("", "itlb_way"))
+    {
+		knob::itlb_way = atoi(value);
+    }
+    else if (MATCH("", "itlb_rq_size"))
+    {
+		knob::itlb_rq_size = atoi(value);
+    }
+    else if (MATCH("", "itlb_wq_size"))
+    {
+		knob::itlb_wq_size = atoi(value);
+    }
+    else if (MATCH("", "itlb_pq_size"))
+    {
+		knob::itlb_pq_size = atoi(value);
+    }
+    else if (MATCH("", "itlb_mshr_size"))
+    {
+		knob::itlb_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "itlb_latency"))
+    {
+		knob::itlb_latency = atoi(value);
+    }
+    else if (MATCH("", "dtlb_set"))
+    {
+		knob::dtlb_set = atoi(value);
+    }
+    else if (MATCH("", "dtlb_way"))
+    {
+		knob::dtlb_way = atoi(value);
+    }
+    else if (MATCH("", "dtlb_rq_size"))
+    {
+		knob::dtlb_rq_size = atoi(value);
+    }
+    else if (MATCH("", "dtlb_wq_size"))
+    {
+		knob::dtlb_wq_size = atoi(value);
+    }
+    else if (MATCH("", "dtlb_pq_size"))
+    {
+		knob::dtlb_pq_size = atoi(value);
+    }
+    else if (MATCH("", "dtlb_mshr_size"))
+    {
+		knob::dtlb_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "dtlb_latency"))
+    {
+		knob::dtlb_latency = atoi(value);
+    }
+    else if (MATCH("", "stlb_set"))
+    {
+		knob::stlb_set = atoi(value);
+    }
+    else if (MATCH("", "stlb_way"))
+    {
+		knob::stlb_way = atoi(value);
+    }
+    else if (MATCH("", "stlb_rq_size"))
+    {
+		knob::stlb_rq_size = atoi(value);
+    }
+    else if (MATCH("", "stlb_wq_size"))
+    {
+		knob::stlb_wq_size = atoi(value);
+    }
+    else if (MATCH("", "stlb_pq_size"))
+    {
+		knob::stlb_pq_size = atoi(value);
+    }
+    else if (MATCH("", "stlb_mshr_size"))
+    {
+		knob::stlb_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "stlb_latency"))
+    {
+		knob::stlb_latency = atoi(value);
+    }
+    else if (MATCH("", "l1i_set"))
+    {
+		knob::l1i_set = atoi(value);
+    }
+    else if (MATCH("", "l1i_way"))
+    {
+		knob::l1i_way = atoi(value);
+    }
+    else if (MATCH("", "l1i_rq_size"))
+    {
+		knob::l1i_rq_size = atoi(value);
+    }
+    else if (MATCH("", "l1i_wq_size"))
+    {
+		knob::l1i_wq_size = atoi(value);
+    }
+    else if (MATCH("", "l1i_pq_size"))
+    {
+		knob::l1i_pq_size = atoi(value);
+    }
+    else if (MATCH("", "l1i_mshr_size"))
+    {
+		knob::l1i_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "l1i_latency"))
+    {
+		knob::l1i_latency = atoi(value);
+    }
+    else if (MATCH("", "l1d_set"))
+    {
+		knob::l1d_set = atoi(value);
+    }
+    else if (MATCH("", "l1d_way"))
+    {
+		knob::l1d_way = atoi(value);
+    }
+    else if (MATCH("", "l1d_rq_size"))
+    {
+		knob::l1d_rq_size = atoi(value);
+    }
+    else if (MATCH("", "l1d_wq_size"))
+    {
+		knob::l1d_wq_size = atoi(value);
+    }
+    else if (MATCH("", "l1d_pq_size"))
+    {
+		knob::l1d_pq_size = atoi(value);
+    }
+    else if (MATCH("", "l1d_mshr_size"))
+    {
+		knob::l1d_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "l1d_latency"))
+    {
+		knob::l1d_latency = atoi(value);
+    }
+    else if (MATCH("", "l2c_set"))
+    {
+		knob::l2c_set = atoi(value);
+    }
+    else if (MATCH("", "l2c_way"))
+    {
+		knob::l2c_way = atoi(value);
+    }
+    else if (MATCH("", "l2c_rq_size"))
+    {
+		knob::l2c_rq_size = atoi(value);
+    }
+    else if (MATCH("", "l2c_wq_size"))
+    {
+		knob::l2c_wq_size = atoi(value);
+    }
+    else if (MATCH("", "l2c_pq_size"))
+    {
+		knob::l2c_pq_size = atoi(value);
+    }
+    else if (MATCH("", "l2c_mshr_size"))
+    {
+		knob::l2c_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "l2c_latency"))
+    {
+		knob::l2c_latency = atoi(value);
+    }
+    else if (MATCH("", "llc_set"))
+    {
+		knob::llc_set = atoi(value);
+    }
+    else if (MATCH("", "llc_way"))
+    {
+		knob::llc_way = atoi(value);
+    }
+    else if (MATCH("", "llc_rq_size"))
+    {
+		knob::llc_rq_size = atoi(value);
+    }
+    else if (MATCH("", "llc_wq_size"))
+    {
+		knob::llc_wq_size = atoi(value);
+    }
+    else if (MATCH("", "llc_pq_size"))
+    {
+		knob::llc_pq_size = atoi(value);
+    }
+    else if (MATCH("", "llc_mshr_size"))
+    {
+		knob::llc_mshr_size = atoi(value);
+    }
+    else if (MATCH("", "llc_latency"))
+    {
+		knob::llc_latency = atoi(value);
+    }
     else if (MATCH("", "knob_cloudsuite"))
     {
 		knob::knob_cloudsuite = !strcmp(value, "true") ? true : false;
@@ -1070,6 +1449,14 @@ int parse_knobs(void* user, const char* section, const char* name, const char* v
 	{
 		knob::scooby_enable_state_action_stats = !strcmp(value, "true") ? true : false;
 	}
+	else if (MATCH("", "scooby_state_action_stats_top_k"))
+	{
+		knob::scooby_state_action_stats_top_k = atoi(value);
+	}
+	else if (MATCH("", "scooby_state_action_stats_sample_rate"))
+	{
+		knob::scooby_state_action_stats_sample_rate = atoi(value);
+	}
 	else if (MATCH("", "scooby_enable_reward_tracker_hit"))
 	{
 		knob::scooby_enable_reward_tracker_hit = !strcmp(value, "true") ? true : false;
@@ -1122,6 +1509,22 @@ int parse_knobs(void* user, const char* section, const char* name, const char* v
 	{
 		knob::scooby_early_exploration_window = atoi(value);
 	}
+	else if (MATCH("", "scooby_load_qtable"))
+	{
+		knob::scooby_load_qtable = string(value);
+	}
+	else if (MATCH("", "scooby_save_qtable"))
+	{
+		knob::scooby_save_qtable = string(value);
+	}
+	else if (MATCH("", "scooby_share_brain"))
+	{
+		knob::scooby_share_brain = !strcmp(value, "true") ? true : false;
+	}
+	else if (MATCH("", "scooby_freeze_brain"))
+	{
+		knob::scooby_freeze_brain = !strcmp(value, "true") ? true : false;
+	}
 	else if (MATCH("", "scooby_enable_het_reward"))
 	{
 		knob::scooby_enable_het_reward = !strcmp(value, "true") ? true : false;
@@ -1296,6 +1699,14 @@ int parse_knobs(void* user, const char* section, const char* name, const char* v
 	{
 		knob::le_enable_action_plot = !strcmp(value, "true") ? true : false;
 	}
+	else if (MATCH("", "le_qtable_storage"))
+	{
+		knob::le_qtable_storage = string(value);
+	}
+	else if (MATCH("", "le_qtable_frac_bits"))
+	{
+		knob::le_qtable_frac_bits = atoi(value);
+	}
 
 	/* CMAC Engine */
 	else if (MATCH("", "scooby_cmac_num_planes"))
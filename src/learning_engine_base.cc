@@ -1,5 +1,6 @@
 #include <assert.h>
 #include "learning_engine_base.h"
+#include "checkpoint.h"
 
 const char* PolicyString[] = {"EGreddy"};
 const char* MapPolicyString(Policy policy)
@@ -46,4 +47,11 @@ Policy LearningEngineBase::parsePolicy(std::string str)
 	printf("unsupported policy %s\n", str.c_str());
 	assert(false);
 	return Policy::InvalidPolicy;
-}
\ No newline at end of file
+}
+void LearningEngineBase::checkpoint_hyperparameters(CHECKPOINT_FILE &checkpoint)
+{
+	checkpoint.section("hyperparameters");
+	checkpoint.value(m_alpha);
+	checkpoint.value(m_gamma);
+	checkpoint.value(m_epsilon);
+}
@@ -7,6 +7,7 @@
 #include "scooby.h"
 #include "velma.h"
 #include "util.h"
+#include "checkpoint.h"
 
 #if 0
 #	define LOCKED(...) {fflush(stdout); __VA_ARGS__; fflush(stdout);}
@@ -31,19 +32,13 @@ namespace knob
 	extern uint32_t le_action_trace_interval;
 	extern std::string le_action_trace_name;
 	extern bool     le_enable_action_plot;
+	extern std::string le_qtable_storage;
+	extern uint32_t le_qtable_frac_bits;
 }
 
 LearningEngineBasic::LearningEngineBasic(Prefetcher *parent, float alpha, float gamma, float epsilon, uint32_t actions, uint32_t states, uint64_t seed, std::string policy, std::string type, bool zero_init, uint64_t early_exploration_window)
 	: LearningEngineBase(parent, alpha, gamma, epsilon, actions, states, seed, policy, type)
 {
-	qtable = (float**)calloc(m_states, sizeof(float*));
-	assert(qtable);
-	for(uint32_t index = 0; index < m_states; ++index)
-	{
-		qtable[index] = (float*)calloc(m_actions, sizeof(float));
-		assert(qtable);
-	}
-
 	/* init Q-table */
 	if(zero_init)
 	{
@@ -53,13 +48,8 @@ LearningEngineBasic::LearningEngineBasic(Prefetcher *parent, float alpha, float
 	{
 		init_value = (float)1ul/(1-gamma);
 	}
-	for(uint32_t row = 0; row < m_states; ++row)
-	{
-		for(uint32_t col = 0; col < m_actions; ++col)
-		{
-			qtable[row][col] = init_value;
-		}
-	}
+	assert(m_actions <= MAX_ACTIONS);
+	qtable = new QTable(m_states, m_actions, init_value, parseQTableStorage(knob::le_qtable_storage), knob::le_qtable_frac_bits);
 
 	generator.seed(m_seed);
 	explore = new std::bernoulli_distribution(epsilon);
@@ -89,11 +79,7 @@ LearningEngineBasic::LearningEngineBasic(Prefetcher *parent, float alpha, float
 
 LearningEngineBasic::~LearningEngineBasic()
 {
-	for(uint32_t row = 0; row < m_states; ++row)
-	{
-		free(qtable[row]);
-	}
-	free(qtable);
+	delete qtable;
 	if(knob::le_enable_trace && trace)
 	{
 		fclose(trace);
@@ -168,27 +154,25 @@ void LearningEngineBasic::learn(uint32_t state1, uint32_t action1, int32_t rewar
 
 float LearningEngineBasic::consultQ(uint32_t state, uint32_t action)
 {
-	assert(state < m_states && action < m_actions);
-	float value = qtable[state][action];
-	return value;
+	return qtable->get(state, action);
 }
 
 void LearningEngineBasic::updateQ(uint32_t state, uint32_t action, float value)
 {
-	assert(state < m_states && action < m_actions);
-	qtable[state][action] = value;	
+	qtable->set(state, action, value);
 }
 
 uint32_t LearningEngineBasic::getMaxAction(uint32_t state)
 {
-	assert(state < m_states);
-	float max = qtable[state][0];
+	float q_values[MAX_ACTIONS];
+	qtable->get_row(state, q_values);
+	float max = q_values[0];
 	uint32_t action = 0;
 	for(uint32_t index = 1; index < m_actions; ++index)
 	{
-		if(qtable[state][index] > max)
+		if(q_values[index] > max)
 		{
-			max = qtable[state][index];
+			max = q_values[index];
 			action = index;
 		}
 	}
@@ -197,11 +181,10 @@ uint32_t LearningEngineBasic::getMaxAction(uint32_t state)
 
 std::string LearningEngineBasic::getStringQ(uint32_t state)
 {
-	assert(state < m_states);
 	std::stringstream ss;
 	for(uint32_t index = 0; index < m_actions; ++index)
 	{
-		ss << qtable[state][index] << ",";
+		ss << qtable->get(state, index) << ",";
 	}
 	return ss.str();
 }
@@ -216,7 +199,7 @@ void LearningEngineBasic::print_aux_stats()
 	{
 		for(uint32_t action = 0; action < m_actions; ++action)
 		{
-			if(qtable[state][action] != init_value)
+			if(qtable->get(state, action) != qtable->get_init_value())
 			{
 				state_used++;
 				break;
@@ -250,13 +233,27 @@ void LearningEngineBasic::dump_stats()
 	}
 }
 
+void LearningEngineBasic::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+	checkpoint.section("learning_engine_basic actions " + std::to_string(m_actions) + " states " + std::to_string(m_states));
+	checkpoint_hyperparameters(checkpoint);
+	checkpoint.value(m_action_counter);
+	qtable->checkpoint(checkpoint);
+
+	if(checkpoint.restore)
+	{
+		delete explore;
+		explore = new std::bernoulli_distribution(m_epsilon);
+	}
+}
+
 void LearningEngineBasic::dump_state_trace(uint32_t state)
 {
 	trace_timestamp++;
 	fprintf(trace, "%lu,", trace_timestamp);
 	for(uint32_t index = 0; index < m_actions; ++index)
 	{
-		fprintf(trace, "%.2f,", qtable[state][index]);
+		fprintf(trace, "%.2f,", qtable->get(state, index));
 	}
 	fprintf(trace, "\n");
 	fflush(trace);
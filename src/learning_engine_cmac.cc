@@ -21,7 +21,8 @@
 
 namespace knob
 {
-
+	extern string   le_qtable_storage;
+	extern uint32_t le_qtable_frac_bits;
 }
 
 LearningEngineCMAC::LearningEngineCMAC(CMACConfig config, Prefetcher *p, float alpha, float gamma, float epsilon, uint32_t actions, uint32_t states, uint64_t seed, std::string policy, std::string type, bool zero_init, uint64_t early_exploration_window)
@@ -41,15 +42,6 @@ LearningEngineCMAC::LearningEngineCMAC(CMACConfig config, Prefetcher *p, float a
 	assert(m_feature_granularities.size() == Feature::NumFeatures);
 	assert(m_action_factors.size() == m_actions);
 
-	/* init Q-tables
-	 * Each Q-table is a one-dimentional array.
-	 * It uses a random constant per action to separate learnings for each action */ 
-	m_qtables = (float**)calloc(m_num_planes, sizeof(float*));
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		m_qtables[plane] = (float*)calloc(m_num_entries_per_plane, sizeof(float));
-	}
-
 	/* init Q-value */
 	if(zero_init)
 	{
@@ -59,13 +51,11 @@ LearningEngineCMAC::LearningEngineCMAC(CMACConfig config, Prefetcher *p, float a
 	{
 		m_init_value = (float)1ul/(1-gamma);
 	}
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		for(uint32_t entry = 0; entry < m_num_entries_per_plane; ++entry)
-		{
-			m_qtables[plane][entry] = m_init_value;
-		}
-	}
+
+	/* init Q-tables
+	 * Each Q-table is a one-dimentional array, one row per plane.
+	 * It uses a random constant per action to separate learnings for each action */ 
+	m_qtables = new QTable(m_num_planes, m_num_entries_per_plane, m_init_value, parseQTableStorage(knob::le_qtable_storage), knob::le_qtable_frac_bits);
 
 	/* init random generators */
 	m_generator.seed(m_seed);
@@ -126,10 +116,7 @@ LearningEngineCMAC::LearningEngineCMAC(CMACConfig config, Prefetcher *p, float a
 
 LearningEngineCMAC::~LearningEngineCMAC()
 {
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		delete m_qtables[plane];
-	}
+	delete m_qtables;
 }
 
 uint32_t LearningEngineCMAC::chooseAction(State *state)
@@ -197,16 +184,7 @@ float LearningEngineCMAC::consultPlane(uint32_t plane, State *state, uint32_t ac
 	assert(action < m_actions);
 	uint32_t index = generatePlaneIndex(plane, state, action);
 	assert(index < m_num_entries_per_plane);
-	return m_qtables[plane][index];
-}
-
-void LearningEngineCMAC::updatePlane(uint32_t plane, State *state, uint32_t action, float value)
-{
-	assert(plane < m_num_planes);
-	assert(action < m_actions);
-	uint32_t index = generatePlaneIndex(plane, state, action);
-	assert(index < m_num_entries_per_plane);
-	m_qtables[plane][index] = value;
+	return m_qtables->get(plane, index);
 }
 
 uint32_t LearningEngineCMAC::generatePlaneIndex(uint32_t plane, State *state, uint32_t action)
@@ -259,16 +237,18 @@ void LearningEngineCMAC::learn(State *state1, uint32_t action1, int32_t reward,
 		/* update each plane */
 		for(uint32_t plane = 0; plane < m_num_planes; ++plane)
 		{
+			uint32_t index1 = generatePlaneIndex(plane, state1, action1);
+			uint32_t index2 = generatePlaneIndex(plane, state2, action2);
 			float Qsa1, Qsa2, Qsa1_old;
-			Qsa1 = consultPlane(plane, state1, action1);
-			Qsa2 = consultPlane(plane, state2, action2);
+			Qsa1 = m_qtables->get(plane, index1);
+			Qsa2 = m_qtables->get(plane, index2);
 			Qsa1_old = Qsa1;
 
 			/* SARSA */
 			Qsa1 = Qsa1 + m_alpha * ((float)reward + m_gamma * Qsa2 - Qsa1);
 
 			/* update back */
-			updatePlane(plane, state1, action1, Qsa1);
+			m_qtables->set(plane, index1, Qsa1);
 
 			MYLOG("Q(%s,%u) = %.2f, R = %d, Q(%s,%u) = %.2f, Q(%s,%u) = %.2f", state1->to_string().c_str(), action1, Qsa1_old, reward, state2->to_string().c_str(), action2, Qsa2, state1->to_string().c_str(), action1, Qsa1);
 		}
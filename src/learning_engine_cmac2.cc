@@ -7,6 +7,7 @@
 #include "util.h"
 #include "scooby.h"
 #include "statezoo.h"
+#include "checkpoint.h"
 
 
 #if 0
@@ -35,6 +36,8 @@ namespace knob
 	extern uint32_t 	le_cmac2_state_type;
 	extern vector<int32_t> le_cmac2_active_features;
 	extern bool 		le_cmac2_enable_action_fallback;
+	extern string 		le_qtable_storage;
+	extern uint32_t 	le_qtable_frac_bits;
 }
 
 LearningEngineCMAC2::LearningEngineCMAC2(CMACConfig config, Prefetcher *p, float alpha, float gamma, float epsilon, uint32_t actions, uint32_t states, uint64_t seed, std::string policy, std::string type, bool zero_init, uint64_t early_exploration_window)
@@ -69,21 +72,6 @@ LearningEngineCMAC2::LearningEngineCMAC2(CMACConfig config, Prefetcher *p, float
 		}
 	}
 
-	/* init Q-tables
-	 * Unlike CMAC engine 1.0, each Q-table is a two-dimentional array in CMAC 2.0*/
-	m_qtables = (float***)calloc(m_num_planes, sizeof(float**));
-	assert(m_qtables);
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		m_qtables[plane] = (float**)calloc(m_num_entries_per_plane, sizeof(float*));
-		assert(m_qtables[plane]);
-		for(uint32_t entry = 0; entry < m_num_entries_per_plane; ++entry)
-		{
-			m_qtables[plane][entry] = (float*)calloc(m_actions, sizeof(float));
-			assert(m_qtables[plane][entry]);
-		}
-	}
-
 	/* init Q-value */
 	if(zero_init)
 	{
@@ -107,16 +95,11 @@ LearningEngineCMAC2::LearningEngineCMAC2(CMACConfig config, Prefetcher *p, float
 	}
 
 
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		for(uint32_t entry = 0; entry < m_num_entries_per_plane; ++entry)
-		{
-			for(uint32_t action = 0; action < m_actions; ++action)
-			{
-				m_qtables[plane][entry][action] = m_init_value;
-			}
-		}
-	}
+	/* init Q-tables
+	 * Unlike CMAC engine 1.0, each Q-table is a two-dimentional array in CMAC 2.0.
+	 * All planes share one table, plane after plane */
+	assert(m_actions <= MAX_ACTIONS);
+	m_qtables = new QTable(m_num_planes * m_num_entries_per_plane, m_actions, m_init_value, parseQTableStorage(knob::le_qtable_storage), knob::le_qtable_frac_bits);
 
 	/* init random generators */
 	m_generator.seed(m_seed);
@@ -141,10 +124,7 @@ LearningEngineCMAC2::LearningEngineCMAC2(CMACConfig config, Prefetcher *p, float
 
 LearningEngineCMAC2::~LearningEngineCMAC2()
 {
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		delete m_qtables[plane];
-	}
+	delete m_qtables;
 }
 
 uint32_t LearningEngineCMAC2::chooseAction(State *state, float &max_to_avg_q_ratio)
@@ -190,10 +170,12 @@ uint32_t LearningEngineCMAC2::getMaxAction(State *state, float &max_q, float &ma
 	uint32_t selected_action = 0;
 	float q_value = 0.0, total_q_value = 0.0, max_q_value = 0.0, second_max_q_value = 0.0;
 	uint32_t init_index = 0;
+	float q_values[MAX_ACTIONS];
+	consultQ(state, q_values);
 
 	if(!knob::le_cmac2_enable_action_fallback)
 	{
-		max_q_value = consultQ(state, 0);
+		max_q_value = q_values[0];
 		second_max_q_value = max_q_value;
 		total_q_value += max_q_value;
 		init_index = 1;
@@ -201,7 +183,7 @@ uint32_t LearningEngineCMAC2::getMaxAction(State *state, float &max_q, float &ma
 
 	for(uint32_t action = init_index; action < m_actions; ++action)
 	{
-		q_value = consultQ(state, action);
+		q_value = q_values[action];
 		total_q_value += q_value;
 
 		if(q_value > max_q_value)
@@ -282,33 +264,11 @@ uint32_t LearningEngineCMAC2::getMaxAction(State *state, float &max_q, float &ma
 	return selected_action;
 }
 
-float LearningEngineCMAC2::consultQ(State *state, uint32_t action)
+void LearningEngineCMAC2::consultQ(State *state, float *q_values)
 {
-	assert(action < m_actions);
-	float q_value = 0.0;
-	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
-	{
-		q_value += consultPlane(plane, state, action);
-	}
-	return q_value;
-}
-
-float LearningEngineCMAC2::consultPlane(uint32_t plane, State *state, uint32_t action)
-{
-	assert(plane < m_num_planes);
-	assert(action < m_actions);
-	uint32_t index = generatePlaneIndex(plane, state, action);
-	assert(index < m_num_entries_per_plane);
-	return m_qtables[plane][index][action];
-}
-
-void LearningEngineCMAC2::updatePlane(uint32_t plane, State *state, uint32_t action, float value)
-{
-	assert(plane < m_num_planes);
-	assert(action < m_actions);
-	uint32_t index = generatePlaneIndex(plane, state, action);
-	assert(index < m_num_entries_per_plane);
-	m_qtables[plane][index][action] = value;
+	uint32_t rows[MAX_CMAC_PLANES];
+	getPlaneRows(state, rows);
+	m_qtables->sum_rows(rows, m_num_planes, q_values);
 }
 
 uint32_t LearningEngineCMAC2::generatePlaneIndex(uint32_t plane, State *state, uint32_t action)
@@ -321,35 +281,46 @@ uint32_t LearningEngineCMAC2::generatePlaneIndex(uint32_t plane, State *state, u
 	return (hashed_index % m_num_entries_per_plane);
 }
 
+void LearningEngineCMAC2::getPlaneRows(State *state, uint32_t *rows)
+{
+	/* the index does not depend on the action */
+	for(uint32_t plane = 0; plane < m_num_planes; ++plane)
+	{
+		rows[plane] = plane * m_num_entries_per_plane + generatePlaneIndex(plane, state, 0);
+	}
+}
+
 void LearningEngineCMAC2::learn(State *state1, uint32_t action1, int32_t reward, State *state2, uint32_t action2)
 {
 	stats.learn.called++;
 
-	/* debugging */
-	float Qsa1_total = 0.0, Qsa2_total = 0.0, Qsa1_total_new = 0.0;
-	Qsa1_total = consultQ(state1, action1);
-	Qsa2_total = consultQ(state2, action2);
-
 	if(m_type == LearningType::SARSA && m_policy == Policy::EGreedy)
 	{
+		/* index every plane once per state */
+		uint32_t rows1[MAX_CMAC_PLANES], rows2[MAX_CMAC_PLANES];
+		getPlaneRows(state1, rows1);
+		getPlaneRows(state2, rows2);
+
 		/* update each plane */
+		float Qsa1_total = 0.0, Qsa2_total = 0.0, Qsa1_total_new = 0.0; /* debugging */
 		for(uint32_t plane = 0; plane < m_num_planes; ++plane)
 		{
 			float Qsa1, Qsa2, Qsa1_old;
-			Qsa1 = consultPlane(plane, state1, action1);
-			Qsa2 = consultPlane(plane, state2, action2);
+			Qsa1 = m_qtables->get(rows1[plane], action1);
+			Qsa2 = m_qtables->get(rows2[plane], action2);
 			Qsa1_old = Qsa1;
 
 			/* SARSA */
 			Qsa1 = Qsa1 + m_alpha * ((float)reward + m_gamma * Qsa2 - Qsa1);
 
 			/* update back */
-			updatePlane(plane, state1, action1, Qsa1);
+			m_qtables->set(rows1[plane], action1, Qsa1);
 
 			MYLOG("<plane_%u> Q(%s,%u) = %.2f, R = %d, Q(%s,%u) = %.2f, Q(%s,%u) = %.2f", plane, state1->to_string().c_str(), action1, Qsa1_old, reward, state2->to_string().c_str(), action2, Qsa2, state1->to_string().c_str(), action1, Qsa1);
+			Qsa1_total += Qsa1_old;
+			Qsa2_total += Qsa2;
+			Qsa1_total_new += Qsa1;
 		}
-
-		Qsa1_total_new = consultQ(state1, action1);
 		MYLOG("<overall> Q(%s,%u) = %.2f, R = %d, Q(%s,%u) = %.2f, Q(%s,%u) = %.2f", state1->to_string().c_str(), action1, Qsa1_total, reward, state2->to_string().c_str(), action2, Qsa2_total, state1->to_string().c_str(), action1, Qsa1_total_new);
 
 		/* debugging */
@@ -371,13 +342,34 @@ void LearningEngineCMAC2::learn(State *state1, uint32_t action1, int32_t reward,
 	}
 }
 
+void LearningEngineCMAC2::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+	/* the Q-values only mean the same with the same plane indices */
+	std::stringstream tag;
+	tag << "learning_engine_cmac2 actions " << m_actions << " planes " << m_num_planes << " entries " << m_num_entries_per_plane
+		<< " offsets " << array_to_string(m_plane_offsets) << " granularities " << array_to_string(m_feature_granularities)
+		<< " hash " << m_hash_type << " state_type " << knob::le_cmac2_state_type << " features " << array_to_string(knob::le_cmac2_active_features);
+	checkpoint.section(tag.str());
+	checkpoint_hyperparameters(checkpoint);
+	checkpoint.value(m_action_counter);
+	m_qtables->checkpoint(checkpoint);
+
+	if(checkpoint.restore)
+	{
+		delete m_explore;
+		m_explore = new std::bernoulli_distribution(m_epsilon);
+	}
+}
+
 void LearningEngineCMAC2::dump_state_trace(State *state)
 {
 	trace_timestamp++;
 	fprintf(trace, "%lu,", trace_timestamp);
+	float q_values[MAX_ACTIONS];
+	consultQ(state, q_values);
 	for(uint32_t action = 0; action < m_actions; ++action)
 	{
-		fprintf(trace, "%.2f,", consultQ(state, action));
+		fprintf(trace, "%.2f,", q_values[action]);
 	}
 	fprintf(trace, "\n");
 	fflush(trace);
@@ -6,6 +6,7 @@
 #include "util.h"
 #include "learning_engine_featurewise.h"
 #include "scooby.h"
+#include "checkpoint.h"
 
 #if 0
 #	define LOCKED(...) {fflush(stdout); __VA_ARGS__; fflush(stdout);}
@@ -187,18 +188,20 @@ uint32_t LearningEngineFeaturewise::getMaxAction(State *state, float &max_q, flo
 {
 	float max_q_value = 0.0, q_value = 0.0, total_q_value = 0.0;
 	uint32_t selected_action = 0, init_index = 0;
+	float q_values[FK_MAX_ROW_SIZE];
 
 	bool fallback = do_fallback(state);
+	consultQ(state, q_values);
 
 	if(!fallback)
 	{
-		max_q_value = consultQ(state, 0);
+		max_q_value = q_values[0];
 		total_q_value += max_q_value;
 		init_index = 1;
 	}
 	for(uint32_t action = init_index; action < m_actions; ++action)
 	{
-		q_value = consultQ(state, action);
+		q_value = q_values[action];
 		total_q_value += q_value;
 		if(q_value > max_q_value)
 		{
@@ -227,33 +230,44 @@ uint32_t LearningEngineFeaturewise::getMaxAction(State *state, float &max_q, flo
 	}
 	max_q = max_q_value;
 
-	action_selection_consensus(state, selected_action, consensus_vec);
+	action_selection_consensus(selected_action, consensus_vec);
 
 	return selected_action;
 }
 
-float LearningEngineFeaturewise::consultQ(State *state, uint32_t action)
+/* Q-values of all actions, each feature computes its tile indices once */
+void LearningEngineFeaturewise::consultQ(State *state, float *q_values)
 {
-	assert(action < m_actions);
-	float q_value = 0.0;
-	float max = -1000000000.0;
+	float max[FK_MAX_ROW_SIZE];
+	for(uint32_t action = 0; action < m_actions; ++action)
+	{
+		q_values[action] = 0.0;
+		max[action] = -1000000000.0;
+	}
 
 	/* pool Q-value accross all feature tables */
 	for(uint32_t index = 0; index < NumFeatureTypes; ++index)
 	{
 		if(m_feature_knowledges[index])
 		{
+			float *feature_q_values = m_feature_q_values[index];
+			m_feature_knowledges[index]->retrieveQ(state, feature_q_values);
 			if(knob::le_featurewise_pooling_type == 1) /* sum pooling */
 			{
-				q_value += m_feature_knowledges[index]->retrieveQ(state, action);
+				for(uint32_t action = 0; action < m_actions; ++action)
+				{
+					q_values[action] += feature_q_values[action];
+				}
 			}
 			else if(knob::le_featurewise_pooling_type == 2) /* max pooling */
 			{
-				float tmp = m_feature_knowledges[index]->retrieveQ(state, action);
-				if(tmp >= max)
+				for(uint32_t action = 0; action < m_actions; ++action)
 				{
-					max = tmp;
-					q_value = tmp;
+					if(feature_q_values[action] >= max[action])
+					{
+						max[action] = feature_q_values[action];
+						q_values[action] = feature_q_values[action];
+					}
 				}
 			}
 			else
@@ -262,7 +276,6 @@ float LearningEngineFeaturewise::consultQ(State *state, uint32_t action)
 			}
 		}
 	}
-	return q_value;
 }
 
 void LearningEngineFeaturewise::dump_stats()
@@ -327,6 +340,25 @@ void LearningEngineFeaturewise::dump_stats()
 	}
 }
 
+void LearningEngineFeaturewise::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+	checkpoint.section("learning_engine_featurewise actions " + std::to_string(m_actions) + " features " + array_to_string(knob::le_featurewise_active_features));
+	checkpoint_hyperparameters(checkpoint);
+	for(uint32_t index = 0; index < NumFeatureTypes; ++index)
+	{
+		if(m_feature_knowledges[index])
+		{
+			m_feature_knowledges[index]->checkpoint(checkpoint);
+		}
+	}
+
+	if(checkpoint.restore)
+	{
+		delete m_explore;
+		m_explore = new std::bernoulli_distribution(m_epsilon);
+	}
+}
+
 void LearningEngineFeaturewise::gather_stats(float max_q, float max_to_avg_q_ratio)
 {
 	float high = 0.0, low = 0.0;
@@ -342,8 +374,9 @@ void LearningEngineFeaturewise::gather_stats(float max_q, float max_to_avg_q_rat
 	}
 }
 
-/* consensus stats: whether each feature's maxAction decision aligns with the final selected action */
-void LearningEngineFeaturewise::action_selection_consensus(State *state, uint32_t selected_action, vector<bool> &consensus_vec)
+/* consensus stats: whether each feature's maxAction decision aligns with the final selected action,
+ * using the Q-values of the features from consultQ */
+void LearningEngineFeaturewise::action_selection_consensus(uint32_t selected_action, vector<bool> &consensus_vec)
 {
 	stats.consensus.total++;
 	bool all_features_align = true;
@@ -351,7 +384,7 @@ void LearningEngineFeaturewise::action_selection_consensus(State *state, uint32_
 	{
 		if(m_feature_knowledges[index])
 		{
-			if(m_feature_knowledges[index]->getMaxAction(state) == selected_action)
+			if(m_feature_knowledges[index]->getMaxAction(m_feature_q_values[index]) == selected_action)
 			{
 				stats.consensus.feature_align_dist[index]++;
 				consensus_vec[index] = true;
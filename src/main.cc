@@ -4,6 +4,8 @@
 #include "ooo_cpu.h"
 #include "uncore.h"
 #include "knobs.h"
+#include "parallel_sim.h"
+#include "batch.h"
 #include <fstream>
 
 #define FIXED_FLOAT(x) std::fixed << std::setprecision(5) << (x)
@@ -34,6 +36,80 @@ namespace knob
 {
     extern uint64_t warmup_instructions;
     extern uint64_t simulation_instructions;
+    extern uint64_t skip_instructions;
+    extern bool     functional_warming;
+    extern string   save_checkpoint;
+    extern string   load_checkpoint;
+    extern bool     cycle_skipping;
+    extern bool     parallel_simulation;
+    extern uint32_t parallel_quantum;
+    extern string   batch_jobs;
+    extern uint32_t batch_threads;
+    extern bool     batch_trace_cache;
+    extern uint64_t batch_cache_instructions;
+    extern bool     approximate_footprint;
+    extern uint32_t fetch_width;
+    extern uint32_t decode_width;
+    extern uint32_t exec_width;
+    extern uint32_t lq_width;
+    extern uint32_t sq_width;
+    extern uint32_t retire_width;
+    extern uint32_t scheduler_size;
+    extern uint32_t branch_mispredict_penalty;
+    extern uint32_t scheduling_latency;
+    extern uint32_t exec_latency;
+    extern uint32_t rob_size;
+    extern uint32_t lq_size;
+    extern uint32_t sq_size;
+    extern uint32_t itlb_set;
+    extern uint32_t itlb_way;
+    extern uint32_t itlb_rq_size;
+    extern uint32_t itlb_wq_size;
+    extern uint32_t itlb_pq_size;
+    extern uint32_t itlb_mshr_size;
+    extern uint32_t itlb_latency;
+    extern uint32_t dtlb_set;
+    extern uint32_t dtlb_way;
+    extern uint32_t dtlb_rq_size;
+    extern uint32_t dtlb_wq_size;
+    extern uint32_t dtlb_pq_size;
+    extern uint32_t dtlb_mshr_size;
+    extern uint32_t dtlb_latency;
+    extern uint32_t stlb_set;
+    extern uint32_t stlb_way;
+    extern uint32_t stlb_rq_size;
+    extern uint32_t stlb_wq_size;
+    extern uint32_t stlb_pq_size;
+    extern uint32_t stlb_mshr_size;
+    extern uint32_t stlb_latency;
+    extern uint32_t l1i_set;
+    extern uint32_t l1i_way;
+    extern uint32_t l1i_rq_size;
+    extern uint32_t l1i_wq_size;
+    extern uint32_t l1i_pq_size;
+    extern uint32_t l1i_mshr_size;
+    extern uint32_t l1i_latency;
+    extern uint32_t l1d_set;
+    extern uint32_t l1d_way;
+    extern uint32_t l1d_rq_size;
+    extern uint32_t l1d_wq_size;
+    extern uint32_t l1d_pq_size;
+    extern uint32_t l1d_mshr_size;
+    extern uint32_t l1d_latency;
+    extern uint32_t l2c_set;
+    extern uint32_t l2c_way;
+    extern uint32_t l2c_rq_size;
+    extern uint32_t l2c_wq_size;
+    extern uint32_t l2c_pq_size;
+    extern uint32_t l2c_mshr_size;
+    extern uint32_t l2c_latency;
+    extern uint32_t llc_set;
+    extern uint32_t llc_way;
+    extern uint32_t llc_rq_size;
+    extern uint32_t llc_wq_size;
+    extern uint32_t llc_pq_size;
+    extern uint32_t llc_mshr_size;
+    extern uint32_t llc_latency;
     extern uint8_t  knob_cloudsuite;
     extern uint8_t  knob_low_bandwidth;
     extern bool     measure_ipc;
@@ -53,12 +129,13 @@ namespace knob
 }
 
 time_t start_time;
+uint8_t show_heartbeat = 1;
 
 // PAGE TABLE
 uint32_t PAGE_TABLE_LATENCY = 0, SWAP_LATENCY = 0;
-queue <uint64_t > page_queue;
-map <uint64_t, uint64_t> page_table, inverse_table, recent_page, unique_cl[NUM_CPUS];
-uint64_t previous_ppage, num_adjacent_page, num_cl[NUM_CPUS], allocated_pages, num_page[NUM_CPUS], minor_fault[NUM_CPUS], major_fault[NUM_CPUS];
+PAGE_TABLE page_table;
+FOOTPRINT unique_cl[NUM_CPUS];
+uint64_t previous_ppage, num_adjacent_page, allocated_pages, num_page[NUM_CPUS], minor_fault[NUM_CPUS], major_fault[NUM_CPUS];
 
 void record_roi_stats(uint32_t cpu, CACHE *cache)
 {
@@ -235,8 +312,8 @@ void finish_warmup()
     elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
 
     // reset core latency
-    SCHEDULING_LATENCY = 6;
-    EXEC_LATENCY = 1;
+    SCHEDULING_LATENCY = knob::scheduling_latency;
+    EXEC_LATENCY = knob::exec_latency;
     PAGE_TABLE_LATENCY = 100;
     SWAP_LATENCY = 100000;
 
@@ -268,16 +345,20 @@ void finish_warmup()
         uncore.DRAM.WQ[i].ROW_BUFFER_MISS = 0;
     }
 
+    // later runs can start from here with --load_checkpoint
+    if (knob::save_checkpoint.size())
+        checkpoint_simulator(knob::save_checkpoint.c_str(), 0);
+
     // set actual cache latency
     for (uint32_t i=0; i<NUM_CPUS; i++) {
-        ooo_cpu[i].ITLB.LATENCY = ITLB_LATENCY;
-        ooo_cpu[i].DTLB.LATENCY = DTLB_LATENCY;
-        ooo_cpu[i].STLB.LATENCY = STLB_LATENCY;
-        ooo_cpu[i].L1I.LATENCY  = L1I_LATENCY;
-        ooo_cpu[i].L1D.LATENCY  = L1D_LATENCY;
-        ooo_cpu[i].L2C.LATENCY  = L2C_LATENCY;
+        ooo_cpu[i].ITLB.LATENCY = knob::itlb_latency;
+        ooo_cpu[i].DTLB.LATENCY = knob::dtlb_latency;
+        ooo_cpu[i].STLB.LATENCY = knob::stlb_latency;
+        ooo_cpu[i].L1I.LATENCY  = knob::l1i_latency;
+        ooo_cpu[i].L1D.LATENCY  = knob::l1d_latency;
+        ooo_cpu[i].L2C.LATENCY  = knob::l2c_latency;
     }
-    uncore.LLC.LATENCY = LLC_LATENCY;
+    uncore.LLC.LATENCY = knob::llc_latency;
 }
 
 void print_deadlock(uint32_t i)
@@ -354,6 +435,8 @@ uint64_t rotr64 (uint64_t n, unsigned int c)
 RANDOM champsim_rand(champsim_seed);
 uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_vpage)
 {
+    SHARED_ACCESS page_table_access(cpu, page_table_mutex);
+
 #ifdef SANITY_CHECK
     if (va == 0)
         assert(0);
@@ -369,67 +452,24 @@ uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_
     // smart random number generator
     uint64_t random_ppage;
 
-    map <uint64_t, uint64_t>::iterator pr = page_table.begin();
-    map <uint64_t, uint64_t>::iterator ppage_check = inverse_table.begin();
-
     // check unique cache line footprint
-    map <uint64_t, uint64_t>::iterator cl_check = unique_cl[cpu].find(unique_va >> LOG2_BLOCK_SIZE);
-    if (cl_check == unique_cl[cpu].end()) { // we've never seen this cache line before
-        unique_cl[cpu].insert(make_pair(unique_va >> LOG2_BLOCK_SIZE, 0));
-        num_cl[cpu]++;
-    }
-    else
-        cl_check->second++;
+    unique_cl[cpu].add(unique_va >> LOG2_BLOCK_SIZE);
 
-    pr = page_table.find(vpage);
-    if (pr == page_table.end()) { // no VA => PA translation found
+    uint32_t slot = page_table.find(vpage);
+    if (slot == NO_SLOT) { // no VA => PA translation found
 
         if (allocated_pages >= DRAM_PAGES) { // not enough memory
 
-            // TODO: elaborate page replacement algorithm
-            // here, ChampSim randomly selects a page that is not recently used and we only track 32K recently accessed pages
-            uint8_t  found_NRU = 0;
-            uint64_t NRU_vpage = 0; // implement it
-            // map <uint64_t, uint64_t>::iterator pr2 = recent_page.begin();
-            for (pr = page_table.begin(); pr != page_table.end(); pr++) {
-
-                NRU_vpage = pr->first;
-                if (recent_page.find(NRU_vpage) == recent_page.end()) {
-                    found_NRU = 1;
-                    break;
-                }
-            }
-#ifdef SANITY_CHECK
-            if (found_NRU == 0)
-                assert(0);
-
-            if (pr == page_table.end())
-                assert(0);
-#endif
-            DP ( if (warmup_complete[cpu]) {
-            cout << "[SWAP] update page table NRU_vpage: " << hex << pr->first << " new_vpage: " << vpage << " ppage: " << pr->second << dec << endl; });
-
-            // update page table with new VA => PA mapping
-            // since we cannot change the key value already inserted in a map structure, we need to erase the old node and add a new node
-            uint64_t mapped_ppage = pr->second;
-            page_table.erase(pr);
-            page_table.insert(make_pair(vpage, mapped_ppage));
-
-            // update inverse table with new PA => VA mapping
-            ppage_check = inverse_table.find(mapped_ppage);
-#ifdef SANITY_CHECK
-            if (ppage_check == inverse_table.end())
-                assert(0);
-#endif
-            ppage_check->second = vpage;
+            // swap out a page that was not translated since the clock hand last passed it (NRU)
+            slot = page_table.nru_victim();
+            uint64_t NRU_vpage = page_table.vpage(slot),
+                     mapped_ppage = page_table.ppage(slot);
 
             DP ( if (warmup_complete[cpu]) {
-            cout << "[SWAP] update inverse table NRU_vpage: " << hex << NRU_vpage << " new_vpage: ";
-            cout << ppage_check->second << " ppage: " << ppage_check->first << dec << endl; });
+            cout << "[SWAP] update page table NRU_vpage: " << hex << NRU_vpage << " new_vpage: " << vpage << " ppage: " << mapped_ppage << dec << endl; });
 
-            // update page_queue
-            page_queue.pop();
-            page_queue.push(vpage);
+            // the physical page now holds the new virtual page
+            page_table.remap(slot, vpage);
 
             // invalidate corresponding vpage and ppage from the cache hierarchy
             ooo_cpu[cpu].ITLB.invalidate_entry(NRU_vpage);
@@ -461,10 +501,9 @@ uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_
             //random_ppage |= (cpu<<(32-LOG2_PAGE_SIZE));
 
             while (1) { // try to find an empty physical page number
-                ppage_check = inverse_table.find(random_ppage); // check if this page can be allocated
-                if (ppage_check != inverse_table.end()) { // random_ppage is not available
+                if (page_table.ppage_mapped(random_ppage)) { // random_ppage is not available
                     DP ( if (warmup_complete[cpu]) {
-                    cout << "vpage: " << hex << ppage_check->first << " is already mapped to ppage: " << random_ppage << dec << endl; });
+                    cout << "ppage: " << hex << random_ppage << " is already mapped" << dec << endl; });
 
                     if (num_adjacent_page > 0)
                         fragmented = 1;
@@ -482,9 +521,7 @@ uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_
 
             // insert translation to page tables
             //printf("Insert  num_adjacent_page: %u  vpage: %lx  ppage: %lx\n", num_adjacent_page, vpage, random_ppage);
-            page_table.insert(make_pair(vpage, random_ppage));
-            inverse_table.insert(make_pair(random_ppage, vpage));
-            page_queue.push(vpage);
+            slot = page_table.map(vpage, random_ppage);
             previous_ppage = random_ppage;
             num_adjacent_page--;
             num_page[cpu]++;
@@ -503,16 +540,9 @@ uint64_t va_to_pa(uint32_t cpu, uint64_t instr_id, uint64_t va, uint64_t unique_
         else
             minor_fault[cpu]++;
     }
-    else {
-        //printf("Found  vpage: %lx  random_ppage: %lx\n", vpage, pr->second);
-    }
 
-    pr = page_table.find(vpage);
-#ifdef SANITY_CHECK
-    if (pr == page_table.end())
-        assert(0);
-#endif
-    uint64_t ppage = pr->second;
+    page_table.touch(slot);
+    uint64_t ppage = page_table.ppage(slot);
 
     uint64_t pa = ppage << LOG2_PAGE_SIZE;
     pa |= voffset;
@@ -535,6 +565,18 @@ void print_knobs()
 {
     cout << "warmup_instructions " << knob::warmup_instructions << endl
         << "simulation_instructions " << knob::simulation_instructions << endl
+        << "skip_instructions " << knob::skip_instructions << endl
+        << "functional_warming " << knob::functional_warming << endl
+        << "save_checkpoint " << knob::save_checkpoint << endl
+        << "load_checkpoint " << knob::load_checkpoint << endl
+        << "cycle_skipping " << knob::cycle_skipping << endl
+        << "parallel_simulation " << knob::parallel_simulation << endl
+        << "parallel_quantum " << knob::parallel_quantum << endl
+        << "batch_jobs " << knob::batch_jobs << endl
+        << "batch_threads " << knob::batch_threads << endl
+        << "batch_trace_cache " << knob::batch_trace_cache << endl
+        << "batch_cache_instructions " << knob::batch_cache_instructions << endl
+        << "approximate_footprint " << knob::approximate_footprint << endl
         << "champsim_seed " << champsim_seed << endl
         // << "low_bandwidth " << knob_low_bandwidth << endl
         // << "scramble_loads " << knob_scramble_loads << endl
@@ -604,6 +646,316 @@ int get_next_cpu()
    return index;
 }
 
+void get_elapsed_time(uint64_t &elapsed_hour, uint64_t &elapsed_minute, uint64_t &elapsed_second)
+{
+    elapsed_second = (uint64_t)(time(NULL) - start_time);
+    elapsed_minute = elapsed_second / 60;
+    elapsed_hour = elapsed_minute / 60;
+    elapsed_minute -= elapsed_hour*60;
+    elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
+}
+
+// one cycle of a core and its private caches
+void simulate_core_cycle(uint32_t i)
+{
+    // proceed one cycle
+    current_core_cycle[i]++;
+
+    /* monitor IPC */
+    if(knob::measure_ipc && current_core_cycle[i] >= ooo_cpu[i].next_measure_ipc_cycle)
+    {
+        uint64_t ins_in_epoch = ooo_cpu[i].num_retired - ooo_cpu[i].last_num_ins;
+        if(ins_in_epoch >= ooo_cpu[i].last_ins_in_epoch)
+        {
+            /* IPC increased */
+            // MYLOG("Core-%u cycle %lu last_num_ins %lu last_ins_in_epoch %lu ins_in_epoch %lu UP", i, current_core_cycle[i], ooo_cpu[i].last_num_ins, ooo_cpu[i].last_ins_in_epoch, ins_in_epoch);
+            ooo_cpu[i].broadcast_ipc(1);
+        }
+        else
+        {
+            /* IPC decreased */
+            // MYLOG("Core-%u cycle %lu last_num_ins %lu last_ins_in_epoch %lu ins_in_epoch %lu DOWN", i, current_core_cycle[i], ooo_cpu[i].last_num_ins, ooo_cpu[i].last_ins_in_epoch, ins_in_epoch);
+            ooo_cpu[i].broadcast_ipc(0);
+        }
+        ooo_cpu[i].last_num_ins = ooo_cpu[i].num_retired;
+        ooo_cpu[i].last_ins_in_epoch = ins_in_epoch;
+        ooo_cpu[i].next_measure_ipc_cycle = current_core_cycle[i] + knob::measure_ipc_epoch;
+    }
+
+    //cout << "Trying to process instr_id: " << ooo_cpu[i].instr_unique_id << " fetch_stall: " << +ooo_cpu[i].fetch_stall;
+    //cout << " stall_cycle: " << stall_cycle[i] << " current: " << current_core_cycle[i] << endl;
+
+    // core might be stalled due to page fault or branch misprediction
+    if (stall_cycle[i] <= current_core_cycle[i]) {
+
+        // fetch unit
+        if (ooo_cpu[i].ROB.occupancy < ooo_cpu[i].ROB.SIZE) {
+            // handle branch
+            if (ooo_cpu[i].fetch_stall == 0)
+                ooo_cpu[i].handle_branch();
+        }
+
+        // fetch
+        ooo_cpu[i].fetch_instruction();
+
+
+        // schedule (including decode latency)
+        uint32_t schedule_index = ooo_cpu[i].ROB.next_schedule;
+        if ((ooo_cpu[i].ROB.entry[schedule_index].scheduled == 0) && (ooo_cpu[i].ROB.entry[schedule_index].event_cycle <= current_core_cycle[i]))
+            ooo_cpu[i].schedule_instruction();
+
+        // execute
+        ooo_cpu[i].execute_instruction();
+
+        // memory operation
+        ooo_cpu[i].schedule_memory_instruction();
+        ooo_cpu[i].execute_memory_instruction();
+
+        // complete
+        ooo_cpu[i].update_rob();
+
+        // retire
+        if ((ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].executed == COMPLETED) && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle <= current_core_cycle[i]))
+            ooo_cpu[i].retire_rob();
+    }
+}
+
+// heartbeat, deadlock detection and the warmup/simulation milestones of a core
+void check_core_progress(uint32_t i)
+{
+    // heartbeat information
+    if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction)) {
+        float cumulative_ipc;
+        if (warmup_complete[i])
+            cumulative_ipc = (1.0*(ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr)) / (current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle);
+        else
+            cumulative_ipc = (1.0*ooo_cpu[i].num_retired) / current_core_cycle[i];
+        float heartbeat_ipc = (1.0*ooo_cpu[i].num_retired - ooo_cpu[i].last_sim_instr) / (current_core_cycle[i] - ooo_cpu[i].last_sim_cycle);
+
+        cout << "Heartbeat CPU " << setw(2) << i << " instructions: " << setw(10) << ooo_cpu[i].num_retired << " cycles: " << setw(10) << current_core_cycle[i];
+        cout << " heartbeat IPC: " << FIXED_FLOAT(heartbeat_ipc) << " cumulative IPC: " << FIXED_FLOAT(cumulative_ipc);
+        uint64_t elapsed_hour, elapsed_minute, elapsed_second;
+        get_elapsed_time(elapsed_hour, elapsed_minute, elapsed_second);
+        cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
+        ooo_cpu[i].next_print_instruction += STAT_PRINTING_PERIOD;
+
+        ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
+        ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
+    }
+
+    // check for deadlock
+    if (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].ip && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle + DEADLOCK_CYCLE) <= current_core_cycle[i])
+        print_deadlock(i);
+
+    // check for warmup
+    // warmup complete
+    if ((warmup_complete[i] == 0) && (ooo_cpu[i].num_retired > knob::warmup_instructions)) {
+        warmup_complete[i] = 1;
+        all_warmup_complete++;
+    }
+    if (all_warmup_complete == NUM_CPUS) { // this part is called only once when all cores are warmed up
+        all_warmup_complete++;
+        finish_warmup();
+    }
+
+    /*
+    if (all_warmup_complete == 0) {
+        all_warmup_complete = 1;
+        finish_warmup();
+    }
+    if (ooo_cpu[1].num_retired > 0)
+        warmup_complete[1] = 1;
+    */
+
+    // simulation complete
+    if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions))) {
+        simulation_complete[i] = 1;
+        ooo_cpu[i].finish_sim_instr = ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr;
+        ooo_cpu[i].finish_sim_cycle = current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle;
+
+        cout << "Finished CPU " << i << " instructions: " << ooo_cpu[i].finish_sim_instr << " cycles: " << ooo_cpu[i].finish_sim_cycle;
+        cout << " cumulative IPC: " << ((float) ooo_cpu[i].finish_sim_instr / ooo_cpu[i].finish_sim_cycle);
+        uint64_t elapsed_hour, elapsed_minute, elapsed_second;
+        get_elapsed_time(elapsed_hour, elapsed_minute, elapsed_second);
+        cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
+
+        record_roi_stats(i, &ooo_cpu[i].L1D);
+        record_roi_stats(i, &ooo_cpu[i].L1I);
+        record_roi_stats(i, &ooo_cpu[i].L2C);
+        record_roi_stats(i, &uncore.LLC);
+
+        all_simulation_complete++;
+    }
+}
+
+// one cycle of the LLC and the memory controller
+void operate_uncore()
+{
+    // TODO: should it be backward?
+    uncore.cycle++;
+    if(knob::measure_dram_bw && uncore.cycle >= uncore.DRAM.next_bw_measure_cycle)
+    {
+        uint64_t this_epoch_enqueue_count = uncore.DRAM.rq_enqueue_count - uncore.DRAM.last_enqueue_count;
+        uncore.DRAM.epoch_enqueue_count = (uncore.DRAM.epoch_enqueue_count/2) + this_epoch_enqueue_count;
+        uint32_t quartile = ((float)100*uncore.DRAM.epoch_enqueue_count)/DRAM_DBUS_MAX_CAS;
+        if(quartile <= 25)      uncore.DRAM.bw = 0;
+        else if(quartile <= 50) uncore.DRAM.bw = 1;
+        else if(quartile <= 75) uncore.DRAM.bw = 2;
+        else                    uncore.DRAM.bw = 3;
+        MYLOG("cycle %lu rq_enqueue_count %lu last_enqueue_count %lu epoch_enqueue_count %lu QUARTILE %u", uncore.cycle, uncore.DRAM.rq_enqueue_count, uncore.DRAM.last_enqueue_count, uncore.DRAM.epoch_enqueue_count, uncore.DRAM.bw);
+        uncore.DRAM.last_enqueue_count = uncore.DRAM.rq_enqueue_count;
+        uncore.DRAM.next_bw_measure_cycle = uncore.cycle + knob::measure_dram_bw_epoch;
+        uncore.DRAM.total_bw_epochs++;
+        uncore.DRAM.bw_level_hist[uncore.DRAM.bw]++;
+        uncore.LLC.broadcast_bw(uncore.DRAM.bw);
+    }
+
+    uncore.LLC.operate();
+    uncore.DRAM.operate();
+}
+
+uint64_t skipped_cycles = 0;
+
+// jumps over the cycles in which no core, cache or the memory controller can do anything,
+// which leaves every statistic exactly as if those cycles had been simulated one by one
+void skip_idle_cycles()
+{
+    uint64_t cycles = UINT64_MAX;
+    if (knob::measure_dram_bw)
+        cycles = cycles_until(uncore.DRAM.next_bw_measure_cycle, uncore.cycle);
+
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        cycles = min(cycles, ooo_cpu[i].cycles_to_next_event());
+        if (cycles == 1)
+            return;
+    }
+
+    cycles = min(cycles, uncore.LLC.cycles_to_next_event());
+    cycles = min(cycles, uncore.DRAM.cycles_to_next_event());
+    if (cycles <= 1)
+        return;
+
+    // the next event happens in cycle "cycles", everything before it is idle
+    uint64_t idle_cycles = cycles - 1;
+
+    // keep drawing the core traversal order so that it stays the same after the skip
+    if (NUM_CPUS > 1) {
+        for (uint64_t c=0; c<idle_cycles; c++)
+            for (uint32_t i=0; i<NUM_CPUS; i++)
+                get_next_cpu();
+    }
+
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        ooo_cpu[i].skip_cycles(idle_cycles);
+    uncore.cycle += idle_cycles;
+    uncore.LLC.cycle += idle_cycles;
+
+    skipped_cycles += idle_cycles;
+}
+
+// a quantum of a core on its worker thread
+void simulate_core_quantum(uint32_t cpu, uint64_t cycles)
+{
+    for (uint64_t c=0; c<cycles; c++) {
+        simulate_core_cycle(cpu);
+        parallel_finished_cycle[cpu].store(current_core_cycle[cpu], std::memory_order_release);
+    }
+}
+
+// a core retires at most RETIRE_WIDTH instructions a cycle, so within this many cycles it cannot reach
+// its next heartbeat, end of warmup or end of simulation, which check_core_progress looks for between quanta
+uint64_t cycles_to_next_milestone(uint32_t i)
+{
+    uint64_t instrs = UINT64_MAX;
+    if (show_heartbeat && (ooo_cpu[i].next_print_instruction > ooo_cpu[i].num_retired))
+        instrs = ooo_cpu[i].next_print_instruction - ooo_cpu[i].num_retired;
+    if (warmup_complete[i] == 0)
+        instrs = min(instrs, knob::warmup_instructions + 1 - ooo_cpu[i].num_retired);
+    else if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0))
+        instrs = min(instrs, ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions - ooo_cpu[i].num_retired);
+
+    return (instrs <= RETIRE_WIDTH) ? 1 : ((instrs - 1) / RETIRE_WIDTH + 1);
+}
+
+void run_parallel_simulation()
+{
+    UNCORE_PORT port[NUM_CPUS];
+    CORE_THREADS threads;
+    uint32_t order[NUM_CPUS];
+    uint64_t quantum = knob::parallel_quantum, start_cycle[NUM_CPUS];
+
+    if (quantum == 0) {
+        cerr << "*** parallel_quantum has to be at least one cycle ***" << endl;
+        assert(0);
+    }
+
+    // the L2Cs reach the LLC through their ports while the cores run on their own threads
+    for (uint32_t i=0; i<NUM_CPUS; i++) {
+        port[i].cpu = i;
+        port[i].llc = &uncore.LLC;
+        ooo_cpu[i].L2C.lower_level = &port[i];
+        parallel_finished_cycle[i].store(current_core_cycle[i]);
+    }
+    parallel_deterministic = (quantum == 1);
+    parallel_running = true;
+    threads.start(simulate_core_quantum);
+
+    uint8_t run_simulation = 1;
+    while (run_simulation) {
+
+        // the traversal order decides which core goes first to the page table and the LLC
+        for (uint32_t index=0; index<NUM_CPUS; index++) {
+            order[index] = get_next_cpu();
+            parallel_position[order[index]] = index;
+        }
+        // shorten the quantum so that no core runs past one of its milestones
+        uint64_t cycles = quantum;
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            port[i].grant((i + uncore.cycle) % NUM_CPUS, NUM_CPUS);
+            start_cycle[i] = current_core_cycle[i];
+            cycles = min(cycles, cycles_to_next_milestone(i));
+            ooo_cpu[i].trace_reader->defer_repeats = 1;
+        }
+
+        threads.run(cycles);
+
+        // the cores leave their output to this thread so that it does not interleave
+        for (uint32_t index=0; index<NUM_CPUS; index++) {
+            ooo_cpu[order[index]].trace_reader->defer_repeats = 0;
+            ooo_cpu[order[index]].trace_reader->report_repeats();
+            check_core_progress(order[index]);
+        }
+        if (all_simulation_complete == NUM_CPUS)
+            run_simulation = 0;
+
+        // the uncore catches up cycle by cycle, with the core clocks of each of those cycles
+        for (uint64_t c=1; c<=cycles; c++) {
+            for (uint32_t i=0; i<NUM_CPUS; i++)
+                current_core_cycle[i] = start_cycle[i] + c;
+            for (uint32_t index=0; index<NUM_CPUS; index++)
+                port[order[index]].drain(current_core_cycle[order[index]]);
+
+            operate_uncore();
+        }
+
+        if (knob::cycle_skipping && run_simulation)
+            skip_idle_cycles();
+    }
+
+    threads.stop();
+    parallel_running = false;
+    for (uint32_t i=0; i<NUM_CPUS; i++)
+        ooo_cpu[i].L2C.lower_level = &uncore.LLC;
+}
+
+void print_banner()
+{
+    cout << "*************************************************" << endl
+         << "   ChampSim Multicore Out-of-Order Simulator" << endl
+         << "   Last compiled: " << __DATE__ << " " << __TIME__ << endl
+         << "*************************************************" << endl;
+}
+
 int main(int argc, char** argv)
 {
    for(uint32_t index = 0; index < NUM_CPUS; ++index) generated[index] = false;
@@ -615,16 +967,18 @@ int main(int argc, char** argv)
 	sigIntHandler.sa_flags = 0;
 	sigaction(SIGINT, &sigIntHandler, NULL);
 
-    cout << "*************************************************" << endl
-         << "   ChampSim Multicore Out-of-Order Simulator" << endl
-         << "   Last compiled: " << __DATE__ << " " << __TIME__ << endl
-         << "*************************************************" << endl;
+    print_banner();
 
     // initialize knobs
-    uint8_t show_heartbeat = 1;
-
     parse_args(argc, argv);
 
+    // every job of a batch continues from here in a process of its own, with its own arguments
+    if (knob::batch_jobs.size()) {
+        run_batch(argc, argv);
+        print_banner();
+        parse_args(argc, argv);
+    }
+
     uint32_t seed_number = 0;
 
     if(knob::knob_cloudsuite)
@@ -659,8 +1013,7 @@ int main(int argc, char** argv)
 
             sprintf(ooo_cpu[count_traces].trace_string, "%s", argv[i]);
 
-            char *full_name = ooo_cpu[count_traces].trace_string,
-                 *last_dot = strrchr(ooo_cpu[count_traces].trace_string, '.');
+            char *full_name = ooo_cpu[count_traces].trace_string;
 
 			ifstream test_file(full_name);
 			if(!test_file.good()){
@@ -668,16 +1021,6 @@ int main(int argc, char** argv)
 				assert(false);
 			}
 
-
-            if (full_name[last_dot - full_name + 1] == 'g') // gzip format
-                sprintf(ooo_cpu[count_traces].gunzip_command, "gunzip -c %s", argv[i]);
-            else if (full_name[last_dot - full_name + 1] == 'x') // xz
-                sprintf(ooo_cpu[count_traces].gunzip_command, "xz -dc %s", argv[i]);
-            else {
-                cout << "ChampSim does not support traces other than gz or xz compression!" << endl;
-                assert(0);
-            }
-
             char *pch[100];
             int count_str = 0;
             pch[0] = strtok (argv[i], " /,.-");
@@ -697,11 +1040,8 @@ int main(int argc, char** argv)
                 j++;
             }
 
-            ooo_cpu[count_traces].trace_file = popen(ooo_cpu[count_traces].gunzip_command, "r");
-            if (ooo_cpu[count_traces].trace_file == NULL) {
-                printf("\n*** Trace file not found: %s ***\n\n", argv[i]);
-                assert(0);
-            }
+            // gzip, xz and zstd traces are decompressed in-process on a background thread
+            ooo_cpu[count_traces].trace_reader = open_trace_reader(count_traces, full_name, knob::knob_cloudsuite);
 
             count_traces++;
             if (count_traces > NUM_CPUS) {
@@ -723,6 +1063,21 @@ int main(int argc, char** argv)
     // TODO: can we initialize these variables from the class constructor?
     srand(seed_number);
     champsim_seed = seed_number;
+
+    // core widths and buffer sizes, the processed queues of the caches are sized with the ROB
+    FETCH_WIDTH = knob::fetch_width;
+    DECODE_WIDTH = knob::decode_width;
+    EXEC_WIDTH = knob::exec_width;
+    LQ_WIDTH = knob::lq_width;
+    SQ_WIDTH = knob::sq_width;
+    RETIRE_WIDTH = knob::retire_width;
+    SCHEDULER_SIZE = knob::scheduler_size;
+    BRANCH_MISPREDICT_PENALTY = knob::branch_mispredict_penalty;
+    ROB_SIZE = knob::rob_size;
+    LQ_SIZE = knob::lq_size;
+    SQ_SIZE = knob::sq_size;
+
+    uncore.LLC.set_geometry(knob::llc_set, knob::llc_way, knob::llc_wq_size, knob::llc_rq_size, knob::llc_pq_size, knob::llc_mshr_size);
     for (int i=0; i<NUM_CPUS; i++) {
 
         ooo_cpu[i].cpu = i;
@@ -732,8 +1087,17 @@ int main(int argc, char** argv)
         ooo_cpu[i].begin_sim_instr = knob::warmup_instructions;
 
         // ROB
+        ooo_cpu[i].allocate_buffers();
         ooo_cpu[i].ROB.cpu = i;
 
+        // cache and TLB geometry
+        ooo_cpu[i].ITLB.set_geometry(knob::itlb_set, knob::itlb_way, knob::itlb_wq_size, knob::itlb_rq_size, knob::itlb_pq_size, knob::itlb_mshr_size);
+        ooo_cpu[i].DTLB.set_geometry(knob::dtlb_set, knob::dtlb_way, knob::dtlb_wq_size, knob::dtlb_rq_size, knob::dtlb_pq_size, knob::dtlb_mshr_size);
+        ooo_cpu[i].STLB.set_geometry(knob::stlb_set, knob::stlb_way, knob::stlb_wq_size, knob::stlb_rq_size, knob::stlb_pq_size, knob::stlb_mshr_size);
+        ooo_cpu[i].L1I.set_geometry(knob::l1i_set, knob::l1i_way, knob::l1i_wq_size, knob::l1i_rq_size, knob::l1i_pq_size, knob::l1i_mshr_size);
+        ooo_cpu[i].L1D.set_geometry(knob::l1d_set, knob::l1d_way, knob::l1d_wq_size, knob::l1d_rq_size, knob::l1d_pq_size, knob::l1d_mshr_size);
+        ooo_cpu[i].L2C.set_geometry(knob::l2c_set, knob::l2c_way, knob::l2c_wq_size, knob::l2c_rq_size, knob::l2c_pq_size, knob::l2c_mshr_size);
+
         // BRANCH PREDICTOR
         ooo_cpu[i].initialize_branch_predictor();
 
@@ -804,7 +1168,7 @@ int main(int argc, char** argv)
 
         previous_ppage = 0;
         num_adjacent_page = 0;
-        num_cl[i] = 0;
+        unique_cl[i].initialize(knob::approximate_footprint);
         allocated_pages = 0;
         num_page[i] = 0;
         minor_fault[i] = 0;
@@ -816,170 +1180,60 @@ int main(int argc, char** argv)
 
     print_knobs();
 
-    // simulation entry point
-    generator.seed(champsim_seed);
-    start_time = time(NULL);
-    uint8_t run_simulation = 1;
-    while (run_simulation) {
-
-        uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
-                 elapsed_minute = elapsed_second / 60,
-                 elapsed_hour = elapsed_minute / 60;
-        elapsed_minute -= elapsed_hour*60;
-        elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
-
-        for (int index = 0; index < NUM_CPUS; ++index) {
-	    /* randomizes CPU traversal to improve QoS for high-core simulations */
-	    int i = get_next_cpu();
-	    // cout << "Next cpu: " << i << endl;
-
-            // proceed one cycle
-            current_core_cycle[i]++;
-
-            /* monitor IPC */
-            if(knob::measure_ipc && current_core_cycle[i] >= ooo_cpu[i].next_measure_ipc_cycle)
-            {
-                uint64_t ins_in_epoch = ooo_cpu[i].num_retired - ooo_cpu[i].last_num_ins;
-                if(ins_in_epoch >= ooo_cpu[i].last_ins_in_epoch)
-                {
-                    /* IPC increased */
-                    // MYLOG("Core-%u cycle %lu last_num_ins %lu last_ins_in_epoch %lu ins_in_epoch %lu UP", i, current_core_cycle[i], ooo_cpu[i].last_num_ins, ooo_cpu[i].last_ins_in_epoch, ins_in_epoch);
-                    ooo_cpu[i].broadcast_ipc(1);
-                }
-                else
-                {
-                    /* IPC decreased */
-                    // MYLOG("Core-%u cycle %lu last_num_ins %lu last_ins_in_epoch %lu ins_in_epoch %lu DOWN", i, current_core_cycle[i], ooo_cpu[i].last_num_ins, ooo_cpu[i].last_ins_in_epoch, ins_in_epoch);
-                    ooo_cpu[i].broadcast_ipc(0);
-                }
-                ooo_cpu[i].last_num_ins = ooo_cpu[i].num_retired;
-                ooo_cpu[i].last_ins_in_epoch = ins_in_epoch;
-                ooo_cpu[i].next_measure_ipc_cycle = current_core_cycle[i] + knob::measure_ipc_epoch;
-            }
-
-            //cout << "Trying to process instr_id: " << ooo_cpu[i].instr_unique_id << " fetch_stall: " << +ooo_cpu[i].fetch_stall;
-            //cout << " stall_cycle: " << stall_cycle[i] << " current: " << current_core_cycle[i] << endl;
-
-            // core might be stalled due to page fault or branch misprediction
-            if (stall_cycle[i] <= current_core_cycle[i]) {
-
-                // fetch unit
-                if (ooo_cpu[i].ROB.occupancy < ooo_cpu[i].ROB.SIZE) {
-                    // handle branch
-                    if (ooo_cpu[i].fetch_stall == 0)
-                        ooo_cpu[i].handle_branch();
-                }
-
-                // fetch
-                ooo_cpu[i].fetch_instruction();
-
-
-                // schedule (including decode latency)
-                uint32_t schedule_index = ooo_cpu[i].ROB.next_schedule;
-                if ((ooo_cpu[i].ROB.entry[schedule_index].scheduled == 0) && (ooo_cpu[i].ROB.entry[schedule_index].event_cycle <= current_core_cycle[i]))
-                    ooo_cpu[i].schedule_instruction();
-
-                // execute
-                ooo_cpu[i].execute_instruction();
+    // restore the warmed state and the trace positions of a previous run
+    if (knob::load_checkpoint.size())
+        checkpoint_simulator(knob::load_checkpoint.c_str(), 1);
 
-                // memory operation
-                ooo_cpu[i].schedule_memory_instruction();
-                ooo_cpu[i].execute_memory_instruction();
-
-                // complete
-                ooo_cpu[i].update_rob();
-
-                // retire
-                if ((ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].executed == COMPLETED) && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle <= current_core_cycle[i]))
-                    ooo_cpu[i].retire_rob();
-            }
-
-            // heartbeat information
-            if (show_heartbeat && (ooo_cpu[i].num_retired >= ooo_cpu[i].next_print_instruction)) {
-                float cumulative_ipc;
-                if (warmup_complete[i])
-                    cumulative_ipc = (1.0*(ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr)) / (current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle);
-                else
-                    cumulative_ipc = (1.0*ooo_cpu[i].num_retired) / current_core_cycle[i];
-                float heartbeat_ipc = (1.0*ooo_cpu[i].num_retired - ooo_cpu[i].last_sim_instr) / (current_core_cycle[i] - ooo_cpu[i].last_sim_cycle);
-
-                cout << "Heartbeat CPU " << setw(2) << i << " instructions: " << setw(10) << ooo_cpu[i].num_retired << " cycles: " << setw(10) << current_core_cycle[i];
-                cout << " heartbeat IPC: " << FIXED_FLOAT(heartbeat_ipc) << " cumulative IPC: " << FIXED_FLOAT(cumulative_ipc);
-                cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
-                ooo_cpu[i].next_print_instruction += STAT_PRINTING_PERIOD;
+    // fast-forward every trace to the region of interest without timing simulation,
+    // either by seeking in the trace or by functionally warming the core, the caches and the TLBs
+    start_time = time(NULL);
+    for (int i=0; i<NUM_CPUS; i++) {
+        uint64_t seek_instructions = ooo_cpu[i].trace_offset;
+        if (!knob::functional_warming)
+            seek_instructions += knob::skip_instructions;
 
-                ooo_cpu[i].last_sim_instr = ooo_cpu[i].num_retired;
-                ooo_cpu[i].last_sim_cycle = current_core_cycle[i];
-            }
+        ooo_cpu[i].trace_reader->skip(seek_instructions);
+        ooo_cpu[i].trace_reader->start();
+        ooo_cpu[i].trace_offset += knob::skip_instructions;
+    }
+    if (knob::functional_warming) {
+        // interleave the cores so that they share the LLC as they would in the timing model
+        for (uint64_t n=0; n<knob::skip_instructions; n++) {
+            for (int i=0; i<NUM_CPUS; i++)
+                ooo_cpu[i].warm_instruction();
+        }
+        for (int i=0; i<NUM_CPUS; i++)
+            stall_cycle[i] = 0;
+    }
+    if (knob::skip_instructions) {
+        uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time);
+        cout << "Skipped " << knob::skip_instructions << " instructions per core (Simulation time: " << elapsed_second << " sec)" << endl << endl;
+    }
 
-            // check for deadlock
-            if (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].ip && (ooo_cpu[i].ROB.entry[ooo_cpu[i].ROB.head].event_cycle + DEADLOCK_CYCLE) <= current_core_cycle[i])
-                print_deadlock(i);
+    // simulation entry point
+    generator.seed(champsim_seed);
+    start_time = time(NULL);
+    if (knob::parallel_simulation && (NUM_CPUS > 1))
+        run_parallel_simulation();
+    else {
+        uint8_t run_simulation = 1;
+        while (run_simulation) {
+            for (int index = 0; index < NUM_CPUS; ++index) {
+                /* randomizes CPU traversal to improve QoS for high-core simulations */
+                int i = get_next_cpu();
 
-            // check for warmup
-            // warmup complete
-            if ((warmup_complete[i] == 0) && (ooo_cpu[i].num_retired > knob::warmup_instructions)) {
-                warmup_complete[i] = 1;
-                all_warmup_complete++;
-            }
-            if (all_warmup_complete == NUM_CPUS) { // this part is called only once when all cores are warmed up
-                all_warmup_complete++;
-                finish_warmup();
-            }
+                simulate_core_cycle(i);
+                check_core_progress(i);
 
-            /*
-            if (all_warmup_complete == 0) {
-                all_warmup_complete = 1;
-                finish_warmup();
-            }
-            if (ooo_cpu[1].num_retired > 0)
-                warmup_complete[1] = 1;
-            */
-
-            // simulation complete
-            if ((all_warmup_complete > NUM_CPUS) && (simulation_complete[i] == 0) && (ooo_cpu[i].num_retired >= (ooo_cpu[i].begin_sim_instr + ooo_cpu[i].simulation_instructions))) {
-                simulation_complete[i] = 1;
-                ooo_cpu[i].finish_sim_instr = ooo_cpu[i].num_retired - ooo_cpu[i].begin_sim_instr;
-                ooo_cpu[i].finish_sim_cycle = current_core_cycle[i] - ooo_cpu[i].begin_sim_cycle;
-
-                cout << "Finished CPU " << i << " instructions: " << ooo_cpu[i].finish_sim_instr << " cycles: " << ooo_cpu[i].finish_sim_cycle;
-                cout << " cumulative IPC: " << ((float) ooo_cpu[i].finish_sim_instr / ooo_cpu[i].finish_sim_cycle);
-                cout << " (Simulation time: " << elapsed_hour << " hr " << elapsed_minute << " min " << elapsed_second << " sec) " << endl;
-
-                record_roi_stats(i, &ooo_cpu[i].L1D);
-                record_roi_stats(i, &ooo_cpu[i].L1I);
-                record_roi_stats(i, &ooo_cpu[i].L2C);
-                record_roi_stats(i, &uncore.LLC);
-
-                all_simulation_complete++;
+                if (all_simulation_complete == NUM_CPUS)
+                    run_simulation = 0;
             }
 
-            if (all_simulation_complete == NUM_CPUS)
-                run_simulation = 0;
-        }
-	// cout << "-----------------" << endl;
+            operate_uncore();
 
-        // TODO: should it be backward?
-        uncore.cycle++;
-        if(knob::measure_dram_bw && uncore.cycle >= uncore.DRAM.next_bw_measure_cycle)
-        {
-            uint64_t this_epoch_enqueue_count = uncore.DRAM.rq_enqueue_count - uncore.DRAM.last_enqueue_count;
-            uncore.DRAM.epoch_enqueue_count = (uncore.DRAM.epoch_enqueue_count/2) + this_epoch_enqueue_count;
-            uint32_t quartile = ((float)100*uncore.DRAM.epoch_enqueue_count)/DRAM_DBUS_MAX_CAS;
-            if(quartile <= 25)      uncore.DRAM.bw = 0;
-            else if(quartile <= 50) uncore.DRAM.bw = 1;
-            else if(quartile <= 75) uncore.DRAM.bw = 2;
-            else                    uncore.DRAM.bw = 3;
-            MYLOG("cycle %lu rq_enqueue_count %lu last_enqueue_count %lu epoch_enqueue_count %lu QUARTILE %u", uncore.cycle, uncore.DRAM.rq_enqueue_count, uncore.DRAM.last_enqueue_count, uncore.DRAM.epoch_enqueue_count, uncore.DRAM.bw);
-            uncore.DRAM.last_enqueue_count = uncore.DRAM.rq_enqueue_count;
-            uncore.DRAM.next_bw_measure_cycle = uncore.cycle + knob::measure_dram_bw_epoch;
-            uncore.DRAM.total_bw_epochs++;
-            uncore.DRAM.bw_level_hist[uncore.DRAM.bw]++;
-            uncore.LLC.broadcast_bw(uncore.DRAM.bw);
+            if (knob::cycle_skipping && run_simulation)
+                skip_idle_cycles();
         }
-
-        uncore.LLC.operate();
-        uncore.DRAM.operate();
     }
 
     uint64_t elapsed_second = (uint64_t)(time(NULL) - start_time),
@@ -989,6 +1243,8 @@ int main(int argc, char** argv)
     elapsed_second -= (elapsed_hour*3600 + elapsed_minute*60);
 
     cout << endl << "ChampSim completed all CPUs" << endl;
+    if (knob::cycle_skipping)
+        cout << "Skipped idle cycles: " << skipped_cycles << endl;
     if (NUM_CPUS > 1) {
 //         cout << endl << "Total Simulation Statistics (not including warmup)" << endl;
 //         for (uint32_t i=0; i<NUM_CPUS; i++) {
@@ -1022,6 +1278,7 @@ int main(int argc, char** argv)
         print_roi_stats(i, &uncore.LLC);
         cout << "Core_" << i << "_major_page_fault " << major_fault[i] << endl
             << "Core_" << i << "_minor_page_fault " << minor_fault[i] << endl
+            << "Core_" << i << "_unique_cache_lines " << unique_cl[i].count() << endl
             << endl;
     }
 
@@ -3,6 +3,9 @@
 namespace knob
 {
 	extern bool knob_cloudsuite;
+	extern bool measure_ipc;
+	extern uint32_t scheduling_latency;
+	extern uint32_t exec_latency;
 }
 
 const char* GetAccessType(uint8_t type)
@@ -18,6 +21,9 @@ const char* GetAccessType(uint8_t type)
 O3_CPU ooo_cpu[NUM_CPUS]; 
 uint64_t current_core_cycle[NUM_CPUS], stall_cycle[NUM_CPUS];
 uint32_t SCHEDULING_LATENCY = 0, EXEC_LATENCY = 0;
+uint32_t FETCH_WIDTH = 0, DECODE_WIDTH = 0, EXEC_WIDTH = 0, LQ_WIDTH = 0, SQ_WIDTH = 0, RETIRE_WIDTH = 0,
+         SCHEDULER_SIZE = 0, BRANCH_MISPREDICT_PENALTY = 0;
+uint32_t ROB_SIZE = 0, LQ_SIZE = 0, SQ_SIZE = 0;
 
 void print_core_config()
 {
@@ -29,6 +35,8 @@ void print_core_config()
         << "retire_width " << RETIRE_WIDTH << endl
         << "scheduler_size " << SCHEDULER_SIZE << endl
         << "branch_mispredict_penalty " << BRANCH_MISPREDICT_PENALTY << endl
+        << "scheduling_latency " << knob::scheduling_latency << endl
+        << "exec_latency " << knob::exec_latency << endl
         << "rob_size " << ROB_SIZE << endl
         << "lq_size " << LQ_SIZE << endl
         << "sq_size " << SQ_SIZE << endl
@@ -43,6 +51,72 @@ void O3_CPU::initialize_core()
 
 }
 
+void O3_CPU::allocate_buffers()
+{
+    // the dependency sets of instructions and packets (fastset) hold indices below MAX_SIZE
+    if ((ROB_SIZE == 0) || (ROB_SIZE > MAX_SIZE) || (LQ_SIZE == 0) || (LQ_SIZE > MAX_SIZE) || (SQ_SIZE == 0) || (SQ_SIZE > MAX_SIZE)) {
+        cerr << "rob_size " << ROB_SIZE << " lq_size " << LQ_SIZE << " sq_size " << SQ_SIZE << ", every size must be between 1 and " << MAX_SIZE << " ***" << endl;
+        assert(0);
+    }
+
+    ROB.resize(ROB_SIZE);
+    LQ.resize(LQ_SIZE);
+    SQ.resize(SQ_SIZE);
+
+    delete[] STA;
+    STA = new uint64_t[STA_SIZE];
+    for (uint32_t i=0; i<STA_SIZE; i++)
+        STA[i] = UINT64_MAX;
+    STA_head = 0;
+    STA_tail = 0;
+
+    delete[] RTE0;
+    delete[] RTE1;
+    RTE0 = new uint32_t[ROB_SIZE];
+    RTE1 = new uint32_t[ROB_SIZE];
+    for (uint32_t i=0; i<ROB_SIZE; i++) {
+        RTE0[i] = ROB_SIZE;
+        RTE1[i] = ROB_SIZE;
+    }
+    RTE0_head = 0;
+    RTE1_head = 0;
+    RTE0_tail = 0;
+    RTE1_tail = 0;
+
+    delete[] RTL0;
+    delete[] RTL1;
+    RTL0 = new uint32_t[LQ_SIZE];
+    RTL1 = new uint32_t[LQ_SIZE];
+    for (uint32_t i=0; i<LQ_SIZE; i++) {
+        RTL0[i] = LQ_SIZE;
+        RTL1[i] = LQ_SIZE;
+    }
+    RTL0_head = 0;
+    RTL1_head = 0;
+    RTL0_tail = 0;
+    RTL1_tail = 0;
+
+    delete[] RTS0;
+    delete[] RTS1;
+    RTS0 = new uint32_t[SQ_SIZE];
+    RTS1 = new uint32_t[SQ_SIZE];
+    for (uint32_t i=0; i<SQ_SIZE; i++) {
+        RTS0[i] = SQ_SIZE;
+        RTS1[i] = SQ_SIZE;
+    }
+    RTS0_head = 0;
+    RTS1_head = 0;
+    RTS0_tail = 0;
+    RTS1_tail = 0;
+
+    delete[] older_writer;
+    delete[] younger_writer;
+    older_writer = new uint32_t[ROB_SIZE][NUM_INSTR_DESTINATIONS_SPARC];
+    younger_writer = new uint32_t[ROB_SIZE][NUM_INSTR_DESTINATIONS_SPARC];
+    for (uint32_t i=0; i<NUM_ARCH_REGISTERS; i++)
+        reg_writer[i] = ROB_SIZE;
+}
+
 void O3_CPU::handle_branch()
 {
     // actual processors do not work like this but for easier implementation,
@@ -56,278 +130,154 @@ void O3_CPU::handle_branch()
     // first, read PIN trace
     while (continue_reading) {
 
-        size_t instr_size = knob::knob_cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
-
-        if (knob::knob_cloudsuite) {
-            if (!fread(&current_cloudsuite_instr, instr_size, 1, trace_file)) {
-                // reached end of file for this trace
-                cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
-
-                // close the trace file and re-open it
-                pclose(trace_file);
-                trace_file = popen(gunzip_command, "r");
-                if (trace_file == NULL) {
-                    cerr << endl << "*** CANNOT REOPEN TRACE FILE: " << trace_string << " ***" << endl;
-                    assert(0);
-                }
-            } else { // successfully read the trace
-
-                // copy the instruction into the performance model's instruction format
-                ooo_model_instr arch_instr;
-                int num_reg_ops = 0, num_mem_ops = 0;
-
-                arch_instr.instr_id = instr_unique_id;
-                arch_instr.ip = current_cloudsuite_instr.ip;
-                arch_instr.is_branch = current_cloudsuite_instr.is_branch;
-                arch_instr.branch_taken = current_cloudsuite_instr.branch_taken;
-
-                arch_instr.asid[0] = current_cloudsuite_instr.asid[0];
-                arch_instr.asid[1] = current_cloudsuite_instr.asid[1];
+        // the trace reader has already copied the instruction into the performance model's instruction format
+        ooo_model_instr &arch_instr = *trace_reader->next_instr();
+        arch_instr.instr_id = instr_unique_id;
 
-                for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-                    arch_instr.destination_registers[i] = current_cloudsuite_instr.destination_registers[i];
-                    arch_instr.destination_memory[i] = current_cloudsuite_instr.destination_memory[i];
-                    arch_instr.destination_virtual_address[i] = current_cloudsuite_instr.destination_memory[i];
-
-                    if (arch_instr.destination_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.destination_memory[i]) {
-                        num_mem_ops++;
+        for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+            if (arch_instr.destination_memory[i]) {
 
-                        // update STA, this structure is required to execute store instructios properly without deadlock
-                        if (num_mem_ops > 0) {
+                // update STA, this structure is required to execute store instructios properly without deadlock
 #ifdef SANITY_CHECK
-                            if (STA[STA_tail] < UINT64_MAX) {
-                                if (STA_head != STA_tail)
-                                    assert(0);
-                            }
-#endif
-                            STA[STA_tail] = instr_unique_id;
-                            STA_tail++;
-
-                            if (STA_tail == STA_SIZE)
-                                STA_tail = 0;
-                        }
-                    }
-                }
-
-                for (int i=0; i<NUM_INSTR_SOURCES; i++) {
-                    arch_instr.source_registers[i] = current_cloudsuite_instr.source_registers[i];
-                    arch_instr.source_memory[i] = current_cloudsuite_instr.source_memory[i];
-                    arch_instr.source_virtual_address[i] = current_cloudsuite_instr.source_memory[i];
-
-                    if (arch_instr.source_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.source_memory[i])
-                        num_mem_ops++;
+                if (STA[STA_tail] < UINT64_MAX) {
+                    if (STA_head != STA_tail)
+                        assert(0);
                 }
+#endif
+                STA[STA_tail] = instr_unique_id;
+                STA_tail++;
 
-                arch_instr.num_reg_ops = num_reg_ops;
-                arch_instr.num_mem_ops = num_mem_ops;
-                if (num_mem_ops > 0) 
-                    arch_instr.is_memory = 1;
-
-                // virtually add this instruction to the ROB
-                if (ROB.occupancy < ROB.SIZE) {
-                    uint32_t rob_index = add_to_rob(&arch_instr);
-                    num_reads++;
-
-                    // branch prediction
-                    if (arch_instr.is_branch) {
+                if (STA_tail == STA_SIZE)
+                    STA_tail = 0;
+            }
+        }
 
-                        DP( if (warmup_complete[cpu]) {
-                        cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
+        // virtually add this instruction to the ROB
+        if (ROB.occupancy < ROB.SIZE) {
+            uint32_t rob_index = add_to_rob(&arch_instr);
+            num_reads++;
 
-                        num_branch++;
+            // branch prediction
+            if (arch_instr.is_branch) {
 
-                        /*
-                        uint8_t branch_prediction;
-                        // for faster simulation, force perfect prediction during the warmup
-                        // note that branch predictor is still learning with real branch results
-                        if (all_warmup_complete == 0)
-                            branch_prediction = arch_instr.branch_taken; 
-                        else
-                            branch_prediction = predict_branch(arch_instr.ip);
-                        */
-                        uint8_t branch_prediction = predict_branch(arch_instr.ip);
-                        
-                        if (arch_instr.branch_taken != branch_prediction) {
-   			    //if(false) { // this simulates perfect branch prediction			  
-                            branch_mispredictions++;
+                DP( if (warmup_complete[cpu]) {
+                cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
 
-			    total_rob_occupancy_at_branch_mispredict +=	ROB.occupancy;
+                num_branch++;
 
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] MISPREDICTED instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
+                /*
+                uint8_t branch_prediction;
+                // for faster simulation, force perfect prediction during the warmup
+                // note that branch predictor is still learning with real branch results
+                if (all_warmup_complete == 0)
+                    branch_prediction = arch_instr.branch_taken; 
+                else
+                    branch_prediction = predict_branch(arch_instr.ip);
+                */
+                uint8_t branch_prediction = predict_branch(arch_instr.ip);
+                
+                if (arch_instr.branch_taken != branch_prediction) {
+                    //if(false) { // this simulates perfect branch prediction
+                    branch_mispredictions++;
 
-                            // halt any further fetch this cycle
-                            instrs_to_read_this_cycle = 0;
+                    total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
 
-                            // and stall any additional fetches until the branch is executed
-                            fetch_stall = 1; 
+                    DP( if (warmup_complete[cpu]) {
+                    cout << "[BRANCH] MISPREDICTED instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
+                    cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
 
-                            ROB.entry[rob_index].branch_mispredicted = 1;
-                        }
-                        else {
-                            if (branch_prediction == 1) {
-                                // if we are accurately predicting a branch to be taken, then we can't possibly fetch down that path this cycle,
-                                // so we have to wait until the next cycle to fetch those
-                                instrs_to_read_this_cycle = 0;
-                            }
-
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] PREDICTED    instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
-                        }
+                    // halt any further fetch this cycle
+                    instrs_to_read_this_cycle = 0;
 
-                        last_branch_result(arch_instr.ip, arch_instr.branch_taken);
-                    }
+                    // and stall any additional fetches until the branch is executed
+                    fetch_stall = 1; 
 
-                    //if ((num_reads == FETCH_WIDTH) || (ROB.occupancy == ROB.SIZE))
-                    if ((num_reads >= instrs_to_read_this_cycle) || (ROB.occupancy == ROB.SIZE))
-                        continue_reading = 0;
-                }
-                instr_unique_id++;
-            }
-        }
-	else
-	  {
-            if (!fread(&current_instr, instr_size, 1, trace_file)) {
-                // reached end of file for this trace
-                cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl; 
-
-                // close the trace file and re-open it
-                pclose(trace_file);
-                trace_file = popen(gunzip_command, "r");
-                if (trace_file == NULL) {
-                    cerr << endl << "*** CANNOT REOPEN TRACE FILE: " << trace_string << " ***" << endl;
-                    assert(0);
+                    ROB.entry[rob_index].branch_mispredicted = 1;
                 }
-            } else { // successfully read the trace
-
-                // copy the instruction into the performance model's instruction format
-                ooo_model_instr arch_instr;
-                int num_reg_ops = 0, num_mem_ops = 0;
-
-                arch_instr.instr_id = instr_unique_id;
-                arch_instr.ip = current_instr.ip;
-                arch_instr.is_branch = current_instr.is_branch;
-                arch_instr.branch_taken = current_instr.branch_taken;
-
-                arch_instr.asid[0] = cpu;
-                arch_instr.asid[1] = cpu;
-
-                for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-                    arch_instr.destination_registers[i] = current_instr.destination_registers[i];
-                    arch_instr.destination_memory[i] = current_instr.destination_memory[i];
-                    arch_instr.destination_virtual_address[i] = current_instr.destination_memory[i];
-
-                    if (arch_instr.destination_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.destination_memory[i]) {
-                        num_mem_ops++;
-
-                        // update STA, this structure is required to execute store instructios properly without deadlock
-                        if (num_mem_ops > 0) {
-#ifdef SANITY_CHECK
-                            if (STA[STA_tail] < UINT64_MAX) {
-                                if (STA_head != STA_tail)
-                                    assert(0);
-                            }
-#endif
-                            STA[STA_tail] = instr_unique_id;
-                            STA_tail++;
-
-                            if (STA_tail == STA_SIZE)
-                                STA_tail = 0;
-                        }
+                else {
+                    if (branch_prediction == 1) {
+                        // if we are accurately predicting a branch to be taken, then we can't possibly fetch down that path this cycle,
+                        // so we have to wait until the next cycle to fetch those
+                        instrs_to_read_this_cycle = 0;
                     }
-                }
-
-                for (int i=0; i<NUM_INSTR_SOURCES; i++) {
-                    arch_instr.source_registers[i] = current_instr.source_registers[i];
-                    arch_instr.source_memory[i] = current_instr.source_memory[i];
-                    arch_instr.source_virtual_address[i] = current_instr.source_memory[i];
 
-                    if (arch_instr.source_registers[i])
-                        num_reg_ops++;
-                    if (arch_instr.source_memory[i])
-                        num_mem_ops++;
+                    DP( if (warmup_complete[cpu]) {
+                    cout << "[BRANCH] PREDICTED    instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
+                    cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
                 }
 
-                arch_instr.num_reg_ops = num_reg_ops;
-                arch_instr.num_mem_ops = num_mem_ops;
-                if (num_mem_ops > 0) 
-                    arch_instr.is_memory = 1;
-
-                // virtually add this instruction to the ROB
-                if (ROB.occupancy < ROB.SIZE) {
-                    uint32_t rob_index = add_to_rob(&arch_instr);
-                    num_reads++;
+                last_branch_result(arch_instr.ip, arch_instr.branch_taken);
+            }
 
-                    // branch prediction
-                    if (arch_instr.is_branch) {
+            //if ((num_reads == FETCH_WIDTH) || (ROB.occupancy == ROB.SIZE))
+            if ((num_reads >= instrs_to_read_this_cycle) || (ROB.occupancy == ROB.SIZE))
+                continue_reading = 0;
+        }
+        instr_unique_id++;
+    }
 
-                        DP( if (warmup_complete[cpu]) {
-                        cout << "[BRANCH] instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec << " taken: " << +arch_instr.branch_taken << endl; });
+    //instrs_to_fetch_this_cycle = num_reads;
+}
 
-                        num_branch++;
+void O3_CPU::warm_instruction()
+{
+    // functional warming while fast-forwarding: the next instruction trains the branch predictor and
+    // installs its translations and blocks in the TLBs and caches, without going through the pipeline
+    ooo_model_instr &arch_instr = *trace_reader->next_instr();
 
-                        /*
-                        uint8_t branch_prediction;
-                        // for faster simulation, force perfect prediction during the warmup
-                        // note that branch predictor is still learning with real branch results
-                        if (all_warmup_complete == 0)
-                            branch_prediction = arch_instr.branch_taken; 
-                        else
-                            branch_prediction = predict_branch(arch_instr.ip);
-                        */
-                        uint8_t branch_prediction = predict_branch(arch_instr.ip);
-                        
-                        if (arch_instr.branch_taken != branch_prediction) {
-			    //if(false) { // this simulates perfect branch prediction
-			    branch_mispredictions++;
+    if (arch_instr.is_branch) {
+        predict_branch(arch_instr.ip);
+        last_branch_result(arch_instr.ip, arch_instr.branch_taken);
+    }
 
-			    total_rob_occupancy_at_branch_mispredict += ROB.occupancy;
+    warm_access(arch_instr.ip, arch_instr.ip, 256 + arch_instr.asid[0], 1, LOAD);
 
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] MISPREDICTED instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
+    for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+        if (arch_instr.source_memory[i])
+            warm_access(arch_instr.ip, arch_instr.source_memory[i], arch_instr.asid[1], 0, LOAD);
+    }
 
-                            // halt any further fetch this cycle
-                            instrs_to_read_this_cycle = 0;
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        if (arch_instr.destination_memory[i])
+            warm_access(arch_instr.ip, arch_instr.destination_memory[i], arch_instr.asid[1], 0, RFO);
+    }
+}
 
-                            // and stall any additional fetches until the branch is executed
-                            fetch_stall = 1; 
+void O3_CPU::warm_access(uint64_t ip, uint64_t va, uint32_t asid, uint8_t instruction, uint8_t type)
+{
+    PACKET tlb_packet;
+    tlb_packet.instruction = instruction;
+    tlb_packet.tlb_access = 1;
+    tlb_packet.fill_level = FILL_L1;
+    tlb_packet.cpu = cpu;
+    if (knob::knob_cloudsuite)
+        tlb_packet.address = ((va >> LOG2_PAGE_SIZE) << 9) | asid;
+    else
+        tlb_packet.address = va >> LOG2_PAGE_SIZE;
+    tlb_packet.full_addr = va;
+    tlb_packet.ip = ip;
+    tlb_packet.type = type;
 
-                            ROB.entry[rob_index].branch_mispredicted = 1;
-                        }
-                        else {
-                            if (branch_prediction == 1) {
-                                // if we are accurately predicting a branch to be taken, then we can't possibly fetch down that path this cycle,
-                                // so we have to wait until the next cycle to fetch those
-                                instrs_to_read_this_cycle = 0;
-                            }
-
-                            DP( if (warmup_complete[cpu]) {
-                            cout << "[BRANCH] PREDICTED    instr_id: " << instr_unique_id << " ip: " << hex << arch_instr.ip << dec;
-                            cout << " taken: " << +arch_instr.branch_taken << " predicted: " << +branch_prediction << endl; });
-                        }
+    if (instruction)
+        ITLB.functional_access(&tlb_packet);
+    else
+        DTLB.functional_access(&tlb_packet);
 
-                        last_branch_result(arch_instr.ip, arch_instr.branch_taken);
-                    }
+    uint64_t pa = (tlb_packet.data << LOG2_PAGE_SIZE) | (va & ((1 << LOG2_PAGE_SIZE) - 1));
 
-                    //if ((num_reads == FETCH_WIDTH) || (ROB.occupancy == ROB.SIZE))
-                    if ((num_reads >= instrs_to_read_this_cycle) || (ROB.occupancy == ROB.SIZE))
-                        continue_reading = 0;
-                }
-                instr_unique_id++;
-            }
-        }
-    }
+    PACKET data_packet;
+    data_packet.instruction = instruction;
+    data_packet.fill_level = FILL_L1;
+    data_packet.cpu = cpu;
+    data_packet.address = pa >> LOG2_BLOCK_SIZE;
+    data_packet.full_addr = pa;
+    data_packet.ip = ip;
+    data_packet.type = type;
 
-    //instrs_to_fetch_this_cycle = num_reads;
+    if (instruction)
+        L1I.functional_access(&data_packet);
+    else
+        L1D.functional_access(&data_packet);
 }
 
 uint32_t O3_CPU::add_to_rob(ooo_model_instr *arch_instr)
@@ -550,38 +500,24 @@ void O3_CPU::schedule_instruction()
         return;
 
     // execution is out-of-order but we have an in-order scheduling algorithm to detect all RAW dependencies
-    uint32_t limit = ROB.next_fetch[1];
-    num_searched = 0;
-    if (ROB.head < limit) {
-        for (uint32_t i=ROB.head; i<limit; i++) { 
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                return;
-
-            if (ROB.entry[i].scheduled == 0)
-                do_scheduling(i);
-
-            num_searched++;
-        }
-    }
-    else {
-        for (uint32_t i=ROB.head; i<ROB.SIZE; i++) {
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                return;
+    // the walk starts at the head and stops at the end of the ROB array. Every entry before next_schedule
+    // is scheduled already, so the walk only gets past them if none of them has a later event_cycle
+    // and they do not fill the scheduler
+    if (ROB.next_schedule < ROB.head)
+        return;
 
-            if (ROB.entry[i].scheduled == 0)
-                do_scheduling(i);
+    num_searched = ROB.next_schedule - ROB.head;
+    if (num_searched && ((scheduled_event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE)))
+        return;
 
-            num_searched++;
-        }
-        for (uint32_t i=0; i<limit; i++) { 
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                return;
+    for (uint32_t i=ROB.next_schedule; i<ROB.SIZE; i++) {
+        if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
+            return;
 
-            if (ROB.entry[i].scheduled == 0)
-                do_scheduling(i);
+        if (ROB.entry[i].scheduled == 0)
+            do_scheduling(i);
 
-            num_searched++;
-        }
+        num_searched++;
     }
 }
 
@@ -590,10 +526,14 @@ void O3_CPU::do_scheduling(uint32_t rob_index)
     ROB.entry[rob_index].reg_ready = 1; // reg_ready will be reset to 0 if there is RAW dependency 
 
     reg_dependency(rob_index);
+    add_reg_writer(rob_index);
     ROB.next_schedule = (rob_index == (ROB.SIZE - 1)) ? 0 : (rob_index + 1);
 
-    if (ROB.entry[rob_index].is_memory)
+    if (ROB.entry[rob_index].is_memory) {
         ROB.entry[rob_index].scheduled = INFLIGHT;
+        if (ROB.entry[rob_index].reg_ready)
+            lsq_wait.set(rob_index);
+    }
     else {
         ROB.entry[rob_index].scheduled = COMPLETED;
 
@@ -602,6 +542,7 @@ void O3_CPU::do_scheduling(uint32_t rob_index)
             ROB.entry[rob_index].event_cycle = current_core_cycle[cpu] + SCHEDULING_LATENCY;
         else
             ROB.entry[rob_index].event_cycle += SCHEDULING_LATENCY;
+        scheduled_event_cycle = max(scheduled_event_cycle, ROB.entry[rob_index].event_cycle);
 
         if (ROB.entry[rob_index].reg_ready) {
 
@@ -640,61 +581,73 @@ void O3_CPU::reg_dependency(uint32_t rob_index)
         }
     } }); 
 
-    // check RAW dependency
-    int prior = rob_index - 1;
-    if (prior < 0)
-        prior = ROB.SIZE - 1;
-
-    if (rob_index != ROB.head) {
-        if ((int)ROB.head <= prior) {
-            for (int i=prior; i>=(int)ROB.head; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-        } else {
-            for (int i=prior; i>=0; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-            for (int i=ROB.SIZE-1; i>=(int)ROB.head; i--) if (ROB.entry[i].executed != COMPLETED) {
-		for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
-			if (ROB.entry[rob_index].source_registers[j] && (ROB.entry[rob_index].reg_RAW_checked[j] == 0))
-				reg_RAW_dependency(i, rob_index, j);
-		}
-	    }
-        }
+    // check RAW dependency: every source depends on the youngest older writer of its register that has not completed yet
+    for (uint32_t j=0; j<NUM_INSTR_SOURCES; j++) {
+        uint8_t reg = ROB.entry[rob_index].source_registers[j];
+        if (reg && (reg_writer[reg] != ROB_SIZE))
+            reg_RAW_dependency(reg_writer[reg], rob_index, j);
     }
 }
 
 void O3_CPU::reg_RAW_dependency(uint32_t prior, uint32_t current, uint32_t source_index)
 {
-    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
-        if (ROB.entry[prior].destination_registers[i] == 0)
-            continue;
+    // we need to mark this dependency in the ROB since the producer might not be added in the store queue yet
+    ROB.entry[prior].registers_instrs_depend_on_me.insert (current);   // this load cannot be executed until the prior store gets executed
+    ROB.entry[prior].registers_index_depend_on_me[source_index].insert (current);   // this load cannot be executed until the prior store gets executed
+    ROB.entry[prior].reg_RAW_producer = 1;
+
+    ROB.entry[current].reg_ready = 0;
+    ROB.entry[current].producer_id = ROB.entry[prior].instr_id; 
+    ROB.entry[current].num_reg_dependent++;
+
+    DP (if(warmup_complete[cpu]) {
+    cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[current].instr_id << " is_memory: " << +ROB.entry[current].is_memory;
+    cout << " RAW reg_index: " << +ROB.entry[current].source_registers[source_index];
+    cout << " producer_id: " << ROB.entry[prior].instr_id << endl; });
+}
 
-        if (ROB.entry[prior].destination_registers[i] == ROB.entry[current].source_registers[source_index]) {
+uint32_t O3_CPU::writer_slot(uint32_t rob_index, uint8_t reg)
+{
+    // an instruction that writes a register more than once is linked by its first destination
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        if (ROB.entry[rob_index].destination_registers[i] == reg)
+            return i;
+    }
+    return MAX_INSTR_DESTINATIONS;
+}
 
-            // we need to mark this dependency in the ROB since the producer might not be added in the store queue yet
-            ROB.entry[prior].registers_instrs_depend_on_me.insert (current);   // this load cannot be executed until the prior store gets executed
-            ROB.entry[prior].registers_index_depend_on_me[source_index].insert (current);   // this load cannot be executed until the prior store gets executed
-            ROB.entry[prior].reg_RAW_producer = 1;
+void O3_CPU::add_reg_writer(uint32_t rob_index)
+{
+    // instructions are scheduled in order, so a new writer is always the youngest one
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        uint8_t reg = ROB.entry[rob_index].destination_registers[i];
+        if ((reg == 0) || (writer_slot(rob_index, reg) != i))
+            continue;
 
-            ROB.entry[current].reg_ready = 0;
-            ROB.entry[current].producer_id = ROB.entry[prior].instr_id; 
-            ROB.entry[current].num_reg_dependent++;
-            ROB.entry[current].reg_RAW_checked[source_index] = 1;
+        uint32_t older = reg_writer[reg];
+        older_writer[rob_index][i] = older;
+        younger_writer[rob_index][i] = ROB_SIZE;
+        if (older != ROB_SIZE)
+            younger_writer[older][writer_slot(older, reg)] = rob_index;
+        reg_writer[reg] = rob_index;
+    }
+}
 
-            DP (if(warmup_complete[cpu]) {
-            cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[current].instr_id << " is_memory: " << +ROB.entry[current].is_memory;
-            cout << " RAW reg_index: " << +ROB.entry[current].source_registers[source_index];
-            cout << " producer_id: " << ROB.entry[prior].instr_id << endl; });
+void O3_CPU::remove_reg_writer(uint32_t rob_index)
+{
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        uint8_t reg = ROB.entry[rob_index].destination_registers[i];
+        if ((reg == 0) || (writer_slot(rob_index, reg) != i))
+            continue;
 
-            return;
-        }
+        uint32_t older = older_writer[rob_index][i],
+                 younger = younger_writer[rob_index][i];
+        if (older != ROB_SIZE)
+            younger_writer[older][writer_slot(older, reg)] = younger;
+        if (younger != ROB_SIZE)
+            older_writer[younger][writer_slot(younger, reg)] = older;
+        else
+            reg_writer[reg] = older;
     }
 }
 
@@ -768,8 +721,10 @@ void O3_CPU::do_execution(uint32_t rob_index)
             ROB.entry[rob_index].event_cycle = current_core_cycle[cpu] + EXEC_LATENCY;
         else
             ROB.entry[rob_index].event_cycle += EXEC_LATENCY;
+        scheduled_event_cycle = max(scheduled_event_cycle, ROB.entry[rob_index].event_cycle);
 
         inflight_reg_executions++;
+        check_completion(rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " non-memory instr_id: " << ROB.entry[rob_index].instr_id; 
@@ -779,49 +734,13 @@ void O3_CPU::do_execution(uint32_t rob_index)
 
 void O3_CPU::schedule_memory_instruction()
 {
-    if ((ROB.head == ROB.tail) && ROB.occupancy == 0)
-        return;
-
     // execution is out-of-order but we have an in-order scheduling algorithm to detect all RAW dependencies
-    uint32_t limit = ROB.next_schedule;
+    // memory instructions are added to the LSQ in program order, starting from the head
     num_searched = 0;
-    if (ROB.head < limit) {
-        for (uint32_t i=ROB.head; i<limit; i++) {
-
-            if (ROB.entry[i].is_memory == 0)
-                continue;
-
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                break;
-
-            if (ROB.entry[i].is_memory && ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
-                do_memory_scheduling(i);
-        }
-    }
-    else {
-        for (uint32_t i=ROB.head; i<ROB.SIZE; i++) {
-
-            if (ROB.entry[i].is_memory == 0)
-                continue;
-
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                break;
-
-            if (ROB.entry[i].is_memory && ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
-                do_memory_scheduling(i);
-        }
-        for (uint32_t i=0; i<limit; i++) {
-
-            if (ROB.entry[i].is_memory == 0)
-                continue;
-
-            if ((ROB.entry[i].fetched != COMPLETED) || (ROB.entry[i].event_cycle > current_core_cycle[cpu]) || (num_searched >= SCHEDULER_SIZE))
-                break;
-
-            if (ROB.entry[i].is_memory && ROB.entry[i].reg_ready && (ROB.entry[i].scheduled == INFLIGHT))
-                do_memory_scheduling(i);
-        }
-    }
+    for (uint32_t i=lsq_wait.next(ROB.head); (i<ROB.SIZE) && (num_searched < SCHEDULER_SIZE); i=lsq_wait.next(i+1))
+        do_memory_scheduling(i);
+    for (uint32_t i=lsq_wait.next(0); (i<ROB.head) && (num_searched < SCHEDULER_SIZE); i=lsq_wait.next(i+1))
+        do_memory_scheduling(i);
 }
 
 void O3_CPU::execute_memory_instruction()
@@ -835,8 +754,10 @@ void O3_CPU::do_memory_scheduling(uint32_t rob_index)
     uint32_t not_available = check_and_add_lsq(rob_index);
     if (not_available == 0) {
         ROB.entry[rob_index].scheduled = COMPLETED;
+        lsq_wait.reset(rob_index);
         if (ROB.entry[rob_index].executed == 0) // it could be already set to COMPLETED due to store-to-load forwarding
             ROB.entry[rob_index].executed  = INFLIGHT;
+        check_completion(rob_index);
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " instr_id: " << ROB.entry[rob_index].instr_id << " rob_index: " << rob_index;
@@ -1027,8 +948,10 @@ void O3_CPU::add_load_queue(uint32_t rob_index, uint32_t data_index)
                 cerr << "instr_id: " << ROB.entry[fwr_rob_index].instr_id << endl;
                 assert(0);
             }
-            if (ROB.entry[fwr_rob_index].num_mem_ops == 0)
+            if (ROB.entry[fwr_rob_index].num_mem_ops == 0) {
                 inflight_mem_executions++;
+                check_completion(fwr_rob_index);
+            }
 
             DP(if(warmup_complete[cpu]) {
             cout << "[LQ] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << hex;
@@ -1327,8 +1250,10 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
         cerr << "instr_id: " << ROB.entry[rob_index].instr_id << endl;
         assert(0);
     }
-    if (ROB.entry[rob_index].num_mem_ops == 0)
+    if (ROB.entry[rob_index].num_mem_ops == 0) {
         inflight_mem_executions++;
+        check_completion(rob_index);
+    }
 
     DP (if (warmup_complete[cpu]) {
     cout << "[SQ1] " << __func__ << " instr_id: " << SQ.entry[sq_index].instr_id << hex;
@@ -1370,8 +1295,10 @@ void O3_CPU::execute_store(uint32_t rob_index, uint32_t sq_index, uint32_t data_
                             assert(0);
                         }
 #endif
-                        if (ROB.entry[fwr_rob_index].num_mem_ops == 0)
+                        if (ROB.entry[fwr_rob_index].num_mem_ops == 0) {
                             inflight_mem_executions++;
+                            check_completion(fwr_rob_index);
+                        }
 
                         DP(if(warmup_complete[cpu]) {
                         cout << "[LQ3] " << __func__ << " instr_id: " << LQ.entry[lq_index].instr_id << hex;
@@ -1426,6 +1353,8 @@ void O3_CPU::complete_execution(uint32_t rob_index)
             ROB.entry[rob_index].executed = COMPLETED; 
             inflight_reg_executions--;
             completed_executions++;
+            completing.reset(rob_index);
+            remove_reg_writer(rob_index);
 
             if (ROB.entry[rob_index].reg_RAW_producer)
                 reg_RAW_release(rob_index);
@@ -1448,6 +1377,8 @@ void O3_CPU::complete_execution(uint32_t rob_index)
                 ROB.entry[rob_index].executed = COMPLETED;
                 inflight_mem_executions--;
                 completed_executions++;
+                completing.reset(rob_index);
+                remove_reg_writer(rob_index);
                 
                 if (ROB.entry[rob_index].reg_RAW_producer)
                     reg_RAW_release(rob_index);
@@ -1467,6 +1398,13 @@ void O3_CPU::complete_execution(uint32_t rob_index)
     }
 }
 
+void O3_CPU::check_completion(uint32_t rob_index)
+{
+    // executed instructions that only wait for their event_cycle are completed by update_rob()
+    if ((ROB.entry[rob_index].executed == INFLIGHT) && ((ROB.entry[rob_index].is_memory == 0) || (ROB.entry[rob_index].num_mem_ops == 0)))
+        completing.set(rob_index);
+}
+
 void O3_CPU::reg_RAW_release(uint32_t rob_index)
 {
     // if (!ROB.entry[rob_index].registers_instrs_depend_on_me.empty()) 
@@ -1478,8 +1416,10 @@ void O3_CPU::reg_RAW_release(uint32_t rob_index)
 
                 if (ROB.entry[i].num_reg_dependent == 0) {
                     ROB.entry[i].reg_ready = 1;
-                    if (ROB.entry[i].is_memory)
+                    if (ROB.entry[i].is_memory) {
                         ROB.entry[i].scheduled = INFLIGHT;
+                        lsq_wait.set(i);
+                    }
                     else {
                         ROB.entry[i].scheduled = COMPLETED;
 
@@ -1519,6 +1459,125 @@ void O3_CPU::operate_cache()
     L2C.operate();
 }
 
+uint64_t O3_CPU::cycles_to_next_event()
+{
+    // mirrors the checks of the pipeline stages in the main loop: a stage only acts once one of
+    // these event cycles is reached, anything else needs activity elsewhere first
+    uint64_t now = current_core_cycle[cpu], cycles = UINT64_MAX;
+
+    // the IPC epoch and the deadlock check also run while the core is stalled
+    if (knob::measure_ipc)
+        cycles = min(cycles, cycles_until(next_measure_ipc_cycle, now));
+    if (ROB.entry[ROB.head].ip)
+        cycles = min(cycles, cycles_until(ROB.entry[ROB.head].event_cycle + DEADLOCK_CYCLE, now));
+
+    if (stall_cycle[cpu] > (now + 1))
+        return min(cycles, stall_cycle[cpu] - now);
+
+    // handle branch reads the trace
+    if ((ROB.occupancy < ROB.SIZE) && (fetch_stall == 0))
+        return 1;
+
+    // fetch
+    if (fetch_stall && fetch_resume_cycle)
+        cycles = min(cycles, cycles_until(fetch_resume_cycle, now));
+
+    uint32_t read_index = (ROB.last_read == (ROB.SIZE-1)) ? 0 : (ROB.last_read + 1);
+    if (ROB.entry[read_index].ip && (ROB.entry[read_index].translated == 0))
+        return 1;
+
+    uint32_t fetch_index = (ROB.last_fetch == (ROB.SIZE-1)) ? 0 : (ROB.last_fetch + 1);
+    if (ROB.entry[fetch_index].translated == COMPLETED) {
+        if (ROB.entry[fetch_index].event_cycle > now)
+            cycles = min(cycles, cycles_until(ROB.entry[fetch_index].event_cycle, now));
+        else if (ROB.entry[fetch_index].fetched == 0)
+            return 1;
+    }
+
+    // schedule, execute and memory scheduling have nothing to do with an empty ROB
+    if ((ROB.head != ROB.tail) || ROB.occupancy) {
+
+        // schedule_instruction() walks from the head and only gets to the next unscheduled entry once
+        // every scheduled one before it has reached its event_cycle
+        uint32_t schedule_index = ROB.next_schedule;
+        if (ROB.entry[schedule_index].scheduled == 0) {
+            if (ROB.entry[schedule_index].event_cycle > now)
+                cycles = min(cycles, cycles_until(ROB.entry[schedule_index].event_cycle, now));
+            else if ((schedule_index >= ROB.head) && ((schedule_index - ROB.head) < SCHEDULER_SIZE)) {
+                if ((schedule_index > ROB.head) && (scheduled_event_cycle > now))
+                    cycles = min(cycles, cycles_until(scheduled_event_cycle, now));
+                else if (ROB.entry[schedule_index].fetched == COMPLETED)
+                    return 1;
+            }
+        }
+
+        if (RTE0[RTE0_head] < ROB_SIZE)
+            cycles = min(cycles, cycles_until(ROB.entry[RTE0[RTE0_head]].event_cycle, now));
+        if (RTE1[RTE1_head] < ROB_SIZE)
+            cycles = min(cycles, cycles_until(ROB.entry[RTE1[RTE1_head]].event_cycle, now));
+
+        // memory scheduling
+        if (!lsq_wait.empty())
+            return 1;
+    }
+
+    // load/store queues
+    if (RTS0[RTS0_head] < SQ_SIZE)
+        cycles = min(cycles, cycles_until(SQ.entry[RTS0[RTS0_head]].event_cycle, now));
+    if (RTS1[RTS1_head] < SQ_SIZE)
+        cycles = min(cycles, cycles_until(SQ.entry[RTS1[RTS1_head]].event_cycle, now));
+    if (RTL0[RTL0_head] < LQ_SIZE)
+        cycles = min(cycles, cycles_until(LQ.entry[RTL0[RTL0_head]].event_cycle, now));
+    if (RTL1[RTL1_head] < LQ_SIZE)
+        cycles = min(cycles, cycles_until(LQ.entry[RTL1[RTL1_head]].event_cycle, now));
+
+    // private caches
+    cycles = min(cycles, ITLB.cycles_to_next_event());
+    cycles = min(cycles, DTLB.cycles_to_next_event());
+    cycles = min(cycles, STLB.cycles_to_next_event());
+    cycles = min(cycles, L1I.cycles_to_next_event());
+    cycles = min(cycles, L1D.cycles_to_next_event());
+    cycles = min(cycles, L2C.cycles_to_next_event());
+    if (cycles == 1)
+        return 1;
+
+    // complete
+    if (ITLB.PROCESSED.occupancy)
+        cycles = min(cycles, cycles_until(ITLB.PROCESSED.entry[ITLB.PROCESSED.head].event_cycle, now));
+    if (L1I.PROCESSED.occupancy)
+        cycles = min(cycles, cycles_until(L1I.PROCESSED.entry[L1I.PROCESSED.head].event_cycle, now));
+    if (DTLB.PROCESSED.occupancy)
+        cycles = min(cycles, cycles_until(DTLB.PROCESSED.entry[DTLB.PROCESSED.head].event_cycle, now));
+    if (L1D.PROCESSED.occupancy)
+        cycles = min(cycles, cycles_until(L1D.PROCESSED.entry[L1D.PROCESSED.head].event_cycle, now));
+
+    if ((inflight_reg_executions > 0) || (inflight_mem_executions > 0)) {
+        for (uint32_t i=completing.next(0); i<ROB.SIZE; i=completing.next(i+1))
+            cycles = min(cycles, cycles_until(ROB.entry[i].event_cycle, now));
+    }
+
+    // retire
+    if (ROB.entry[ROB.head].executed == COMPLETED)
+        cycles = min(cycles, cycles_until(ROB.entry[ROB.head].event_cycle, now));
+
+    return cycles;
+}
+
+void O3_CPU::skip_cycles(uint64_t cycles)
+{
+    // the private caches only tick while the core is not stalled
+    if (stall_cycle[cpu] <= (current_core_cycle[cpu] + 1)) {
+        ITLB.cycle += cycles;
+        DTLB.cycle += cycles;
+        STLB.cycle += cycles;
+        L1I.cycle += cycles;
+        L1D.cycle += cycles;
+        L2C.cycle += cycles;
+    }
+
+    current_core_cycle[cpu] += cycles;
+}
+
 void O3_CPU::broadcast_ipc(uint8_t ipc)
 {
     L1I.broadcast_ipc(ipc);
@@ -1540,18 +1599,12 @@ void O3_CPU::update_rob()
     if (L1D.PROCESSED.occupancy && (L1D.PROCESSED.entry[L1D.PROCESSED.head].event_cycle <= current_core_cycle[cpu]))
         complete_data_fetch(&L1D.PROCESSED, 0);
 
-    // update ROB entries with completed executions
+    // update ROB entries with completed executions, in program order
     if ((inflight_reg_executions > 0) || (inflight_mem_executions > 0)) {
-        if (ROB.head < ROB.tail) {
-            for (uint32_t i=ROB.head; i<ROB.tail; i++) 
-                complete_execution(i);
-        }
-        else {
-            for (uint32_t i=ROB.head; i<ROB.SIZE; i++)
-                complete_execution(i);
-            for (uint32_t i=0; i<ROB.tail; i++)
-                complete_execution(i);
-        }
+        for (uint32_t i=completing.next(ROB.head); i<ROB.SIZE; i=completing.next(i+1))
+            complete_execution(i);
+        for (uint32_t i=completing.next(0); i<ROB.head; i=completing.next(i+1))
+            complete_execution(i);
     }
 }
 
@@ -1583,8 +1636,9 @@ void O3_CPU::complete_instr_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
     cout << " event_cycle: " << ROB.entry[rob_index].event_cycle << endl; });
 
     // check if other instructions were merged
-    if (queue->entry[index].instr_merged) {
-	ITERATE_SET(i,queue->entry[index].rob_index_depend_on_me, ROB_SIZE) {
+    DEPENDENTS *dependents = packet_dependents[cpu].find(&queue->entry[index]);
+    if (queue->entry[index].instr_merged && dependents) {
+	ITERATE_SET(i,dependents->rob_index_depend_on_me, ROB_SIZE) {
             // update ROB entry
             if (is_it_tlb) {
                 ROB.entry[i].translated = COMPLETED;
@@ -1687,8 +1741,10 @@ void O3_CPU::complete_data_fetch(PACKET_QUEUE *queue, uint8_t is_it_tlb)
                 assert(0);
             }
 #endif
-            if (ROB.entry[rob_index].num_mem_ops == 0)
+            if (ROB.entry[rob_index].num_mem_ops == 0) {
                 inflight_mem_executions++;
+                check_completion(rob_index);
+            }
 
             DP (if (warmup_complete[cpu]) {
             cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[lq_index].instr_id;
@@ -1780,8 +1836,10 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
                 assert(0);
             }
 #endif
-            if (ROB.entry[rob_index].num_mem_ops == 0)
+            if (ROB.entry[rob_index].num_mem_ops == 0) {
                 inflight_mem_executions++;
+                check_completion(rob_index);
+            }
 
             DP (if (warmup_complete[cpu]) {
             cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[lq_index].instr_id;
@@ -1800,8 +1858,12 @@ void O3_CPU::handle_o3_fetch(PACKET *current_packet, uint32_t cache_type)
 
 void O3_CPU::handle_merged_translation(PACKET *provider)
 {
+    DEPENDENTS *dependents = packet_dependents[cpu].find(provider);
+    if (dependents == NULL)
+        return;
+
     if (provider->store_merged) {
-	ITERATE_SET(merged, provider->sq_index_depend_on_me, SQ.SIZE) {
+	ITERATE_SET(merged, dependents->sq_index_depend_on_me, SQ.SIZE) {
             SQ.entry[merged].translated = COMPLETED;
             SQ.entry[merged].physical_address = (provider->data_pa << LOG2_PAGE_SIZE) | (SQ.entry[merged].virtual_address & ((1 << LOG2_PAGE_SIZE) - 1)); // translated address
             SQ.entry[merged].event_cycle = current_core_cycle[cpu];
@@ -1818,7 +1880,7 @@ void O3_CPU::handle_merged_translation(PACKET *provider)
         }
     }
     if (provider->load_merged) {
-	ITERATE_SET(merged, provider->lq_index_depend_on_me, LQ.SIZE) {
+	ITERATE_SET(merged, dependents->lq_index_depend_on_me, LQ.SIZE) {
             LQ.entry[merged].translated = COMPLETED;
             LQ.entry[merged].physical_address = (provider->data_pa << LOG2_PAGE_SIZE) | (LQ.entry[merged].virtual_address & ((1 << LOG2_PAGE_SIZE) - 1)); // translated address
             LQ.entry[merged].event_cycle = current_core_cycle[cpu];
@@ -1842,7 +1904,11 @@ void O3_CPU::handle_merged_translation(PACKET *provider)
 
 void O3_CPU::handle_merged_load(PACKET *provider)
 {
-    ITERATE_SET(merged, provider->lq_index_depend_on_me, LQ.SIZE) {
+    DEPENDENTS *dependents = packet_dependents[cpu].find(provider);
+    if (dependents == NULL)
+        return;
+
+    ITERATE_SET(merged, dependents->lq_index_depend_on_me, LQ.SIZE) {
         uint32_t merged_rob_index = LQ.entry[merged].rob_index;
 
         LQ.entry[merged].fetched = COMPLETED;
@@ -1857,8 +1923,10 @@ void O3_CPU::handle_merged_load(PACKET *provider)
         }
 #endif
 
-        if (ROB.entry[merged_rob_index].num_mem_ops == 0)
+        if (ROB.entry[merged_rob_index].num_mem_ops == 0) {
             inflight_mem_executions++;
+            check_completion(merged_rob_index);
+        }
 
         DP (if (warmup_complete[cpu]) {
         cout << "[ROB] " << __func__ << " load instr_id: " << LQ.entry[merged].instr_id;
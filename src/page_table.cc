@@ -0,0 +1,201 @@
+#include <math.h>
+#include <assert.h>
+#include <string>
+
+#include "page_table.h"
+#include "checkpoint.h"
+
+void SLOT_INDEX::resize(uint64_t num_buckets)
+{
+    buckets.assign(num_buckets, NO_SLOT);
+    shift = 64 - __builtin_ctzll(num_buckets);
+}
+
+void SLOT_INDEX::place(uint32_t slot)
+{
+    uint64_t mask = buckets.size() - 1, i = bucket(keys[slot]);
+    while (buckets[i] != NO_SLOT)
+        i = (i+1) & mask;
+    buckets[i] = slot;
+}
+
+uint32_t SLOT_INDEX::find(uint64_t key) const
+{
+    uint64_t mask = buckets.size() - 1;
+    for (uint64_t i = bucket(key); buckets[i] != NO_SLOT; i = (i+1) & mask) {
+        if (keys[buckets[i]] == key)
+            return buckets[i];
+    }
+    return NO_SLOT;
+}
+
+void SLOT_INDEX::insert(uint32_t slot)
+{
+    if (2 * (uint64_t)(size+1) > buckets.size()) {
+        std::vector<uint32_t> old_buckets;
+        old_buckets.swap(buckets);
+        resize(2 * old_buckets.size());
+        for (uint64_t i = 0; i < old_buckets.size(); i++) {
+            if (old_buckets[i] != NO_SLOT)
+                place(old_buckets[i]);
+        }
+    }
+
+    place(slot);
+    size++;
+}
+
+void SLOT_INDEX::erase(uint64_t key)
+{
+    uint64_t mask = buckets.size() - 1, i = bucket(key);
+    while (keys[buckets[i]] != key) {
+        i = (i+1) & mask;
+        assert(buckets[i] != NO_SLOT);
+    }
+
+    // move back every following entry whose home bucket is not between the hole and itself
+    for (uint64_t j = (i+1) & mask; buckets[j] != NO_SLOT; j = (j+1) & mask) {
+        uint64_t home = bucket(keys[buckets[j]]);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            buckets[i] = buckets[j];
+            i = j;
+        }
+    }
+    buckets[i] = NO_SLOT;
+    size--;
+}
+
+void SLOT_INDEX::rebuild()
+{
+    uint64_t num_buckets = 16;
+    while (num_buckets < 2 * (uint64_t)keys.size())
+        num_buckets *= 2;
+    resize(num_buckets);
+    size = 0;
+    for (uint32_t slot = 0; slot < keys.size(); slot++) {
+        place(slot);
+        size++;
+    }
+}
+
+uint32_t PAGE_TABLE::map(uint64_t vpage, uint64_t ppage)
+{
+    uint32_t slot = vpages.size();
+    vpages.push_back(vpage);
+    ppages.push_back(ppage);
+    referenced.push_back(0);
+    vpage_index.insert(slot);
+    ppage_index.insert(slot);
+    return slot;
+}
+
+uint32_t PAGE_TABLE::nru_victim()
+{
+    assert(vpages.size());
+
+    // the hand clears every bit it passes, so it finds a page within one round
+    while (referenced[hand]) {
+        referenced[hand] = 0;
+        hand = (hand+1) % vpages.size();
+    }
+
+    uint32_t victim = hand;
+    hand = (hand+1) % vpages.size();
+    return victim;
+}
+
+void PAGE_TABLE::remap(uint32_t slot, uint64_t vpage)
+{
+    vpage_index.erase(vpages[slot]);
+    vpages[slot] = vpage;
+    referenced[slot] = 0;
+    vpage_index.insert(slot);
+}
+
+// vectors go through their size, the indices are rebuilt when restoring
+template <class T> static void checkpoint_vector(CHECKPOINT_FILE &checkpoint, std::vector<T> &data)
+{
+    uint64_t size = data.size();
+    checkpoint.value(size);
+    if (checkpoint.restore)
+        data.resize(size);
+    if (size)
+        checkpoint.transfer(data.data(), size * sizeof(T));
+}
+
+void PAGE_TABLE::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+    checkpoint.section("page table");
+    checkpoint_vector(checkpoint, vpages);
+    checkpoint_vector(checkpoint, ppages);
+    checkpoint_vector(checkpoint, referenced);
+    checkpoint.value(hand);
+
+    if (checkpoint.restore) {
+        vpage_index.rebuild();
+        ppage_index.rebuild();
+    }
+}
+
+void FOOTPRINT::initialize(bool approximate)
+{
+    this->approximate = approximate;
+    lines.clear();
+    line_index.rebuild();
+    registers.assign(approximate ? (1 << FOOTPRINT_HLL_BITS) : 0, 0);
+}
+
+void FOOTPRINT::add(uint64_t line)
+{
+    if (!approximate) {
+        if (line_index.find(line) == NO_SLOT) {
+            lines.push_back(line);
+            line_index.insert(lines.size() - 1);
+        }
+        return;
+    }
+
+    // the register picked by the top bits of a hash keeps the longest run of leading zeros after them
+    uint64_t hash = line + 0x9e3779b97f4a7c15ull;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    hash = hash ^ (hash >> 31);
+
+    uint32_t index = hash >> (64 - FOOTPRINT_HLL_BITS);
+    uint64_t rest = hash << FOOTPRINT_HLL_BITS;
+    uint8_t rank = rest ? __builtin_clzll(rest) + 1 : 64 - FOOTPRINT_HLL_BITS + 1;
+    if (rank > registers[index])
+        registers[index] = rank;
+}
+
+uint64_t FOOTPRINT::count() const
+{
+    if (!approximate)
+        return lines.size();
+
+    double m = registers.size(), sum = 0;
+    uint32_t zeros = 0;
+    for (uint32_t i = 0; i < registers.size(); i++) {
+        sum += ldexp(1.0, -registers[i]);
+        if (registers[i] == 0)
+            zeros++;
+    }
+
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    // small footprints are counted more precisely by the empty registers (linear counting)
+    if (estimate <= 2.5 * m && zeros)
+        estimate = m * log(m / zeros);
+    return (uint64_t)(estimate + 0.5);
+}
+
+void FOOTPRINT::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+    checkpoint.section(approximate ? "footprint hyperloglog" : "footprint exact");
+    if (approximate)
+        checkpoint.transfer(registers.data(), registers.size());
+    else {
+        checkpoint_vector(checkpoint, lines);
+        if (checkpoint.restore)
+            line_index.rebuild();
+    }
+}
@@ -0,0 +1,163 @@
+#include "parallel_sim.h"
+
+bool parallel_running = false, parallel_deterministic = true;
+uint32_t parallel_position[NUM_CPUS];
+std::atomic<uint64_t> parallel_finished_cycle[NUM_CPUS];
+
+std::mutex page_table_mutex;
+
+UNCORE_PORT::UNCORE_PORT()
+{
+    next_request = 0;
+    wq_full = 0;
+    cpu = 0;
+    llc = NULL;
+
+    for (uint32_t i=0; i<4; i++) {
+        granted[i] = 0;
+        used[i] = 0;
+    }
+}
+
+int UNCORE_PORT::buffer_request(uint8_t queue_type, PACKET *packet)
+{
+    if (used[queue_type] == granted[queue_type]) {
+        cerr << "[UNCORE_PORT] cpu " << cpu << " adds more requests than it was granted ***" << endl;
+        assert(0);
+    }
+    used[queue_type]++;
+
+    PORT_REQUEST request;
+    request.queue_type = queue_type;
+    request.cycle = current_core_cycle[cpu];
+    request.packet = *packet;
+    requests.push_back(request);
+
+    return -1;
+}
+
+void UNCORE_PORT::return_data(PACKET *packet)
+{
+    // the LLC returns data straight to the L2C, never through the port
+    assert(0);
+}
+
+uint32_t UNCORE_PORT::get_occupancy(uint8_t queue_type, uint64_t address)
+{
+    // the L2C only sees the entries granted to it, so the queue looks full once they are used
+    if ((queue_type >= 1) && (queue_type <= 3))
+        return llc->get_size(queue_type, address) - (granted[queue_type] - used[queue_type]);
+
+    return llc->get_occupancy(queue_type, address);
+}
+
+uint32_t UNCORE_PORT::get_size(uint8_t queue_type, uint64_t address)
+{
+    return llc->get_size(queue_type, address);
+}
+
+void UNCORE_PORT::grant(uint32_t rank, uint32_t num_ports)
+{
+    for (uint8_t queue_type=1; queue_type<=3; queue_type++) {
+        uint32_t free_entries = llc->get_size(queue_type, 0) - llc->get_occupancy(queue_type, 0);
+        granted[queue_type] = (free_entries / num_ports) + ((rank < (free_entries % num_ports)) ? 1 : 0);
+        used[queue_type] = 0;
+    }
+}
+
+void UNCORE_PORT::drain(uint64_t cycle)
+{
+    while ((next_request < requests.size()) && (requests[next_request].cycle <= cycle)) {
+        PACKET *packet = &requests[next_request].packet;
+        if (requests[next_request].queue_type == 1)
+            llc->add_rq(packet);
+        else if (requests[next_request].queue_type == 2)
+            llc->add_wq(packet);
+        else
+            llc->add_pq(packet);
+
+        next_request++;
+    }
+
+    for (; wq_full; wq_full--)
+        llc->increment_WQ_FULL(0);
+
+    if (next_request == requests.size()) {
+        requests.clear();
+        next_request = 0;
+    }
+}
+
+void CORE_THREADS::start(void (*core_function)(uint32_t cpu, uint64_t cycles))
+{
+    run_core = core_function;
+    stopping = false;
+    for (uint32_t i=1; i<NUM_CPUS; i++)
+        workers.push_back(std::thread(&CORE_THREADS::worker_loop, this, i));
+}
+
+void CORE_THREADS::worker_loop(uint32_t cpu)
+{
+    uint64_t seen = 0;
+    while (1) {
+        // spinning keeps the hand-over short, yielding keeps oversubscribed hosts moving
+        while (generation.load(std::memory_order_acquire) == seen)
+            std::this_thread::yield();
+        seen++;
+
+        if (stopping.load(std::memory_order_acquire))
+            return;
+
+        run_core(cpu, quantum_cycles);
+        finished.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void CORE_THREADS::run(uint64_t cycles)
+{
+    quantum_cycles = cycles;
+    finished.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+
+    run_core(0, cycles);
+
+    while (finished.load(std::memory_order_acquire) < workers.size())
+        std::this_thread::yield();
+}
+
+void CORE_THREADS::stop()
+{
+    if (workers.empty())
+        return;
+
+    stopping.store(true, std::memory_order_release);
+    generation.fetch_add(1, std::memory_order_release);
+    for (uint32_t i=0; i<workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+}
+
+SHARED_ACCESS::SHARED_ACCESS(uint32_t cpu, std::mutex &lock) : cpu(cpu), lock(lock)
+{
+    if (!parallel_running)
+        return;
+
+    if (parallel_deterministic) {
+        // wait for the cores that come first in this cycle, the ones after it wait for this core
+        uint64_t cycle = current_core_cycle[cpu];
+        for (uint32_t i=0; i<NUM_CPUS; i++) {
+            if (parallel_position[i] < parallel_position[cpu]) {
+                while (parallel_finished_cycle[i].load(std::memory_order_acquire) < cycle)
+                    std::this_thread::yield();
+            }
+        }
+    }
+    else
+        lock.lock();
+}
+
+SHARED_ACCESS::~SHARED_ACCESS()
+{
+    if (parallel_running && !parallel_deterministic)
+        lock.unlock();
+}
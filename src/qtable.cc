@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+#include "qtable.h"
+#include "checkpoint.h"
+
+const char* QTableStorageString[] = {"float", "fp16", "int16"};
+const char* MapQTableStorageString(QTableStorage storage)
+{
+	assert((uint32_t)storage < QTableStorage::NumQTableStorages);
+	return QTableStorageString[(uint32_t)storage];
+}
+
+QTableStorage parseQTableStorage(std::string str)
+{
+	if(!str.compare("float"))	return QTableStorage::QTableFloat;
+	if(!str.compare("fp16"))	return QTableStorage::QTableFP16;
+	if(!str.compare("int16"))	return QTableStorage::QTableFixed16;
+
+	printf("unsupported qtable storage %s\n", str.c_str());
+	assert(false);
+	return QTableStorage::QTableFloat;
+}
+
+/* round to nearest even, like the F16C instructions */
+uint16_t float_to_half(float value)
+{
+#if defined(__F16C__)
+	return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t abs = bits & 0x7fffffff;
+
+	if(abs > 0x7f800000) return sign | 0x7e00 | ((abs >> 13) & 0x3ff); /* NaN */
+	if(abs >= 0x47800000) return sign | 0x7c00; /* too large, inf */
+	if(abs < 0x33000000) return sign; /* below half the smallest subnormal */
+
+	uint32_t half, shift;
+	if(abs < 0x38800000)
+	{
+		/* subnormal */
+		shift = 126 - (abs >> 23);
+		abs = (abs & 0x7fffff) | 0x800000;
+		half = abs >> shift;
+	}
+	else
+	{
+		shift = 13;
+		half = (abs >> 13) - ((127 - 15) << 10);
+	}
+	uint32_t rest = abs & ((1u << shift) - 1), tie = 1u << (shift - 1);
+	if(rest > tie || (rest == tie && (half & 1)))
+	{
+		half++; /* may carry into the exponent, up to inf */
+	}
+	return sign | half;
+#endif
+}
+
+float half_to_float(uint16_t value)
+{
+#if defined(__F16C__)
+	return _cvtsh_ss(value);
+#else
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exp = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+	uint32_t bits;
+
+	if(exp == 0x1f)		bits = sign | 0x7f800000 | (mantissa << 13);
+	else if(exp)		bits = sign | ((exp + 127 - 15) << 23) | (mantissa << 13);
+	else if(!mantissa)	bits = sign;
+	else				return sign ? -ldexpf((float)mantissa, -24) : ldexpf((float)mantissa, -24);
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+#endif
+}
+
+QTable::QTable(uint32_t rows, uint32_t columns, float init_value, QTableStorage storage, uint32_t frac_bits)
+	: m_rows(rows), m_columns(columns), m_storage(storage), m_frac_bits(frac_bits)
+{
+	assert(m_rows && m_columns);
+	assert(frac_bits < 16);
+	m_row_size = (m_columns + QTABLE_ROW_ALIGN - 1) / QTABLE_ROW_ALIGN * QTABLE_ROW_ALIGN;
+	m_scale = ldexpf(1.0, frac_bits);
+	m_inv_scale = ldexpf(1.0, -(int32_t)frac_bits);
+
+	/* the padding stays zero */
+	int ret = posix_memalign(&m_table, 64, bytes());
+	assert(ret == 0);
+	bzero(m_table, bytes());
+
+	for(uint32_t row = 0; row < m_rows; ++row)
+	{
+		for(uint32_t column = 0; column < m_columns; ++column)
+		{
+			set(row, column, init_value);
+		}
+	}
+	m_init_value = get(0, 0);
+}
+
+QTable::~QTable()
+{
+	free(m_table);
+}
+
+size_t QTable::bytes() const
+{
+	return (size_t)m_rows * m_row_size * (m_storage == QTableFloat ? sizeof(float) : sizeof(uint16_t));
+}
+
+void QTable::checkpoint(CHECKPOINT_FILE &checkpoint)
+{
+	std::string tag = "qtable " + std::to_string(m_rows) + "x" + std::to_string(m_columns) + " " + MapQTableStorageString(m_storage);
+	if(m_storage == QTableFixed16)
+	{
+		tag += " frac_bits " + std::to_string(m_frac_bits);
+	}
+	checkpoint.section(tag);
+	checkpoint.transfer(m_table, bytes());
+}
+
+int16_t QTable::to_fixed(float value) const
+{
+	float scaled = rintf(value * m_scale);
+	if(scaled > INT16_MAX) return INT16_MAX;
+	if(scaled < INT16_MIN) return INT16_MIN;
+	return (int16_t)scaled;
+}
+
+void QTable::sum_rows(const uint32_t *rows, uint32_t num_rows, float *sums, float scale) const
+{
+	for(uint32_t index = 0; index < num_rows; ++index)
+	{
+		assert(rows[index] < m_rows);
+	}
+
+	/* every column is summed in the order of the rows, so all paths give the same result */
+	uint32_t column = 0;
+	if(m_storage == QTableFloat)
+	{
+		const float *table = (const float*)m_table;
+#if defined(__AVX__)
+		__m256 vscale = _mm256_set1_ps(scale);
+		for(; column < m_row_size; column += 8)
+		{
+			__m256 sum = _mm256_setzero_ps();
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum = _mm256_add_ps(sum, _mm256_load_ps(table + position(rows[index], column)));
+			}
+			_mm256_storeu_ps(sums + column, _mm256_mul_ps(sum, vscale));
+		}
+#elif defined(__SSE__)
+		__m128 vscale = _mm_set1_ps(scale);
+		for(; column < m_row_size; column += 4)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum = _mm_add_ps(sum, _mm_load_ps(table + position(rows[index], column)));
+			}
+			_mm_storeu_ps(sums + column, _mm_mul_ps(sum, vscale));
+		}
+#endif
+		for(; column < m_row_size; ++column)
+		{
+			float sum = 0.0;
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum += table[position(rows[index], column)];
+			}
+			sums[column] = sum * scale;
+		}
+	}
+	else if(m_storage == QTableFP16)
+	{
+		const uint16_t *table = (const uint16_t*)m_table;
+#if defined(__F16C__)
+		__m256 vscale = _mm256_set1_ps(scale);
+		for(; column < m_row_size; column += 8)
+		{
+			__m256 sum = _mm256_setzero_ps();
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum = _mm256_add_ps(sum, _mm256_cvtph_ps(_mm_load_si128((const __m128i*)(table + position(rows[index], column)))));
+			}
+			_mm256_storeu_ps(sums + column, _mm256_mul_ps(sum, vscale));
+		}
+#endif
+		for(; column < m_row_size; ++column)
+		{
+			float sum = 0.0;
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum += half_to_float(table[position(rows[index], column)]);
+			}
+			sums[column] = sum * scale;
+		}
+	}
+	else
+	{
+		/* fixed point values add up exactly as integers and are converted once.
+		 * As long as the sum fits in a float mantissa this equals adding them up as floats */
+		const int16_t *table = (const int16_t*)m_table;
+		float fixed_scale = scale * m_inv_scale;
+#if defined(__AVX2__)
+		__m256 vscale = _mm256_set1_ps(fixed_scale);
+		for(; column < m_row_size; column += 8)
+		{
+			__m256i sum = _mm256_setzero_si256();
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum = _mm256_add_epi32(sum, _mm256_cvtepi16_epi32(_mm_load_si128((const __m128i*)(table + position(rows[index], column)))));
+			}
+			_mm256_storeu_ps(sums + column, _mm256_mul_ps(_mm256_cvtepi32_ps(sum), vscale));
+		}
+#elif defined(__SSE2__)
+		__m128 vscale = _mm_set1_ps(fixed_scale);
+		for(; column < m_row_size; column += 8)
+		{
+			__m128i sum_low = _mm_setzero_si128(), sum_high = _mm_setzero_si128();
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				/* sign extends every value to 32 bits */
+				__m128i fixed = _mm_load_si128((const __m128i*)(table + position(rows[index], column)));
+				sum_low = _mm_add_epi32(sum_low, _mm_srai_epi32(_mm_unpacklo_epi16(fixed, fixed), 16));
+				sum_high = _mm_add_epi32(sum_high, _mm_srai_epi32(_mm_unpackhi_epi16(fixed, fixed), 16));
+			}
+			_mm_storeu_ps(sums + column, _mm_mul_ps(_mm_cvtepi32_ps(sum_low), vscale));
+			_mm_storeu_ps(sums + column + 4, _mm_mul_ps(_mm_cvtepi32_ps(sum_high), vscale));
+		}
+#endif
+		for(; column < m_row_size; ++column)
+		{
+			int32_t sum = 0;
+			for(uint32_t index = 0; index < num_rows; ++index)
+			{
+				sum += table[position(rows[index], column)];
+			}
+			sums[column] = (float)sum * fixed_scale;
+		}
+	}
+}
@@ -0,0 +1,602 @@
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <zlib.h>
+#include <lzma.h>
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "trace_reader.h"
+#include "compact_trace.h"
+
+using namespace std;
+
+extern uint8_t MAX_INSTR_DESTINATIONS;
+
+bool TRACE_STREAM::read_all(void *buf, size_t len)
+{
+    uint8_t *dst = (uint8_t *)buf;
+    while (len) {
+        size_t bytes = read(dst, len);
+        if (bytes == 0)
+            return 0;
+        dst += bytes;
+        len -= bytes;
+    }
+    return 1;
+}
+
+// gzip (zlib also reads uncompressed files transparently)
+class GZ_TRACE_STREAM : public TRACE_STREAM {
+    gzFile file;
+
+  public:
+    GZ_TRACE_STREAM(const char *trace_name) {
+        file = gzopen(trace_name, "rb");
+        if (file == NULL) {
+            cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_name << " ***" << endl;
+            assert(0);
+        }
+        gzbuffer(file, TRACE_STREAM_BUFFER_SIZE);
+    };
+
+    ~GZ_TRACE_STREAM() {
+        gzclose(file);
+    };
+
+    size_t read(void *buf, size_t len) {
+        int bytes = gzread(file, buf, len);
+        if (bytes < 0) {
+            int errnum;
+            const char *msg = gzerror(file, &errnum);
+
+            // a truncated trace simply ends here
+            if (errnum == Z_BUF_ERROR)
+                return 0;
+
+            cerr << endl << "*** TRACE DECOMPRESSION ERROR: " << msg << " ***" << endl;
+            assert(0);
+        }
+        return bytes;
+    };
+
+    void rewind() {
+        gzrewind(file);
+    };
+};
+
+// xz
+class XZ_TRACE_STREAM : public TRACE_STREAM {
+    FILE *file;
+    lzma_stream strm;
+    uint8_t in_buf[TRACE_STREAM_BUFFER_SIZE];
+    uint8_t at_end;
+
+    void init_decoder() {
+        strm = LZMA_STREAM_INIT;
+        if (lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+            cerr << endl << "*** CANNOT INITIALIZE XZ DECODER ***" << endl;
+            assert(0);
+        }
+        at_end = 0;
+    };
+
+  public:
+    XZ_TRACE_STREAM(const char *trace_name) {
+        file = fopen(trace_name, "rb");
+        if (file == NULL) {
+            cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_name << " ***" << endl;
+            assert(0);
+        }
+        init_decoder();
+    };
+
+    ~XZ_TRACE_STREAM() {
+        lzma_end(&strm);
+        fclose(file);
+    };
+
+    size_t read(void *buf, size_t len) {
+        if (at_end)
+            return 0;
+
+        strm.next_out = (uint8_t *)buf;
+        strm.avail_out = len;
+        while (strm.avail_out) {
+            lzma_action action = LZMA_RUN;
+            if (strm.avail_in == 0) {
+                strm.next_in = in_buf;
+                strm.avail_in = fread(in_buf, 1, sizeof(in_buf), file);
+                if (strm.avail_in == 0)
+                    action = LZMA_FINISH;
+            }
+
+            // a truncated trace simply ends here
+            lzma_ret ret = lzma_code(&strm, action);
+            if ((ret == LZMA_STREAM_END) || ((ret == LZMA_BUF_ERROR) && (action == LZMA_FINISH))) {
+                at_end = 1;
+                break;
+            }
+            if (ret != LZMA_OK) {
+                cerr << endl << "*** TRACE DECOMPRESSION ERROR: xz error " << ret << " ***" << endl;
+                assert(0);
+            }
+        }
+
+        return len - strm.avail_out;
+    };
+
+    void rewind() {
+        lzma_end(&strm);
+        fseek(file, 0, SEEK_SET);
+        init_decoder();
+    };
+};
+
+#ifdef ENABLE_ZSTD
+// zstd
+class ZSTD_TRACE_STREAM : public TRACE_STREAM {
+    FILE *file;
+    ZSTD_DStream *dstream;
+    uint8_t in_buf[TRACE_STREAM_BUFFER_SIZE];
+    ZSTD_inBuffer input;
+
+  public:
+    ZSTD_TRACE_STREAM(const char *trace_name) {
+        file = fopen(trace_name, "rb");
+        if (file == NULL) {
+            cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_name << " ***" << endl;
+            assert(0);
+        }
+        dstream = ZSTD_createDStream();
+        ZSTD_initDStream(dstream);
+        input = {in_buf, 0, 0};
+    };
+
+    ~ZSTD_TRACE_STREAM() {
+        ZSTD_freeDStream(dstream);
+        fclose(file);
+    };
+
+    size_t read(void *buf, size_t len) {
+        ZSTD_outBuffer output = {buf, len, 0};
+        while (output.pos < output.size) {
+            if (input.pos == input.size) {
+                input.size = fread(in_buf, 1, sizeof(in_buf), file);
+                input.pos = 0;
+                if (input.size == 0)
+                    break;
+            }
+
+            size_t ret = ZSTD_decompressStream(dstream, &output, &input);
+            if (ZSTD_isError(ret)) {
+                cerr << endl << "*** TRACE DECOMPRESSION ERROR: " << ZSTD_getErrorName(ret) << " ***" << endl;
+                assert(0);
+            }
+        }
+
+        return output.pos;
+    };
+
+    void rewind() {
+        fseek(file, 0, SEEK_SET);
+        ZSTD_initDStream(dstream);
+        input = {in_buf, 0, 0};
+    };
+};
+#endif
+
+// decompressed trace prefixes, filled before the jobs of a batch fork and only read afterwards
+struct CACHED_TRACE {
+    vector<uint8_t> data;
+    bool complete; // the whole trace fit
+};
+
+static map<string, CACHED_TRACE*> trace_cache;
+static mutex trace_cache_lock;
+
+static TRACE_STREAM *open_trace_file_stream(const char *trace_name);
+
+// reads the cached prefix from memory and continues in the trace file past its end
+class SHARED_TRACE_STREAM : public TRACE_STREAM {
+    string trace_name;
+    const CACHED_TRACE *cache;
+    size_t pos;
+    TRACE_STREAM *file_stream;
+
+  public:
+    SHARED_TRACE_STREAM(const char *trace_name, const CACHED_TRACE *cache)
+        : trace_name(trace_name), cache(cache), pos(0), file_stream(NULL) {};
+
+    ~SHARED_TRACE_STREAM() {
+        delete file_stream;
+    };
+
+    size_t read(void *buf, size_t len) {
+        if (pos < cache->data.size()) {
+            size_t bytes = min(len, cache->data.size() - pos);
+            memcpy(buf, &cache->data[pos], bytes);
+            pos += bytes;
+            return bytes;
+        }
+
+        if (cache->complete)
+            return 0;
+
+        if (file_stream == NULL) {
+            // skip the cached bytes once, the rest of the trace comes from the file
+            file_stream = open_trace_file_stream(trace_name.c_str());
+            uint8_t skipped[4096];
+            for (size_t left = pos; left; ) {
+                size_t bytes = file_stream->read(skipped, min(left, sizeof(skipped)));
+                if (bytes == 0) {
+                    cerr << endl << "*** TRACE FILE CHANGED SINCE IT WAS CACHED: " << trace_name << " ***" << endl;
+                    assert(0);
+                }
+                left -= bytes;
+            }
+        }
+
+        return file_stream->read(buf, len);
+    };
+
+    void rewind() {
+        pos = 0;
+        delete file_stream;
+        file_stream = NULL;
+    };
+};
+
+uint64_t cache_trace(const char *trace_name, uint64_t max_bytes)
+{
+    {
+        lock_guard<mutex> guard(trace_cache_lock);
+        if (trace_cache.count(trace_name))
+            return trace_cache[trace_name]->data.size();
+    }
+
+    CACHED_TRACE *cache = new CACHED_TRACE;
+    cache->complete = 0;
+
+    TRACE_STREAM *stream = open_trace_file_stream(trace_name);
+    while (cache->data.size() < max_bytes) {
+        size_t old_size = cache->data.size(),
+               chunk = min((uint64_t)TRACE_STREAM_BUFFER_SIZE, max_bytes - old_size);
+        cache->data.resize(old_size + chunk);
+
+        size_t bytes = stream->read(&cache->data[old_size], chunk);
+        cache->data.resize(old_size + bytes);
+        if (bytes == 0) {
+            cache->complete = 1;
+            break;
+        }
+    }
+    delete stream;
+
+    cache->data.shrink_to_fit();
+    lock_guard<mutex> guard(trace_cache_lock);
+    trace_cache[trace_name] = cache;
+    return cache->data.size();
+}
+
+TRACE_STREAM *open_trace_stream(const char *trace_name)
+{
+    map<string, CACHED_TRACE*>::iterator cached = trace_cache.find(trace_name);
+    if (cached != trace_cache.end())
+        return new SHARED_TRACE_STREAM(trace_name, cached->second);
+
+    return open_trace_file_stream(trace_name);
+}
+
+static TRACE_STREAM *open_trace_file_stream(const char *trace_name)
+{
+    uint8_t magic[6] = {0};
+    FILE *file = fopen(trace_name, "rb");
+    if (file == NULL) {
+        cerr << endl << "*** CANNOT OPEN TRACE FILE: " << trace_name << " ***" << endl;
+        assert(0);
+    }
+    size_t magic_size = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    const uint8_t xz_magic[6] = {0xFD, '7', 'z', 'X', 'Z', 0x00},
+                  zstd_magic[4] = {0x28, 0xB5, 0x2F, 0xFD};
+
+    if ((magic_size >= 6) && (memcmp(magic, xz_magic, 6) == 0))
+        return new XZ_TRACE_STREAM(trace_name);
+
+    if ((magic_size >= 4) && (memcmp(magic, zstd_magic, 4) == 0)) {
+#ifdef ENABLE_ZSTD
+        return new ZSTD_TRACE_STREAM(trace_name);
+#else
+        cerr << endl << "*** ChampSim was built without zstd support: " << trace_name << " ***" << endl;
+        assert(0);
+#endif
+    }
+
+    // gzip or uncompressed trace
+    return new GZ_TRACE_STREAM(trace_name);
+}
+
+void finish_instr_decode(ooo_model_instr *arch_instr)
+{
+    int num_reg_ops = 0, num_mem_ops = 0;
+
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        arch_instr->destination_virtual_address[i] = arch_instr->destination_memory[i];
+
+        if (arch_instr->destination_registers[i])
+            num_reg_ops++;
+        if (arch_instr->destination_memory[i])
+            num_mem_ops++;
+    }
+
+    for (int i=0; i<NUM_INSTR_SOURCES; i++) {
+        arch_instr->source_virtual_address[i] = arch_instr->source_memory[i];
+
+        if (arch_instr->source_registers[i])
+            num_reg_ops++;
+        if (arch_instr->source_memory[i])
+            num_mem_ops++;
+    }
+
+    arch_instr->num_reg_ops = num_reg_ops;
+    arch_instr->num_mem_ops = num_mem_ops;
+    if (num_mem_ops > 0)
+        arch_instr->is_memory = 1;
+}
+
+uint64_t TRACE_DECODER::skip(uint64_t num_instrs)
+{
+    ooo_model_instr skipped;
+    for (uint64_t i=0; i<num_instrs; i++) {
+        if (!decode_instr(&skipped))
+            return i;
+    }
+    return num_instrs;
+}
+
+LEGACY_TRACE_DECODER::LEGACY_TRACE_DECODER(uint32_t cpu, const char *trace_name, uint8_t cloudsuite)
+    : cpu(cpu), cloudsuite(cloudsuite)
+{
+    stream = open_trace_stream(trace_name);
+}
+
+LEGACY_TRACE_DECODER::~LEGACY_TRACE_DECODER()
+{
+    delete stream;
+}
+
+void LEGACY_TRACE_DECODER::rewind()
+{
+    stream->rewind();
+}
+
+uint64_t LEGACY_TRACE_DECODER::skip(uint64_t num_instrs)
+{
+    // records have a fixed size, so they only need to be counted
+    cloudsuite_instr record;
+    size_t record_size = cloudsuite ? sizeof(cloudsuite_instr) : sizeof(input_instr);
+
+    for (uint64_t i=0; i<num_instrs; i++) {
+        if (!stream->read_all(&record, record_size))
+            return i;
+    }
+    return num_instrs;
+}
+
+bool LEGACY_TRACE_DECODER::decode_instr(ooo_model_instr *arch_instr)
+{
+    input_instr current_instr;
+    cloudsuite_instr current_cloudsuite_instr;
+    uint8_t *destination_registers, *source_registers;
+    uint64_t *destination_memory, *source_memory;
+
+    if (cloudsuite) {
+        if (!stream->read_all(&current_cloudsuite_instr, sizeof(cloudsuite_instr)))
+            return 0;
+
+        arch_instr->ip = current_cloudsuite_instr.ip;
+        arch_instr->is_branch = current_cloudsuite_instr.is_branch;
+        arch_instr->branch_taken = current_cloudsuite_instr.branch_taken;
+
+        arch_instr->asid[0] = current_cloudsuite_instr.asid[0];
+        arch_instr->asid[1] = current_cloudsuite_instr.asid[1];
+
+        destination_registers = current_cloudsuite_instr.destination_registers;
+        destination_memory = current_cloudsuite_instr.destination_memory;
+        source_registers = current_cloudsuite_instr.source_registers;
+        source_memory = current_cloudsuite_instr.source_memory;
+    }
+    else {
+        if (!stream->read_all(&current_instr, sizeof(input_instr)))
+            return 0;
+
+        arch_instr->ip = current_instr.ip;
+        arch_instr->is_branch = current_instr.is_branch;
+        arch_instr->branch_taken = current_instr.branch_taken;
+
+        arch_instr->asid[0] = cpu;
+        arch_instr->asid[1] = cpu;
+
+        destination_registers = current_instr.destination_registers;
+        destination_memory = current_instr.destination_memory;
+        source_registers = current_instr.source_registers;
+        source_memory = current_instr.source_memory;
+    }
+
+    for (uint32_t i=0; i<MAX_INSTR_DESTINATIONS; i++) {
+        arch_instr->destination_registers[i] = destination_registers[i];
+        arch_instr->destination_memory[i] = destination_memory[i];
+    }
+
+    for (int i=0; i<NUM_INSTR_SOURCES; i++) {
+        arch_instr->source_registers[i] = source_registers[i];
+        arch_instr->source_memory[i] = source_memory[i];
+    }
+
+    finish_instr_decode(arch_instr);
+
+    return 1;
+}
+
+TRACE_READER::TRACE_READER(uint32_t cpu, const char *trace_name, TRACE_DECODER *decoder)
+    : cpu(cpu), trace_string(trace_name), decoder(decoder)
+{
+    ring = new TRACE_BATCH[TRACE_RING_SIZE];
+    current = NULL;
+    read_index = 0;
+    read_slot = 0;
+    write_slot = 0;
+    filled = 0;
+    stop = 0;
+    defer_repeats = 0;
+    unreported_repeats = 0;
+}
+
+TRACE_READER::~TRACE_READER()
+{
+    {
+        unique_lock<mutex> guard(lock);
+        stop = 1;
+    }
+    not_full.notify_one();
+    if (worker.joinable())
+        worker.join();
+
+    delete decoder;
+    delete[] ring;
+}
+
+void TRACE_READER::skip(uint64_t num_instrs)
+{
+    // the decoder belongs to the decode thread once it runs
+    assert(!worker.joinable());
+
+    uint64_t skipped = decoder->skip(num_instrs);
+    while (skipped < num_instrs) {
+        decoder->rewind();
+        print_repeat();
+
+        uint64_t count = decoder->skip(num_instrs - skipped);
+        if (count == 0) {
+            cerr << endl << "*** TRACE FILE IS EMPTY: " << trace_string << " ***" << endl;
+            assert(0);
+        }
+        skipped += count;
+    }
+}
+
+void TRACE_READER::start()
+{
+    worker = thread(&TRACE_READER::decode_loop, this);
+}
+
+void TRACE_READER::fill_batch(TRACE_BATCH *batch, uint8_t &repeat)
+{
+    batch->size = 0;
+    batch->repeat = repeat;
+    repeat = 0;
+
+    while (batch->size < TRACE_BATCH_SIZE) {
+        ooo_model_instr *arch_instr = &batch->instr[batch->size];
+        *arch_instr = ooo_model_instr();
+
+        if (decoder->decode_instr(arch_instr)) {
+            batch->size++;
+            continue;
+        }
+
+        // reached end of file for this trace
+        if ((batch->size == 0) && batch->repeat) {
+            cerr << endl << "*** TRACE FILE IS EMPTY: " << trace_string << " ***" << endl;
+            assert(0);
+        }
+        decoder->rewind();
+
+        // the core reports the repeat when it reaches this point of the trace
+        if (batch->size == 0)
+            batch->repeat = 1;
+        else {
+            repeat = 1;
+            break;
+        }
+    }
+}
+
+void TRACE_READER::decode_loop()
+{
+    uint8_t repeat = 0;
+
+    while (1) {
+        {
+            unique_lock<mutex> guard(lock);
+            not_full.wait(guard, [this]{ return stop || (filled < TRACE_RING_SIZE); });
+            if (stop)
+                return;
+        }
+
+        // the consumer never touches slots beyond read_slot+filled, so no lock is needed here
+        fill_batch(&ring[write_slot], repeat);
+        write_slot = (write_slot + 1) % TRACE_RING_SIZE;
+
+        {
+            unique_lock<mutex> guard(lock);
+            filled++;
+        }
+        not_empty.notify_one();
+    }
+}
+
+void TRACE_READER::next_batch()
+{
+    {
+        unique_lock<mutex> guard(lock);
+
+        // hand the consumed batch back to the decode thread
+        if (current) {
+            read_slot = (read_slot + 1) % TRACE_RING_SIZE;
+            filled--;
+            not_full.notify_one();
+        }
+
+        not_empty.wait(guard, [this]{ return filled > 0; });
+    }
+
+    current = &ring[read_slot];
+    read_index = 0;
+
+    if (current->repeat) {
+        // a core on its own thread would interleave its output with the main thread
+        if (defer_repeats)
+            unreported_repeats++;
+        else
+            print_repeat();
+    }
+}
+
+void TRACE_READER::report_repeats()
+{
+    for (; unreported_repeats; unreported_repeats--)
+        print_repeat();
+}
+
+void TRACE_READER::print_repeat()
+{
+    cout << "*** Reached end of trace for Core: " << cpu << " Repeating trace: " << trace_string << endl;
+}
+
+TRACE_READER *open_trace_reader(uint32_t cpu, const char *trace_name, uint8_t cloudsuite)
+{
+    TRACE_DECODER *decoder;
+    if (is_compact_trace(trace_name))
+        decoder = new COMPACT_TRACE_DECODER(cpu, trace_name, cloudsuite);
+    else
+        decoder = new LEGACY_TRACE_DECODER(cpu, trace_name, cloudsuite);
+
+    return new TRACE_READER(cpu, trace_name, decoder);
+}
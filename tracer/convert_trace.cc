@@ -0,0 +1,108 @@
+/*! @file
+ *  Converts a legacy ChampSim trace (a raw, gzip, xz or zstd stream of
+ *  input_instr records) into the compact, indexed trace format
+ *  described in inc/compact_trace.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <iostream>
+
+#include "compact_trace.h"
+
+using namespace std;
+
+// needed by the legacy trace decoder
+uint8_t MAX_INSTR_DESTINATIONS = NUM_INSTR_DESTINATIONS;
+
+void usage(char *name)
+{
+    cerr << "Usage: " << name << " [-c] [-z none|zlib|zstd] [-b block_size] <input trace> <output trace>" << endl
+        << "  -c  input is a cloudsuite trace" << endl
+        << "  -z  block compression (default: zlib)" << endl
+        << "  -b  instructions per block (default: " << COMPACT_TRACE_BLOCK_SIZE << ")" << endl;
+    exit(1);
+}
+
+uint64_t file_size(const char *name)
+{
+    struct stat st;
+    if (stat(name, &st))
+        return 0;
+    return st.st_size;
+}
+
+int main(int argc, char** argv)
+{
+    uint8_t cloudsuite = 0,
+            codec = COMPACT_TRACE_CODEC_ZLIB;
+    uint32_t block_size = COMPACT_TRACE_BLOCK_SIZE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "cz:b:")) != -1) {
+        if (opt == 'c')
+            cloudsuite = 1;
+        else if (opt == 'z') {
+            if (!strcmp(optarg, "none"))
+                codec = COMPACT_TRACE_CODEC_NONE;
+            else if (!strcmp(optarg, "zlib"))
+                codec = COMPACT_TRACE_CODEC_ZLIB;
+            else if (!strcmp(optarg, "zstd"))
+                codec = COMPACT_TRACE_CODEC_ZSTD;
+            else
+                usage(argv[0]);
+        }
+        else if (opt == 'b')
+            block_size = atoi(optarg);
+        else
+            usage(argv[0]);
+    }
+    if ((argc - optind != 2) || (block_size == 0))
+        usage(argv[0]);
+
+    if (cloudsuite)
+        MAX_INSTR_DESTINATIONS = NUM_INSTR_DESTINATIONS_SPARC;
+
+    TRACE_STREAM *input = open_trace_stream(argv[optind]);
+    COMPACT_TRACE_WRITER output(argv[optind+1], cloudsuite, codec, block_size);
+
+    uint64_t num_instrs = 0;
+    while (1) {
+        cloudsuite_instr instr;
+        if (cloudsuite) {
+            if (!input->read_all(&instr, sizeof(cloudsuite_instr)))
+                break;
+        }
+        else {
+            input_instr legacy_instr;
+            if (!input->read_all(&legacy_instr, sizeof(input_instr)))
+                break;
+
+            instr.ip = legacy_instr.ip;
+            instr.is_branch = legacy_instr.is_branch;
+            instr.branch_taken = legacy_instr.branch_taken;
+            for (uint32_t i=0; i<NUM_INSTR_DESTINATIONS; i++) {
+                instr.destination_registers[i] = legacy_instr.destination_registers[i];
+                instr.destination_memory[i] = legacy_instr.destination_memory[i];
+            }
+            for (uint32_t i=0; i<NUM_INSTR_SOURCES; i++) {
+                instr.source_registers[i] = legacy_instr.source_registers[i];
+                instr.source_memory[i] = legacy_instr.source_memory[i];
+            }
+        }
+
+        output.write_instr(instr);
+        num_instrs++;
+    }
+    output.close();
+    delete input;
+
+    cout << "instructions " << num_instrs << endl
+        << "input_bytes " << file_size(argv[optind]) << endl
+        << "output_bytes " << file_size(argv[optind+1]) << endl;
+
+    return 0;
+}
@@ -0,0 +1,8 @@
+# builds bin/convert_trace, which converts legacy traces to the compact trace format
+cd "$(dirname "$0")/.."
+ZSTD_FLAGS=""
+if [ -f /usr/include/zstd.h ]; then
+    ZSTD_FLAGS="-DENABLE_ZSTD -lzstd"
+fi
+mkdir -p bin
+g++ -Wall -O3 -std=c++11 -pthread -Iinc tracer/convert_trace.cc src/compact_trace.cc src/trace_reader.cc -o bin/convert_trace -lz -llzma $ZSTD_FLAGS